@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+# Compara as tabelas SINR->BLER (salvas por Packet5G --blerTable=<arquivo>) com o
+# TBler calculado pelo modelo de erro MI nas saídas da varredura static-user.
+#
+# uso: python3 BlerTable-validacao.py <arquivo da tabela> [diretório da varredura]
+import glob
+import os
+import sys
+import numpy as np
+import pandas as pd
+
+
+def carregar_tabela(caminho):
+    # cada linha: mcs, log2 do tamanho do TB (bytes), SINR mínimo, passo, BLER...
+    tabela = {}
+    with open(caminho) as f:
+        next(f)
+        for linha in f:
+            campos = linha.split()
+            mcs, log2_tam = int(campos[0]), int(campos[1])
+            sinr_min, passo = float(campos[2]), float(campos[3])
+            tabela[(mcs, log2_tam)] = (sinr_min, passo, np.array(campos[4:], dtype=float))
+    return tabela
+
+
+def bler_tabela(tabela, mcs, tb_size, sinr_db):
+    # mesma interpolação bilinear (SINR, log2 do tamanho) de MmWaveBlerTable::GetBler
+    log2_tam = np.clip(np.log2(max(tb_size, 1)), 3, 20)
+    inferior = int(np.floor(log2_tam))
+    superior = min(inferior + 1, 20)
+    w = log2_tam - inferior
+    valores = []
+    for chave in ((mcs, inferior), (mcs, superior)):
+        if chave not in tabela:
+            return np.nan
+        sinr_min, passo, linha = tabela[chave]
+        x = np.arange(len(linha)) * passo + sinr_min
+        valores.append(np.interp(sinr_db, x, linha))
+    return (1 - w) * valores[0] + w * valores[1]
+
+
+def validar(tabela, diretorio):
+    resultados = []
+    # o nome do trace varia entre as rodadas: RxPacketTrace.txt, RxPacketTrace100Ghz.txt,
+    # RxPacketTrace-100Ghz.txt...
+    for arquivo in sorted(glob.glob(os.path.join(diretorio, '*', 'RxPacketTrace*.txt'))):
+        pasta = os.path.basename(os.path.dirname(arquivo))
+        df = pd.read_csv(arquivo, sep=None, engine='python')
+        df = df[df['rv'] == 0]  # retransmissões HARQ combinam informação mútua: fora da tabela
+        df = df.assign(tabela=[bler_tabela(tabela, m, t, s) for m, t, s in
+                               zip(df['mcs'], df['tbSize'], df['SINR(dB)'])])
+        df = df.dropna(subset=['tabela'])
+        if df.empty:
+            continue
+        erro = (df['tabela'] - df['TBler']).abs()
+        resultados.append({'cenario': pasta, 'arquivo': os.path.basename(arquivo),
+                           'nTb': len(df),
+                           'erroMedio': erro.mean(), 'erroMax': erro.max()})
+    return pd.DataFrame(resultados)
+
+
+if __name__ == '__main__':
+    if len(sys.argv) < 2:
+        print('uso: BlerTable-validacao.py <tabela> [diretório]')
+        sys.exit(1)
+    diretorio = sys.argv[2] if len(sys.argv) > 2 else 'Simulações/static-user'
+    print(validar(carregar_tabela(sys.argv[1]), diretorio).to_string(index=False))
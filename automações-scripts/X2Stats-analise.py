@@ -1,12 +1,24 @@
 #%%
+import os
 import pandas as pd 
 import numpy as np
 import matplotlib.pyplot as plt
 #%%
-# Importando os dados
-df = pd.read_csv("X2Stats.csv", sep=';') 
-df.head() #nao sabemos que é 'arrumar' coloquei arbritariamente
+# Importando os dados: X2EpochStats.csv (agregado por época, enlace e tipo) ou
+# X2Stats.csv (uma linha por mensagem, com x2StatsEpoch=0)
+if os.path.exists("X2EpochStats.csv"):
+    df = pd.read_csv("X2EpochStats.csv", sep=';')
+    df = df.rename(columns={'sourceCellId': 'SourceCellId', 'targetCellId': 'TargetCellId'})
+else:
+    df = pd.read_csv("X2Stats.csv", sep=';')
+    df['messages'] = 1
+    df = df.rename(columns={'size': 'bytes'})
+df.head() # isData: 1 para dados (X2-U), 0 para controle (X2-C)
 
 # %%
-df['TargetCellId'].value_counts()
+# mensagens por célula de destino
+df.groupby('TargetCellId')['messages'].sum()
+# %%
+# mensagens e bytes por enlace e tipo
+df.groupby(['SourceCellId', 'TargetCellId', 'isData'])[['messages', 'bytes']].sum()
 # %%
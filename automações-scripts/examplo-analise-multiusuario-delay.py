@@ -2,7 +2,15 @@
 import pandas as pd
 import matplotlib.pyplot as plt
 import numpy as np
-df = pd.read_csv('DlRlcStats.csv', usecols=['% start', 'RNTI', 'delay'], sep=';')
+import os
+import trace_index
+# Valores de RNTI de 1 a 10
+rnti_values = range(1, 11)
+# Com o trace-index compilado, só os trechos do DlRlcStats.txt desses usuários são lidos
+if os.path.exists(trace_index.TRACE_INDEX):
+    df = trace_index.query('DlRlcStats.txt', RNTI=list(rnti_values))[['% start', 'RNTI', 'delay']]
+else:
+    df = pd.read_csv('DlRlcStats.csv', usecols=['% start', 'RNTI', 'delay'], sep=';')
 
 # Função para filtrar DataFrame por RNTI e preparar dados para plotagem
 def filter_and_prepare_data(df, rnti_values):
@@ -11,8 +19,6 @@ def filter_and_prepare_data(df, rnti_values):
     delays = {rnti: np.where(filtered_dfs[rnti]['delay'] == 0, np.nan, filtered_dfs[rnti]['delay']) for rnti in rnti_values}
     return times, delays
 
-# Valores de RNTI de 1 a 10
-rnti_values = range(1, 11)
 times, delays = filter_and_prepare_data(df, rnti_values)
 
 # Plotando os gráficos
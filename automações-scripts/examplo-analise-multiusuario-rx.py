@@ -1,12 +1,25 @@
 import pandas as pd
 import matplotlib.pyplot as plt
-df = pd.read_csv('RxPacketTrace.txt', sep='\s+', usecols=['DL/UL', 'time', 'rnti', 'SINR(dB)'])
+import os
+import trace_index
+# Janela de tempo (s) e usuários a plotar; com o trace-index compilado, só os
+# trechos do trace com essas linhas são lidos
+t_from, t_to = None, None
+rnti_values = range(1, 11)  # p/ 10 usuaŕios
+if os.path.exists(trace_index.TRACE_INDEX):
+    df = trace_index.query('RxPacketTrace.txt', t_from, t_to, rnti=list(rnti_values))
+    df = df[['DL/UL', 'time', 'rnti', 'SINR(dB)']]
+else:
+    df = pd.read_csv('RxPacketTrace.txt', sep='\s+', usecols=['DL/UL', 'time', 'rnti', 'SINR(dB)'])
+    if t_from is not None:
+        df = df[df['time'] >= t_from]
+    if t_to is not None:
+        df = df[df['time'] <= t_to]
 # Função para filtrar DataFrame por rnti
 def filter_by_rnti(df, rnti_values):
     return {rnti: df[df['rnti'] == rnti] for rnti in rnti_values}
 
 # Exemplo de uso
-rnti_values = range(1, 11)  # p/ 10 usuaŕios
 filtered_dfs = filter_by_rnti(df, rnti_values)
 # Plotando os gráficos
 plt.figure(figsize=(10, 6))
@@ -1,4 +1,5 @@
 #%%
+import os
 import pandas as pd
 
 def process_file(input_file, output_file, column_names):
@@ -14,7 +15,14 @@ def process_file(input_file, output_file, column_names):
 CellIdStats = process_file('CellIdStats.txt', 'CellIdStats.csv', ['Time', 'IMSI', 'CellId', 'RNTI'])
 MmWaveSinrTime = process_file('MmWaveSinrTime.txt', 'MmWaveSinrTime.csv', ['Time', 'IMSI', 'CellId', "SINR[dB]"])
 MmWaveSwitchStats = process_file('MmWaveSwitchStats.txt', 'MmWaveSwitchStats.csv', ['Text', 'Time', 'IMSI', 'CellId', "RNTI"])
-X2Stats = process_file('X2Stats.txt','X2Stats.csv', ['Time', 'SourceCellId', 'TargetCellId', 'size', 'delay', 'arrumar'])
+# X2Stats.txt (mc-twoenbs com x2StatsEpoch=0): uma linha por mensagem; a última coluna é
+# 1 para dados (X2-U) e 0 para controle (X2-C)
+if os.path.exists('X2Stats.txt'):
+    X2Stats = process_file('X2Stats.txt','X2Stats.csv', ['Time', 'SourceCellId', 'TargetCellId', 'size', 'delay', 'isData'])
+else:
+    # X2EpochStats.txt: mensagens agregadas por época, enlace e tipo, já com cabeçalho
+    X2Stats = pd.read_csv('X2EpochStats.txt', sep='\t', comment='#')
+    X2Stats.to_csv('X2EpochStats.csv', sep=';', index=False)
 # Exibir os DataFrames
 print(CellIdStats.head())
 print(MmWaveSinrTime.head())
@@ -0,0 +1,618 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Comparison of two arms of runs, e.g. the original and the optimized user
+ * positions (original_user_data and optmized_user_data), in place of loading
+ * and joining their DlRlcStats in pandas.
+ *
+ * The DlRlcStats.txt of every run directory (any number per arm, e.g. the
+ * replications of every arm) is read line by line, the runs in parallel, into
+ * the received bytes, PDUs and PDU weighted delay of every IMSI and epoch, over
+ * the data radio bearers (LCID >= 3, all with --allLcids). A run is reduced
+ * to its totals as soon as it is read and its epochs added to the running
+ * moments of its arm, so the memory does not grow with the replications. Per
+ * IMSI, and for all the IMSIs, the report has for the throughput and the delay:
+ *
+ * - the mean of each arm and the difference, absolute and relative;
+ * - over the epochs, the arm means aligned by epoch, as a description of how
+ *   the difference evolves: their Pearson correlation, the standard deviation
+ *   of their differences and the share of the epochs where B is above A. The
+ *   epochs of a run are autocorrelated (queues, mobility, channel), so they are
+ *   not independent samples and no test is made on them;
+ * - over the runs, with at least two per arm: the Welch t test of the run
+ *   means, or with --paired the paired t test, the runs paired in the order
+ *   given. Only pass --paired when the replications of both arms share their
+ *   random numbers (the same seed and run number per pair); as many runs per
+ *   arm does not make them paired. This is the only significance test of the
+ *   report, and the header names it.
+ *
+ * g++ -O2 -std=c++17 -pthread run-compare.cc -o run-compare
+ * ./run-compare [--threads=N] [--epoch=0.25] [--trace=DlRlcStats.txt] [--allLcids]
+ *               [--paired] [--out=RunCompare.txt] <runs of arm A>... -- <runs of arm B>...
+ */
+
+#include "trace-number.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+/// The data of an IMSI in an epoch of a run
+struct Cell
+{
+    uint64_t rxBytes{0};
+    uint64_t rxPdus{0};
+    double delaySum{0}; //!< delay times PDUs
+};
+
+/// Mean and sample variance
+struct Moments
+{
+    uint64_t n{0};
+    double mean{0};
+    double m2{0};
+
+    void Add(double x)
+    {
+        ++n;
+        double d = x - mean;
+        mean += d / n;
+        m2 += d * (x - mean);
+    }
+
+    double Variance() const
+    {
+        return n > 1 ? m2 / (n - 1) : NAN;
+    }
+};
+
+const int IMSI_ALL = -1;
+
+enum Metric
+{
+    THROUGHPUT,
+    DELAY
+};
+
+const char* g_metricNames[] = {"throughput(Mbps)", "delay(ms)"};
+
+/// The value of a metric over some cells, NAN if undefined
+struct Accumulator
+{
+    uint64_t rxBytes{0};
+    uint64_t rxPdus{0};
+    double delaySum{0};
+
+    void Add(const Cell& c)
+    {
+        rxBytes += c.rxBytes;
+        rxPdus += c.rxPdus;
+        delaySum += c.delaySum;
+    }
+
+    double Get(Metric metric, double seconds) const
+    {
+        if (metric == THROUGHPUT)
+        {
+            return seconds > 0 ? rxBytes * 8e-6 / seconds : NAN;
+        }
+        return rxPdus > 0 ? delaySum / rxPdus * 1e3 : NAN;
+    }
+};
+
+/// A run, reduced to its totals once read
+struct Run
+{
+    std::string directory;
+    std::map<int64_t, Accumulator> totals; //!< by IMSI, and IMSI_ALL
+    double epoch{0};
+    double duration{0}; //!< end of the last epoch
+    uint64_t lines{0};
+    uint64_t malformed{0};
+    bool ok{false};
+};
+
+/// The runs of an arm, by IMSI (and IMSI_ALL), by epoch, the moments of every metric
+struct Arm
+{
+    std::vector<Run*> runs;
+    std::map<int64_t, std::map<int64_t, std::array<Moments, 2>>> series;
+    std::mutex mutex;
+};
+
+/**
+ * Read the RLC statistics of a run, and add its epochs to the series of its arm
+ * \param run its epoch is the one of the alignment, 0 to use the one of the trace
+ */
+void
+ReadRun(const std::string& path, bool allLcids, Run& run, Arm& arm)
+{
+    std::map<int64_t, std::map<int64_t, Cell>> imsis;
+    double& epoch = run.epoch;
+    FILE* f = std::fopen(path.c_str(), "r");
+    if (!f)
+    {
+        std::perror(path.c_str());
+        return;
+    }
+    char line[4096];
+    // up to the delay, the columns after it are not used
+    double fields[11];
+    while (std::fgets(line, sizeof(line), f))
+    {
+        const char* p = line;
+        const char* eol = p + std::strlen(p);
+        int n = 0;
+        while (n < 11)
+        {
+            while (p < eol && (IsSpace(*p) || *p == '\n'))
+            {
+                ++p;
+            }
+            const char* token = p;
+            while (p < eol && !IsSpace(*p) && *p != '\n')
+            {
+                ++p;
+            }
+            if (p == token || !ParseNumber(token, p, fields[n]))
+            {
+                break;
+            }
+            ++n;
+        }
+        if (n < 11)
+        {
+            // the column names, starting with '%', or an empty line
+            if (line[0] != '%' && line[0] != '\n')
+            {
+                ++run.malformed;
+            }
+            continue;
+        }
+        ++run.lines;
+        double start = fields[0];
+        double end = fields[1];
+        if (!allLcids && fields[5] < 3)
+        {
+            continue;
+        }
+        if (epoch <= 0)
+        {
+            epoch = end - start;
+        }
+        Cell& c = imsis[int64_t(fields[3])][std::llround(start / epoch)];
+        c.rxBytes += uint64_t(fields[9]);
+        c.rxPdus += uint64_t(fields[8]);
+        c.delaySum += fields[10] * fields[8];
+        run.duration = std::max(run.duration, end);
+    }
+    std::fclose(f);
+
+    std::map<int64_t, Accumulator> all;
+    for (const auto& u : imsis)
+    {
+        for (const auto& e : u.second)
+        {
+            run.totals[u.first].Add(e.second);
+            run.totals[IMSI_ALL].Add(e.second);
+            all[e.first].Add(e.second);
+        }
+    }
+    std::lock_guard<std::mutex> lock(arm.mutex);
+    auto add = [&arm, epoch](int64_t imsi, int64_t e, const Accumulator& acc) {
+        for (int m = THROUGHPUT; m <= DELAY; ++m)
+        {
+            double v = acc.Get(Metric(m), epoch);
+            if (!std::isnan(v))
+            {
+                arm.series[imsi][e][m].Add(v);
+            }
+        }
+    };
+    for (const auto& u : imsis)
+    {
+        for (const auto& e : u.second)
+        {
+            Accumulator acc;
+            acc.Add(e.second);
+            add(u.first, e.first, acc);
+        }
+    }
+    for (const auto& e : all)
+    {
+        add(IMSI_ALL, e.first, e.second);
+    }
+    run.ok = true;
+}
+
+/// Continued fraction of the regularized incomplete beta function
+double
+BetaContinuedFraction(double a, double b, double x)
+{
+    const double tiny = 1e-300;
+    double c = 1;
+    double d = 1 - (a + b) * x / (a + 1);
+    d = 1 / (std::fabs(d) < tiny ? tiny : d);
+    double h = d;
+    for (int m = 1; m <= 300; ++m)
+    {
+        for (int k = 0; k < 2; ++k)
+        {
+            double num = k == 0 ? m * (b - m) * x / ((a + 2 * m - 1) * (a + 2 * m))
+                                : -(a + m) * (a + b + m) * x / ((a + 2 * m) * (a + 2 * m + 1));
+            d = 1 + num * d;
+            d = 1 / (std::fabs(d) < tiny ? tiny : d);
+            c = 1 + num / c;
+            c = std::fabs(c) < tiny ? tiny : c;
+            h *= d * c;
+            if (k == 1 && std::fabs(d * c - 1) < 1e-12)
+            {
+                return h;
+            }
+        }
+    }
+    return h;
+}
+
+/// \return the two sided p value of a t statistic with dof degrees of freedom
+double
+StudentPValue(double t, double dof)
+{
+    if (!std::isfinite(t) || dof <= 0)
+    {
+        return std::isinf(t) ? 0 : NAN;
+    }
+    // P(|T| > |t|) = I_x(dof / 2, 1 / 2), x = dof / (dof + t^2)
+    double x = dof / (dof + t * t);
+    double a = dof / 2;
+    double b = 0.5;
+    double front = std::exp(std::lgamma(a + b) - std::lgamma(a) - std::lgamma(b) +
+                            a * std::log(x) + b * std::log1p(-x));
+    if (x < (a + 1) / (a + b + 2))
+    {
+        return front * BetaContinuedFraction(a, b, x) / a;
+    }
+    return 1 - front * BetaContinuedFraction(b, a, 1 - x) / b;
+}
+
+/// A t test: the statistic, its degrees of freedom and the p value
+struct TTest
+{
+    double t{NAN};
+    double dof{NAN};
+    double p{NAN};
+};
+
+/// Paired t test of the differences b - a
+TTest
+PairedTTest(const std::vector<double>& a, const std::vector<double>& b)
+{
+    Moments d;
+    for (std::size_t i = 0; i < a.size(); ++i)
+    {
+        d.Add(b[i] - a[i]);
+    }
+    TTest test;
+    if (d.n < 2)
+    {
+        return test;
+    }
+    test.dof = d.n - 1;
+    double se = std::sqrt(d.Variance() / d.n);
+    test.t = se > 0 ? d.mean / se : (d.mean == 0 ? NAN : std::copysign(INFINITY, d.mean));
+    test.p = StudentPValue(test.t, test.dof);
+    return test;
+}
+
+/// Welch t test of mean(b) - mean(a)
+TTest
+WelchTTest(const Moments& a, const Moments& b)
+{
+    TTest test;
+    if (a.n < 2 || b.n < 2)
+    {
+        return test;
+    }
+    double va = a.Variance() / a.n;
+    double vb = b.Variance() / b.n;
+    double se = std::sqrt(va + vb);
+    double diff = b.mean - a.mean;
+    test.t = se > 0 ? diff / se : (diff == 0 ? NAN : std::copysign(INFINITY, diff));
+    test.dof = (va + vb) * (va + vb) / (va * va / (a.n - 1) + vb * vb / (b.n - 1));
+    test.p = StudentPValue(test.t, test.dof);
+    return test;
+}
+
+/// Pearson correlation of two series of the same length
+double
+Correlation(const std::vector<double>& a, const std::vector<double>& b)
+{
+    Moments ma;
+    Moments mb;
+    for (std::size_t i = 0; i < a.size(); ++i)
+    {
+        ma.Add(a[i]);
+        mb.Add(b[i]);
+    }
+    double cov = 0;
+    for (std::size_t i = 0; i < a.size(); ++i)
+    {
+        cov += (a[i] - ma.mean) * (b[i] - mb.mean);
+    }
+    double den = std::sqrt(ma.m2 * mb.m2);
+    return a.size() > 1 && den > 0 ? cov / den : NAN;
+}
+
+/// One line of the report
+void
+Compare(std::ostream& out, const Arm& a, const Arm& b, int64_t imsi, Metric metric, bool paired)
+{
+    // the metric of every run over the whole run, NAN if it has not the IMSI; the
+    // throughput of all the IMSIs is the one of the cell
+    Moments runsA;
+    Moments runsB;
+    std::vector<double> valuesA;
+    std::vector<double> valuesB;
+    for (int k = 0; k < 2; ++k)
+    {
+        for (const Run* run : (k == 0 ? a : b).runs)
+        {
+            auto it = run->totals.find(imsi);
+            double v = it == run->totals.end() ? NAN : it->second.Get(metric, run->duration);
+            (k == 0 ? valuesA : valuesB).push_back(v);
+            if (!std::isnan(v))
+            {
+                (k == 0 ? runsA : runsB).Add(v);
+            }
+        }
+    }
+
+    // the epochs of both arms, the mean of each arm
+    std::vector<double> epochsA;
+    std::vector<double> epochsB;
+    auto sa = a.series.find(imsi);
+    auto sb = b.series.find(imsi);
+    if (sa != a.series.end() && sb != b.series.end())
+    {
+        for (const auto& e : sa->second)
+        {
+            auto it = sb->second.find(e.first);
+            if (e.second[metric].n > 0 && it != sb->second.end() && it->second[metric].n > 0)
+            {
+                epochsA.push_back(e.second[metric].mean);
+                epochsB.push_back(it->second[metric].mean);
+            }
+        }
+    }
+    Moments epochDelta;
+    std::size_t epochsBAbove = 0;
+    for (std::size_t i = 0; i < epochsA.size(); ++i)
+    {
+        epochDelta.Add(epochsB[i] - epochsA[i]);
+        epochsBAbove += epochsB[i] > epochsA[i];
+    }
+
+    TTest runTest;
+    const char* runTestName = "-";
+    if (paired && a.runs.size() > 1)
+    {
+        // runs without the IMSI are left out of the pairs
+        std::vector<double> pa;
+        std::vector<double> pb;
+        for (std::size_t i = 0; i < valuesA.size(); ++i)
+        {
+            if (!std::isnan(valuesA[i]) && !std::isnan(valuesB[i]))
+            {
+                pa.push_back(valuesA[i]);
+                pb.push_back(valuesB[i]);
+            }
+        }
+        runTest = PairedTTest(pa, pb);
+        runTestName = "paired";
+    }
+    else if (a.runs.size() > 1 && b.runs.size() > 1)
+    {
+        runTest = WelchTTest(runsA, runsB);
+        runTestName = "welch";
+    }
+
+    double delta = runsB.mean - runsA.mean;
+    out << (imsi == IMSI_ALL ? std::string("all") : std::to_string(imsi)) << "\t"
+        << g_metricNames[metric] << "\t" << runsA.mean << "\t" << runsB.mean << "\t" << delta
+        << "\t" << (runsA.mean != 0 ? 100 * delta / runsA.mean : NAN) << "\t"
+        << std::sqrt(runsA.Variance()) << "\t" << std::sqrt(runsB.Variance()) << "\t"
+        << epochsA.size() << "\t" << Correlation(epochsA, epochsB) << "\t"
+        << std::sqrt(epochDelta.Variance()) << "\t"
+        << (epochsA.empty() ? NAN : 100.0 * epochsBAbove / epochsA.size()) << "\t"
+        << runTestName << "\t" << runTest.t << "\t" << runTest.dof << "\t" << runTest.p << "\n";
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+    unsigned nThreads = std::max(1u, std::thread::hardware_concurrency());
+    double epoch = 0;
+    std::string trace = "DlRlcStats.txt";
+    std::string out = "RunCompare.txt";
+    bool allLcids = false;
+    bool paired = false;
+    std::vector<std::string> arms[2];
+    int arm = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg.rfind("--threads=", 0) == 0)
+        {
+            nThreads = std::max(1, std::atoi(arg.c_str() + 10));
+        }
+        else if (arg.rfind("--epoch=", 0) == 0)
+        {
+            epoch = std::atof(arg.c_str() + 8);
+        }
+        else if (arg.rfind("--trace=", 0) == 0)
+        {
+            trace = arg.substr(8);
+        }
+        else if (arg.rfind("--out=", 0) == 0)
+        {
+            out = arg.substr(6);
+        }
+        else if (arg == "--allLcids")
+        {
+            allLcids = true;
+        }
+        else if (arg == "--paired")
+        {
+            paired = true;
+        }
+        else if (arg == "--" && arm == 0)
+        {
+            arm = 1;
+        }
+        else if (arg.rfind("--", 0) != 0)
+        {
+            arms[arm].push_back(arg);
+        }
+        else
+        {
+            arm = -1;
+            break;
+        }
+    }
+    if (arm != 1 || arms[0].empty() || arms[1].empty())
+    {
+        std::cerr << "usage: " << argv[0]
+                  << " [--threads=N] [--epoch=s] [--trace=DlRlcStats.txt] [--allLcids]"
+                     " [--paired] [--out=RunCompare.txt] <runs A>... -- <runs B>..."
+                  << std::endl;
+        return 1;
+    }
+    if (paired && arms[0].size() != arms[1].size())
+    {
+        std::cerr << "--paired needs as many runs in both arms, not " << arms[0].size()
+                  << " and " << arms[1].size() << std::endl;
+        return 1;
+    }
+
+    // the runs of both arms, read by a pool of threads
+    std::vector<Run> runs(arms[0].size() + arms[1].size());
+    Arm a;
+    Arm b;
+    for (std::size_t r = 0; r < runs.size(); ++r)
+    {
+        bool first = r < arms[0].size();
+        runs[r].directory = first ? arms[0][r] : arms[1][r - arms[0].size()];
+        runs[r].epoch = epoch;
+        (first ? a : b).runs.push_back(&runs[r]);
+    }
+    std::atomic<std::size_t> next{0};
+    auto worker = [&]() {
+        for (std::size_t r = next++; r < runs.size(); r = next++)
+        {
+            ReadRun(runs[r].directory + "/" + trace, allLcids, runs[r], r < arms[0].size() ? a : b);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < std::min<std::size_t>(nThreads, runs.size()); ++t)
+    {
+        threads.emplace_back(worker);
+    }
+    for (std::thread& t : threads)
+    {
+        t.join();
+    }
+
+    std::map<int64_t, bool> imsis;
+    uint64_t malformed = 0;
+    for (const Run& run : runs)
+    {
+        if (!run.ok)
+        {
+            return 1;
+        }
+        if (epoch <= 0 && run.epoch > 0)
+        {
+            epoch = run.epoch;
+        }
+        else if (run.epoch > 0 && std::fabs(run.epoch - epoch) > 1e-9)
+        {
+            std::cerr << run.directory << ": epoch of " << run.epoch << " s, not " << epoch
+                      << " s; set --epoch" << std::endl;
+            return 1;
+        }
+        for (const auto& u : run.totals)
+        {
+            if (u.first != IMSI_ALL)
+            {
+                imsis[u.first] = true;
+            }
+        }
+        malformed += run.malformed;
+    }
+
+    std::ofstream report(out);
+    report << "# A: " << a.runs.size() << " runs (" << arms[0].front() << " ...), B: "
+           << b.runs.size() << " runs (" << arms[1].front() << " ...), " << trace << ", epoch "
+           << epoch << " s" << (allLcids ? ", all LCIDs" : ", LCID >= 3") << "\n";
+    if (a.runs.size() < 2 || b.runs.size() < 2)
+    {
+        report << "# run test: none, less than two runs in an arm\n";
+    }
+    else if (paired)
+    {
+        report << "# run test: paired t test, the runs paired in the order given\n";
+    }
+    else
+    {
+        report << "# run test: Welch t test, the runs of the arms independent\n";
+    }
+    if (malformed > 0)
+    {
+        report << "# " << malformed << " malformed lines skipped\n";
+    }
+    report << "IMSI\tmetric\tmeanA\tmeanB\tdelta\tdelta(%)\tstdDevRunsA\tstdDevRunsB\tepochs"
+              "\tepochCorrelation\tepochDeltaStdDev\tepochsBAbove(%)"
+              "\trunTest\trunT\trunDof\trunP\n";
+    for (int m = THROUGHPUT; m <= DELAY; ++m)
+    {
+        for (const auto& imsi : imsis)
+        {
+            Compare(report, a, b, imsi.first, Metric(m), paired);
+        }
+        Compare(report, a, b, IMSI_ALL, Metric(m), paired);
+    }
+    std::cerr << runs.size() << " runs, " << imsis.size() << " IMSIs compared in " << out
+              << std::endl;
+    return 0;
+}
@@ -0,0 +1,57 @@
+#!/bin/bash
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License version 2 as
+# published by the Free Software Foundation;
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#
+#  Compare the wall clock time of the txt -> csv conversion of the traces of a
+#  directory with pandas (as headers.py and txt-csv.py) and with trace-analyzer,
+#  with one thread and with all the cores.
+#
+#  $ bash trace-analyzer-benchmark.sh <directory with the traces>
+#
+
+DIR=${1:?usage: $0 <directory>}
+RUNS=${RUNS:-3}
+OUT=${OUT:-trace-analyzer-benchmark.txt}
+HERE=$(dirname "$(readlink -f "$0")")
+
+g++ -O2 -std=c++17 -pthread "$HERE/trace-analyzer.cc" -o "$HERE/trace-analyzer" || exit 1
+
+PANDAS='
+import glob, os, sys
+import pandas as pd
+for f in glob.glob(os.path.join(sys.argv[1], "*.txt")):
+    name = os.path.basename(f)
+    if name.startswith(("RxPacketTrace", "DlRlcStats", "UlRlcStats", "DlPdcpStats",
+                        "UlPdcpStats", "CellIdStats", "MmWaveSinrTime", "X2Stats")):
+        skip = 1 if name.startswith(("Rx", "Dl", "Ul")) else 0
+        df = pd.read_csv(f, delimiter=r"\s+", header=None, skiprows=skip)
+        df.to_csv(os.path.join(sys.argv[2], name[:-4] + ".csv"), sep=";", index=False)
+'
+
+echo -e "tool\tthreads\trun\twall(s)" | tee $OUT
+for run in $(seq 1 $RUNS); do
+    tmp=$(mktemp -d)
+    start=$(date +%s.%N)
+    python3 -c "$PANDAS" "$DIR" "$tmp" || exit 1
+    wall=$(echo "$(date +%s.%N) - $start" | bc)
+    echo -e "pandas\t1\t$run\t$wall" | tee -a $OUT
+    for threads in 1 $(nproc); do
+        start=$(date +%s.%N)
+        "$HERE/trace-analyzer" --threads=$threads --out="$tmp/analysis" --csv "$DIR" > /dev/null
+        wall=$(echo "$(date +%s.%N) - $start" | bc)
+        echo -e "trace-analyzer\t$threads\t$run\t$wall" | tee -a $OUT
+    done
+    rm -rf $tmp
+done
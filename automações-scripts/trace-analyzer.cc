@@ -0,0 +1,678 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Analyzer of the trace files of the mmWave scenarios, in place of the
+ * txt -> csv pandas chain (txt-csv.py, headers.py, headers-otimizado.py).
+ *
+ * Every known trace of the directory (RxPacketTrace, DlRlcStats, UlRlcStats,
+ * DlPdcpStats, UlPdcpStats, CellIdStats, MmWaveSinrTime, X2Stats, with any
+ * suffix) is memory mapped and split into chunks at line boundaries, parsed in
+ * parallel into typed columns. Then, without reading the files again:
+ *
+ * - <out>/<trace>/<column>.bin: every column as a raw little endian array of
+ *   int64 or float64 (numpy.fromfile(path, dtype='<i8' or '<f8')), described by
+ *   <out>/<trace>/schema.txt (name, type, rows);
+ * - <out>/<trace>.csv, with --csv: the same columns, ';' separated, with the
+ *   column names of headers.py;
+ * - <out>/ImsiSummary.txt: per IMSI, the TBs, bytes, corrupted fraction and
+ *   mean SINR of RxPacketTrace in downlink and uplink, the RLC and PDCP bytes
+ *   and mean delays, the mean SINR of MmWaveSinrTime and the cell changes of
+ *   CellIdStats. The RxPacketTrace lines only have the cell and the RNTI; the
+ *   IMSI is the one the cell had given the RNTI to by then, from CellIdStats or
+ *   the RLC and PDCP statistics.
+ *
+ * g++ -O2 -std=c++17 -pthread trace-analyzer.cc -o trace-analyzer
+ * ./trace-analyzer [--threads=N] [--out=analysis] [--csv] <directory>
+ */
+
+#include "trace-number.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+
+enum ColumnType
+{
+    I64,
+    F64
+};
+
+/// A column of a trace
+struct ColumnSpec
+{
+    const char* name;
+    ColumnType type;
+};
+
+/// The layout of a kind of trace
+struct TraceSpec
+{
+    const char* prefix; //!< the file name starts with it
+    std::vector<ColumnSpec> columns;
+};
+
+const std::vector<ColumnSpec> g_rlcPdcpColumns = {
+    {"start", F64},        {"end", F64},         {"CellId", I64},       {"IMSI", I64},
+    {"RNTI", I64},         {"LCID", I64},        {"nTxPDUs", I64},      {"TxBytes", I64},
+    {"nRxPDUs", I64},      {"RxBytes", I64},     {"delay", F64},        {"delayStdDev", F64},
+    {"delayMin", F64},     {"delayMax", F64},    {"PduSize", F64},      {"PduSizeStdDev", F64},
+    {"PduSizeMin", F64},   {"PduSizeMax", F64}};
+
+const std::vector<TraceSpec> g_traces = {
+    // the first column of RxPacketTrace, DL or UL, is stored as 0 or 1
+    {"RxPacketTrace",
+     {{"DL/UL", I64},
+      {"time", F64},
+      {"frame", I64},
+      {"subF", I64},
+      {"slot", I64},
+      {"1stSym", I64},
+      {"symbol#", I64},
+      {"cellId", I64},
+      {"rnti", I64},
+      {"ccId", I64},
+      {"tbSize", I64},
+      {"mcs", I64},
+      {"rv", I64},
+      {"SINR(dB)", F64},
+      {"corrupt", I64},
+      {"TBler", F64}}},
+    {"DlRlcStats", g_rlcPdcpColumns},
+    {"UlRlcStats", g_rlcPdcpColumns},
+    {"DlPdcpStats", g_rlcPdcpColumns},
+    {"UlPdcpStats", g_rlcPdcpColumns},
+    {"CellIdStats", {{"Time", F64}, {"IMSI", I64}, {"CellId", I64}, {"RNTI", I64}}},
+    {"MmWaveSinrTime", {{"Time", F64}, {"IMSI", I64}, {"CellId", I64}, {"SINR[dB]", F64}}},
+    {"X2Stats",
+     {{"Time", F64},
+      {"SourceCellId", I64},
+      {"TargetCellId", I64},
+      {"size", I64},
+      {"delay", F64},
+      {"isData", I64}}},
+};
+
+/// The columns of a trace, or of a chunk of it
+struct Table
+{
+    std::vector<std::vector<int64_t>> i64;
+    std::vector<std::vector<double>> f64;
+    std::vector<uint32_t> slot; //!< by column, the index in i64 or f64
+    uint64_t rows{0};
+    uint64_t malformed{0};
+
+    explicit Table(const TraceSpec& spec)
+    {
+        for (const ColumnSpec& c : spec.columns)
+        {
+            if (c.type == I64)
+            {
+                slot.push_back(i64.size());
+                i64.emplace_back();
+            }
+            else
+            {
+                slot.push_back(f64.size());
+                f64.emplace_back();
+            }
+        }
+    }
+};
+
+/**
+ * Parse the lines of [begin, end), which starts at a line and ends after a newline or at EOF
+ * \param first true if the chunk starts at the beginning of the file, whose first line may
+ * be the column names
+ */
+void
+ParseChunk(const TraceSpec& spec, const char* begin, const char* end, bool first, Table& table)
+{
+    const std::size_t nColumns = spec.columns.size();
+    std::vector<double> values(nColumns);
+    const char* line = begin;
+    while (line < end)
+    {
+        const char* eol = static_cast<const char*>(std::memchr(line, '\n', end - line));
+        if (!eol)
+        {
+            eol = end;
+        }
+        const char* p = line;
+        std::size_t n = 0;
+        bool ok = true;
+        while (true)
+        {
+            while (p < eol && IsSpace(*p))
+            {
+                ++p;
+            }
+            if (p == eol)
+            {
+                break;
+            }
+            const char* token = p;
+            while (p < eol && !IsSpace(*p))
+            {
+                ++p;
+            }
+            if (n == nColumns)
+            {
+                ok = false;
+                break;
+            }
+            if (n == 0 && p - token == 2 && token[1] == 'L' && (token[0] == 'D' || token[0] == 'U'))
+            {
+                values[n++] = token[0] == 'U';
+                continue;
+            }
+            if (!ParseNumber(token, p, values[n++]))
+            {
+                ok = false;
+                break;
+            }
+        }
+        // empty lines are skipped; the headers ('%' or column names) are not numbers
+        if (n > 0)
+        {
+            if (ok && n == nColumns)
+            {
+                for (std::size_t c = 0; c < nColumns; ++c)
+                {
+                    if (spec.columns[c].type == I64)
+                    {
+                        table.i64[table.slot[c]].push_back(int64_t(values[c]));
+                    }
+                    else
+                    {
+                        table.f64[table.slot[c]].push_back(values[c]);
+                    }
+                }
+                ++table.rows;
+            }
+            else if (*line != '%' && !(first && line == begin))
+            {
+                ++table.malformed;
+            }
+        }
+        line = eol + 1;
+    }
+}
+
+/// Memory map a file and parse it on nThreads threads
+Table
+ParseFile(const TraceSpec& spec, const std::string& path, unsigned nThreads, std::size_t& bytes)
+{
+    Table table(spec);
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        std::perror(path.c_str());
+        return table;
+    }
+    struct stat st;
+    fstat(fd, &st);
+    bytes = st.st_size;
+    if (bytes == 0)
+    {
+        close(fd);
+        return table;
+    }
+    void* map = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        std::perror(path.c_str());
+        return table;
+    }
+    madvise(map, bytes, MADV_SEQUENTIAL);
+    const char* data = static_cast<const char*>(map);
+    const char* end = data + bytes;
+
+    // chunk boundaries at the first line start after every bytes / nChunks
+    unsigned nChunks = std::max<std::size_t>(1, std::min<std::size_t>(nThreads, bytes >> 16));
+    std::vector<const char*> bounds{data};
+    for (unsigned c = 1; c < nChunks; ++c)
+    {
+        const char* b = data + bytes * c / nChunks;
+        b = std::max(b, bounds.back());
+        const char* nl = static_cast<const char*>(std::memchr(b, '\n', end - b));
+        bounds.push_back(nl ? nl + 1 : end);
+    }
+    bounds.push_back(end);
+
+    std::vector<Table> chunks(nChunks, Table(spec));
+    std::vector<std::thread> threads;
+    for (unsigned c = 0; c < nChunks; ++c)
+    {
+        threads.emplace_back(ParseChunk,
+                             std::cref(spec),
+                             bounds[c],
+                             bounds[c + 1],
+                             c == 0,
+                             std::ref(chunks[c]));
+    }
+    for (std::thread& t : threads)
+    {
+        t.join();
+    }
+    munmap(map, bytes);
+
+    // concatenate the chunks, in order
+    for (std::size_t k = 0; k < table.i64.size(); ++k)
+    {
+        for (Table& chunk : chunks)
+        {
+            table.i64[k].insert(table.i64[k].end(), chunk.i64[k].begin(), chunk.i64[k].end());
+        }
+    }
+    for (std::size_t k = 0; k < table.f64.size(); ++k)
+    {
+        for (Table& chunk : chunks)
+        {
+            table.f64[k].insert(table.f64[k].end(), chunk.f64[k].begin(), chunk.f64[k].end());
+        }
+    }
+    for (const Table& chunk : chunks)
+    {
+        table.rows += chunk.rows;
+        table.malformed += chunk.malformed;
+    }
+    return table;
+}
+
+/// The typed access to the columns of a parsed trace
+struct Trace
+{
+    const TraceSpec* spec;
+    std::string stem;
+    Table table;
+
+    int Index(const char* name) const
+    {
+        for (std::size_t c = 0; c < spec->columns.size(); ++c)
+        {
+            if (std::strcmp(spec->columns[c].name, name) == 0)
+            {
+                return c;
+            }
+        }
+        std::cerr << "no column " << name << " in " << stem << std::endl;
+        std::exit(1);
+    }
+
+    const std::vector<int64_t>& I(const char* name) const
+    {
+        return table.i64[table.slot[Index(name)]];
+    }
+
+    const std::vector<double>& F(const char* name) const
+    {
+        return table.f64[table.slot[Index(name)]];
+    }
+};
+
+void
+WriteColumns(const Trace& trace, const std::string& out, bool csv)
+{
+    std::string dir = out + "/" + trace.stem;
+    mkdir(dir.c_str(), 0775);
+    std::ofstream schema(dir + "/schema.txt");
+    const std::vector<ColumnSpec>& columns = trace.spec->columns;
+    for (std::size_t c = 0; c < columns.size(); ++c)
+    {
+        std::string name = columns[c].name;
+        std::replace(name.begin(), name.end(), '/', '_');
+        std::ofstream bin(dir + "/" + name + ".bin", std::ios::binary);
+        if (columns[c].type == I64)
+        {
+            const std::vector<int64_t>& v = trace.table.i64[trace.table.slot[c]];
+            bin.write(reinterpret_cast<const char*>(v.data()), v.size() * sizeof(int64_t));
+        }
+        else
+        {
+            const std::vector<double>& v = trace.table.f64[trace.table.slot[c]];
+            bin.write(reinterpret_cast<const char*>(v.data()), v.size() * sizeof(double));
+        }
+        schema << name << "\t" << (columns[c].type == I64 ? "int64" : "float64") << "\t"
+               << trace.table.rows << "\n";
+    }
+    if (!csv)
+    {
+        return;
+    }
+    FILE* f = std::fopen((out + "/" + trace.stem + ".csv").c_str(), "w");
+    for (std::size_t c = 0; c < columns.size(); ++c)
+    {
+        std::fprintf(f, "%s%s", c > 0 ? ";" : "", columns[c].name);
+    }
+    std::fputc('\n', f);
+    for (uint64_t r = 0; r < trace.table.rows; ++r)
+    {
+        for (std::size_t c = 0; c < columns.size(); ++c)
+        {
+            if (c > 0)
+            {
+                std::fputc(';', f);
+            }
+            if (columns[c].type == I64)
+            {
+                std::fprintf(f, "%lld", (long long)trace.table.i64[trace.table.slot[c]][r]);
+            }
+            else
+            {
+                std::fprintf(f, "%.9g", trace.table.f64[trace.table.slot[c]][r]);
+            }
+        }
+        std::fputc('\n', f);
+    }
+    std::fclose(f);
+}
+
+/// The IMSI of the UE with a given RNTI in a cell, over time
+class ImsiResolver
+{
+  public:
+    void Add(int64_t cellId, int64_t rnti, double time, int64_t imsi)
+    {
+        m_assignments[{cellId, rnti}].push_back({time, imsi});
+    }
+
+    void Sort()
+    {
+        for (auto& a : m_assignments)
+        {
+            std::sort(a.second.begin(), a.second.end());
+        }
+    }
+
+    /// \return the IMSI the cell had given the RNTI to at the time, -1 if unknown
+    int64_t Get(int64_t cellId, int64_t rnti, double time) const
+    {
+        auto it = m_assignments.find({cellId, rnti});
+        if (it == m_assignments.end())
+        {
+            return -1;
+        }
+        const auto& v = it->second;
+        auto a = std::upper_bound(v.begin(),
+                                  v.end(),
+                                  std::make_pair(time, INT64_MAX));
+        // before the first report, the first assignment
+        return a == v.begin() ? v.front().second : (a - 1)->second;
+    }
+
+  private:
+    std::map<std::pair<int64_t, int64_t>, std::vector<std::pair<double, int64_t>>>
+        m_assignments;
+};
+
+/// The summary of an IMSI
+struct ImsiSummary
+{
+    uint64_t tbs[2]{0, 0}; //!< DL, UL
+    uint64_t tbBytes[2]{0, 0};
+    uint64_t corrupt[2]{0, 0};
+    double sinrSum[2]{0, 0};
+    uint64_t rlcBytes[2]{0, 0}; //!< received, DL and UL
+    double rlcDelaySum[2]{0, 0};
+    uint64_t rlcPdus[2]{0, 0};
+    uint64_t pdcpBytes[2]{0, 0};
+    double pdcpDelaySum[2]{0, 0};
+    uint64_t pdcpPdus[2]{0, 0};
+    double mmWaveSinrSum{0};
+    uint64_t mmWaveSinrReports{0};
+    uint64_t cellChanges{0};
+};
+
+void
+WriteSummary(const std::map<std::string, Trace>& traces, const std::string& out)
+{
+    std::map<int64_t, ImsiSummary> imsis;
+    ImsiResolver resolver;
+    auto find = [&traces](const char* prefix) -> const Trace* {
+        for (const auto& t : traces)
+        {
+            if (std::strcmp(t.second.spec->prefix, prefix) == 0)
+            {
+                return &t.second;
+            }
+        }
+        return nullptr;
+    };
+
+    if (const Trace* t = find("CellIdStats"))
+    {
+        const auto& time = t->F("Time");
+        const auto& imsi = t->I("IMSI");
+        const auto& cell = t->I("CellId");
+        const auto& rnti = t->I("RNTI");
+        std::map<int64_t, int64_t> lastCell;
+        for (uint64_t r = 0; r < t->table.rows; ++r)
+        {
+            resolver.Add(cell[r], rnti[r], time[r], imsi[r]);
+            auto it = lastCell.find(imsi[r]);
+            if (it != lastCell.end() && it->second != cell[r])
+            {
+                ++imsis[imsi[r]].cellChanges;
+            }
+            lastCell[imsi[r]] = cell[r];
+        }
+    }
+    const char* rlcPdcp[] = {"DlRlcStats", "UlRlcStats", "DlPdcpStats", "UlPdcpStats"};
+    for (int k = 0; k < 4; ++k)
+    {
+        const Trace* t = find(rlcPdcp[k]);
+        if (!t)
+        {
+            continue;
+        }
+        const auto& start = t->F("start");
+        const auto& cell = t->I("CellId");
+        const auto& imsi = t->I("IMSI");
+        const auto& rnti = t->I("RNTI");
+        const auto& rxBytes = t->I("RxBytes");
+        const auto& rxPdus = t->I("nRxPDUs");
+        const auto& delay = t->F("delay");
+        for (uint64_t r = 0; r < t->table.rows; ++r)
+        {
+            resolver.Add(cell[r], rnti[r], start[r], imsi[r]);
+            ImsiSummary& s = imsis[imsi[r]];
+            int direction = k % 2;
+            bool rlc = k < 2;
+            (rlc ? s.rlcBytes : s.pdcpBytes)[direction] += rxBytes[r];
+            (rlc ? s.rlcPdus : s.pdcpPdus)[direction] += rxPdus[r];
+            (rlc ? s.rlcDelaySum : s.pdcpDelaySum)[direction] += delay[r] * rxPdus[r];
+        }
+    }
+    resolver.Sort();
+
+    if (const Trace* t = find("MmWaveSinrTime"))
+    {
+        const auto& imsi = t->I("IMSI");
+        const auto& sinr = t->F("SINR[dB]");
+        for (uint64_t r = 0; r < t->table.rows; ++r)
+        {
+            ImsiSummary& s = imsis[imsi[r]];
+            s.mmWaveSinrSum += sinr[r];
+            ++s.mmWaveSinrReports;
+        }
+    }
+    uint64_t unresolved = 0;
+    if (const Trace* t = find("RxPacketTrace"))
+    {
+        const auto& mode = t->I("DL/UL");
+        const auto& time = t->F("time");
+        const auto& cell = t->I("cellId");
+        const auto& rnti = t->I("rnti");
+        const auto& tbSize = t->I("tbSize");
+        const auto& sinr = t->F("SINR(dB)");
+        const auto& corrupt = t->I("corrupt");
+        for (uint64_t r = 0; r < t->table.rows; ++r)
+        {
+            int64_t imsi = resolver.Get(cell[r], rnti[r], time[r]);
+            if (imsi < 0)
+            {
+                ++unresolved;
+                continue;
+            }
+            ImsiSummary& s = imsis[imsi];
+            int d = mode[r] != 0;
+            ++s.tbs[d];
+            s.tbBytes[d] += tbSize[r];
+            s.corrupt[d] += corrupt[r] != 0;
+            s.sinrSum[d] += sinr[r];
+        }
+    }
+
+    auto ratio = [](double a, uint64_t b) { return b > 0 ? a / b : 0.0; };
+    std::ofstream f(out + "/ImsiSummary.txt");
+    if (unresolved > 0)
+    {
+        f << "# " << unresolved << " RxPacketTrace lines of an unknown cell and RNTI" << "\n";
+    }
+    f << "IMSI\tdlTbs\tdlTbBytes\tdlCorruptFraction\tdlMeanSinr(dB)\tulTbs\tulTbBytes"
+         "\tulCorruptFraction\tulMeanSinr(dB)\tdlRlcRxBytes\tdlRlcMeanDelay(s)\tulRlcRxBytes"
+         "\tulRlcMeanDelay(s)\tdlPdcpRxBytes\tdlPdcpMeanDelay(s)\tulPdcpRxBytes"
+         "\tulPdcpMeanDelay(s)\tmmWaveMeanSinr(dB)\tcellChanges\n";
+    for (const auto& e : imsis)
+    {
+        const ImsiSummary& s = e.second;
+        f << e.first;
+        for (int d = 0; d < 2; ++d)
+        {
+            f << "\t" << s.tbs[d] << "\t" << s.tbBytes[d] << "\t" << ratio(s.corrupt[d], s.tbs[d])
+              << "\t" << ratio(s.sinrSum[d], s.tbs[d]);
+        }
+        for (int d = 0; d < 2; ++d)
+        {
+            f << "\t" << s.rlcBytes[d] << "\t" << ratio(s.rlcDelaySum[d], s.rlcPdus[d]);
+        }
+        for (int d = 0; d < 2; ++d)
+        {
+            f << "\t" << s.pdcpBytes[d] << "\t" << ratio(s.pdcpDelaySum[d], s.pdcpPdus[d]);
+        }
+        f << "\t" << ratio(s.mmWaveSinrSum, s.mmWaveSinrReports) << "\t" << s.cellChanges
+          << "\n";
+    }
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+    unsigned nThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::string out = "analysis";
+    bool csv = false;
+    std::string directory;
+    for (int a = 1; a < argc; ++a)
+    {
+        std::string arg = argv[a];
+        if (arg.rfind("--threads=", 0) == 0)
+        {
+            nThreads = std::max(1, std::atoi(arg.c_str() + 10));
+        }
+        else if (arg.rfind("--out=", 0) == 0)
+        {
+            out = arg.substr(6);
+        }
+        else if (arg == "--csv")
+        {
+            csv = true;
+        }
+        else if (arg.rfind("--", 0) != 0 && directory.empty())
+        {
+            directory = arg;
+        }
+        else
+        {
+            std::cerr << "usage: " << argv[0] << " [--threads=N] [--out=analysis] [--csv] <dir>"
+                      << std::endl;
+            return 1;
+        }
+    }
+    if (directory.empty())
+    {
+        directory = ".";
+    }
+    if (out[0] != '/')
+    {
+        out = directory + "/" + out;
+    }
+    mkdir(out.c_str(), 0775);
+
+    // the traces of the directory, in name order
+    std::vector<std::string> names;
+    if (DIR* dir = opendir(directory.c_str()))
+    {
+        while (struct dirent* entry = readdir(dir))
+        {
+            std::string name = entry->d_name;
+            if (name.size() > 4 && name.compare(name.size() - 4, 4, ".txt") == 0)
+            {
+                names.push_back(name);
+            }
+        }
+        closedir(dir);
+    }
+    std::sort(names.begin(), names.end());
+
+    std::map<std::string, Trace> traces;
+    std::cout << "trace\trows\tmalformed\tMB\tseconds\tMB/s" << std::endl;
+    for (const std::string& name : names)
+    {
+        for (const TraceSpec& spec : g_traces)
+        {
+            if (name.rfind(spec.prefix, 0) != 0)
+            {
+                continue;
+            }
+            auto start = std::chrono::steady_clock::now();
+            std::size_t bytes = 0;
+            std::string stem = name.substr(0, name.size() - 4);
+            Trace trace{&spec, stem, ParseFile(spec, directory + "/" + name, nThreads, bytes)};
+            WriteColumns(trace, out, csv);
+            double seconds =
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::cout << stem << "\t" << trace.table.rows << "\t" << trace.table.malformed << "\t"
+                      << bytes / 1e6 << "\t" << seconds << "\t" << bytes / 1e6 / seconds
+                      << std::endl;
+            traces.emplace(stem, std::move(trace));
+            break;
+        }
+    }
+    WriteSummary(traces, out);
+    return 0;
+}
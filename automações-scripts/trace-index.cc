@@ -0,0 +1,240 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Build and query the index sidecars (<trace>.idx) of the traces of the
+ * mmWave scenarios (TraceIndex).
+ *
+ * build: index the traces given, or the known traces of a directory, once the
+ * simulation has finished writing them.
+ * query: print the column names and the lines of a trace in a time range and,
+ * with --where, of the given values of its key columns (cellId, rnti, IMSI,
+ * ...), reading only the row groups that can hold them; the index is built
+ * first if it is missing or the trace has changed.
+ * info: the time range, the row groups and the key values of a trace.
+ *
+ * g++ -O2 -std=c++17 trace-index.cc -o trace-index
+ * ./trace-index build [--bucket=1] [--groupRows=4096] <trace or directory>...
+ * ./trace-index query [--from=10] [--to=20] [--where=rnti=3,4] [--where=cellId=2] <trace>
+ * ./trace-index info <trace>
+ */
+
+#include "trace-index.h"
+
+#include <chrono>
+#include <dirent.h>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+
+bool
+BuildIndex(const std::string& path, double bucket, uint32_t groupRows)
+{
+    auto start = std::chrono::steady_clock::now();
+    TraceIndex index;
+    if (!index.Build(path, bucket, groupRows) || !index.Save(path))
+    {
+        std::cerr << path << ": index not written" << std::endl;
+        return false;
+    }
+    double s =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << path << ".idx: " << index.GetGroups() << " row groups, "
+              << index.GetFileSize() << " bytes indexed in " << s << " s" << std::endl;
+    return true;
+}
+
+/// \return the traces of a directory of a known kind, or the path itself
+std::vector<std::string>
+ListTraces(const std::string& path)
+{
+    std::vector<std::string> traces;
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0 || !S_ISDIR(st.st_mode))
+    {
+        traces.push_back(path);
+        return traces;
+    }
+    if (DIR* dir = opendir(path.c_str()))
+    {
+        while (struct dirent* entry = readdir(dir))
+        {
+            std::string name = entry->d_name;
+            if (name.size() > 4 && name.compare(name.size() - 4, 4, ".txt") == 0 &&
+                TraceIndex::GetLayout(name))
+            {
+                traces.push_back(path + "/" + name);
+            }
+        }
+        closedir(dir);
+    }
+    std::sort(traces.begin(), traces.end());
+    return traces;
+}
+
+/// Parse "key=v1,v2,..."
+bool
+ParseCondition(const std::string& text, TraceIndex::Condition& condition)
+{
+    std::size_t eq = text.find('=');
+    if (eq == std::string::npos || eq == 0)
+    {
+        return false;
+    }
+    condition.key = text.substr(0, eq);
+    std::stringstream values(text.substr(eq + 1));
+    std::string value;
+    while (std::getline(values, value, ','))
+    {
+        char* stop;
+        condition.values.push_back(std::strtoll(value.c_str(), &stop, 10));
+        if (value.empty() || *stop != '\0')
+        {
+            return false;
+        }
+    }
+    return !condition.values.empty();
+}
+
+int
+Usage(const char* program)
+{
+    std::cerr << "usage: " << program
+              << " build [--bucket=s] [--groupRows=n] <trace or directory>...\n"
+              << "       " << program
+              << " query [--from=s] [--to=s] [--where=key=v1,v2]... <trace>\n"
+              << "       " << program << " info <trace>" << std::endl;
+    return 1;
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+    if (argc < 3)
+    {
+        return Usage(argv[0]);
+    }
+    std::string command = argv[1];
+    double bucket = 1.0;
+    uint32_t groupRows = 4096;
+    double from = -1e300;
+    double to = 1e300;
+    std::vector<TraceIndex::Condition> conditions;
+    std::vector<std::string> paths;
+    for (int a = 2; a < argc; ++a)
+    {
+        std::string arg = argv[a];
+        if (arg.rfind("--bucket=", 0) == 0)
+        {
+            bucket = std::atof(arg.c_str() + 9);
+        }
+        else if (arg.rfind("--groupRows=", 0) == 0)
+        {
+            groupRows = std::max(1, std::atoi(arg.c_str() + 12));
+        }
+        else if (arg.rfind("--from=", 0) == 0)
+        {
+            from = std::atof(arg.c_str() + 7);
+        }
+        else if (arg.rfind("--to=", 0) == 0)
+        {
+            to = std::atof(arg.c_str() + 5);
+        }
+        else if (arg.rfind("--where=", 0) == 0)
+        {
+            TraceIndex::Condition condition;
+            if (!ParseCondition(arg.substr(8), condition))
+            {
+                return Usage(argv[0]);
+            }
+            conditions.push_back(condition);
+        }
+        else if (arg.rfind("--", 0) != 0)
+        {
+            paths.push_back(arg);
+        }
+        else
+        {
+            return Usage(argv[0]);
+        }
+    }
+    if (paths.empty() || bucket <= 0)
+    {
+        return Usage(argv[0]);
+    }
+
+    if (command == "build")
+    {
+        bool ok = true;
+        for (const std::string& p : paths)
+        {
+            for (const std::string& trace : ListTraces(p))
+            {
+                ok = BuildIndex(trace, bucket, groupRows) && ok;
+            }
+        }
+        return ok ? 0 : 1;
+    }
+    if (paths.size() != 1 || (command != "query" && command != "info"))
+    {
+        return Usage(argv[0]);
+    }
+
+    const std::string& path = paths[0];
+    TraceIndex index;
+    if (!index.Load(path))
+    {
+        if (!BuildIndex(path, bucket, groupRows) || !index.Load(path))
+        {
+            return 1;
+        }
+    }
+    if (command == "info")
+    {
+        auto range = index.GetTimeRange();
+        std::cout << "bytes\t" << index.GetFileSize() << "\n"
+                  << "rowGroups\t" << index.GetGroups() << "\n"
+                  << "time\t" << range.first << "\t" << range.second << "\n";
+        for (const auto& key : index.GetKeyValues())
+        {
+            std::cout << key.first;
+            for (int64_t v : key.second)
+            {
+                std::cout << "\t" << v;
+            }
+            std::cout << "\n";
+        }
+        return 0;
+    }
+
+    std::fwrite(index.GetHeader().data(), 1, index.GetHeader().size(), stdout);
+    uint64_t lines = 0;
+    int64_t bytes = index.Query(path, from, to, conditions, [&lines](const char* l, std::size_t n) {
+        std::fwrite(l, 1, n, stdout);
+        ++lines;
+    });
+    if (bytes < 0)
+    {
+        return 1;
+    }
+    std::cerr << lines << " lines, " << bytes << " of " << index.GetFileSize() << " bytes read"
+              << std::endl;
+    return 0;
+}
@@ -0,0 +1,580 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TRACE_INDEX_H
+#define TRACE_INDEX_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+/**
+ * Sparse index of a text trace of the mmWave scenarios, kept next to it in
+ * <trace>.idx.
+ *
+ * The lines are grouped in row groups of consecutive lines, closed after
+ * GroupRows lines or when the time enters another bucket of BucketWidth
+ * seconds, so the groups of a bucket give its byte range. For every group the
+ * index keeps its byte offset and length, its smallest and largest time and,
+ * for every key column of the trace (the cell, the RNTI, the IMSI), a bitmap of
+ * the values it holds. A query reads only the groups whose time range and
+ * bitmaps can match, and filters their lines.
+ */
+class TraceIndex
+{
+  public:
+    /// The layout of a kind of trace, as far as the index is concerned
+    struct Layout
+    {
+        const char* prefix; //!< the file name starts with it
+        int timeColumn;
+        std::vector<std::pair<const char*, int>> keys; //!< name and column
+    };
+
+    /// \return the layout of a trace file, nullptr if unknown
+    static const Layout* GetLayout(const std::string& path)
+    {
+        static const std::vector<Layout> layouts = {
+            {"RxPacketTrace", 1, {{"cellId", 7}, {"rnti", 8}}},
+            {"DlRlcStats", 0, {{"CellId", 2}, {"IMSI", 3}, {"RNTI", 4}}},
+            {"UlRlcStats", 0, {{"CellId", 2}, {"IMSI", 3}, {"RNTI", 4}}},
+            {"DlPdcpStats", 0, {{"CellId", 2}, {"IMSI", 3}, {"RNTI", 4}}},
+            {"UlPdcpStats", 0, {{"CellId", 2}, {"IMSI", 3}, {"RNTI", 4}}},
+            {"CellIdStats", 0, {{"IMSI", 1}, {"CellId", 2}, {"RNTI", 3}}},
+            {"MmWaveSinrTime", 0, {{"IMSI", 1}, {"CellId", 2}}},
+            {"X2Stats", 0, {{"SourceCellId", 1}, {"TargetCellId", 2}}},
+        };
+        std::string name = path.substr(path.find_last_of('/') + 1);
+        for (const Layout& l : layouts)
+        {
+            if (name.rfind(l.prefix, 0) == 0)
+            {
+                return &l;
+            }
+        }
+        return nullptr;
+    }
+
+    /// A condition of a query: the key column equal to one of the values
+    struct Condition
+    {
+        std::string key;
+        std::vector<int64_t> values;
+    };
+
+    /**
+     * Index a trace
+     * \param path the trace
+     * \param bucketWidth the time buckets, in seconds
+     * \param groupRows the largest number of lines of a row group
+     * \return false if the trace cannot be read or is of an unknown kind
+     */
+    bool Build(const std::string& path, double bucketWidth = 1.0, uint32_t groupRows = 4096)
+    {
+        m_layout = GetLayout(path);
+        if (!m_layout)
+        {
+            std::fprintf(stderr, "%s: unknown trace\n", path.c_str());
+            return false;
+        }
+        m_bucketWidth = bucketWidth;
+        m_groupRows = groupRows;
+        m_groups.clear();
+        m_header.clear();
+        m_keys.assign(m_layout->keys.size(), KeyColumn());
+        std::size_t size;
+        const char* data = Map(path, size);
+        if (!data)
+        {
+            return false;
+        }
+        m_fileSize = size;
+
+        const char* end = data + size;
+        const char* line = data;
+        Group group;
+        int64_t bucket = INT64_MIN;
+        std::vector<int64_t> keys(m_layout->keys.size());
+        while (line < end)
+        {
+            const char* eol = static_cast<const char*>(std::memchr(line, '\n', end - line));
+            eol = eol ? eol + 1 : end;
+            double time;
+            if (!ParseLine(line, eol, time, keys))
+            {
+                // the column names, kept for the queries
+                if (line == data)
+                {
+                    m_header.assign(line, eol);
+                }
+                line = eol;
+                continue;
+            }
+            int64_t b = int64_t(time / m_bucketWidth);
+            if (group.rows > 0 && (group.rows == m_groupRows || b != bucket))
+            {
+                m_groups.push_back(std::move(group));
+                group = Group();
+            }
+            if (group.rows == 0)
+            {
+                group.offset = line - data;
+                group.tMin = group.tMax = time;
+                group.bitmaps.resize(m_keys.size());
+                bucket = b;
+            }
+            group.length = eol - data - group.offset;
+            ++group.rows;
+            group.tMin = std::min(group.tMin, time);
+            group.tMax = std::max(group.tMax, time);
+            for (std::size_t k = 0; k < m_keys.size(); ++k)
+            {
+                SetBit(group.bitmaps[k], m_keys[k].GetId(keys[k]));
+            }
+            line = eol;
+        }
+        if (group.rows > 0)
+        {
+            m_groups.push_back(std::move(group));
+        }
+        munmap(const_cast<char*>(data), size);
+        return true;
+    }
+
+    /// Write the index to <trace>.idx
+    bool Save(const std::string& path) const
+    {
+        std::ofstream f(path + ".idx", std::ios::binary | std::ios::trunc);
+        if (!f)
+        {
+            return false;
+        }
+        f.write(MAGIC, sizeof(MAGIC));
+        Put(f, m_fileSize);
+        Put(f, m_bucketWidth);
+        Put(f, m_groupRows);
+        Put(f, uint32_t(m_header.size()));
+        f.write(m_header.data(), m_header.size());
+        Put(f, uint32_t(m_keys.size()));
+        for (const KeyColumn& k : m_keys)
+        {
+            Put(f, uint32_t(k.values.size()));
+            f.write(reinterpret_cast<const char*>(k.values.data()),
+                    k.values.size() * sizeof(int64_t));
+        }
+        Put(f, uint64_t(m_groups.size()));
+        for (const Group& g : m_groups)
+        {
+            Put(f, g.offset);
+            Put(f, g.length);
+            Put(f, g.rows);
+            Put(f, g.tMin);
+            Put(f, g.tMax);
+            for (std::size_t k = 0; k < m_keys.size(); ++k)
+            {
+                // every bitmap at the final number of values of its column
+                std::vector<uint64_t> words = g.bitmaps[k];
+                words.resize((m_keys[k].values.size() + 63) / 64, 0);
+                f.write(reinterpret_cast<const char*>(words.data()), words.size() * 8);
+            }
+        }
+        return bool(f);
+    }
+
+    /**
+     * Read <trace>.idx
+     * \return false if there is none, or the trace changed since it was built
+     */
+    bool Load(const std::string& path)
+    {
+        m_layout = GetLayout(path);
+        std::ifstream f(path + ".idx", std::ios::binary);
+        char magic[sizeof(MAGIC)];
+        if (!m_layout || !f.read(magic, sizeof(magic)) ||
+            std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0)
+        {
+            return false;
+        }
+        uint32_t headerSize;
+        uint32_t nKeys;
+        Get(f, m_fileSize);
+        Get(f, m_bucketWidth);
+        Get(f, m_groupRows);
+        Get(f, headerSize);
+        m_header.resize(headerSize);
+        f.read(&m_header[0], headerSize);
+        Get(f, nKeys);
+        if (nKeys != m_layout->keys.size())
+        {
+            return false;
+        }
+        m_keys.assign(nKeys, KeyColumn());
+        for (KeyColumn& k : m_keys)
+        {
+            uint32_t n;
+            Get(f, n);
+            k.values.resize(n);
+            f.read(reinterpret_cast<char*>(k.values.data()), n * sizeof(int64_t));
+            for (uint32_t i = 0; i < n; ++i)
+            {
+                k.ids[k.values[i]] = i;
+            }
+        }
+        uint64_t nGroups;
+        Get(f, nGroups);
+        m_groups.assign(nGroups, Group());
+        for (Group& g : m_groups)
+        {
+            Get(f, g.offset);
+            Get(f, g.length);
+            Get(f, g.rows);
+            Get(f, g.tMin);
+            Get(f, g.tMax);
+            g.bitmaps.resize(nKeys);
+            for (uint32_t k = 0; k < nKeys; ++k)
+            {
+                g.bitmaps[k].resize((m_keys[k].values.size() + 63) / 64);
+                f.read(reinterpret_cast<char*>(g.bitmaps[k].data()), g.bitmaps[k].size() * 8);
+            }
+        }
+        struct stat st;
+        return bool(f) && stat(path.c_str(), &st) == 0 && uint64_t(st.st_size) == m_fileSize;
+    }
+
+    /**
+     * Read the lines of the trace in [from, to] that meet all the conditions
+     * \param path the trace, whose index is loaded
+     * \param sink called with every line, its newline included
+     * \return the bytes read from the trace, -1 on error (e.g. an unknown key)
+     */
+    int64_t Query(const std::string& path,
+                  double from,
+                  double to,
+                  const std::vector<Condition>& conditions,
+                  const std::function<void(const char*, std::size_t)>& sink) const
+    {
+        // the conditions as bitmaps of value IDs and column positions
+        std::vector<std::pair<std::size_t, std::vector<uint64_t>>> masks;
+        for (const Condition& c : conditions)
+        {
+            std::size_t k = 0;
+            while (k < m_keys.size() && c.key != m_layout->keys[k].first)
+            {
+                ++k;
+            }
+            if (k == m_keys.size())
+            {
+                std::fprintf(stderr, "%s: no key column %s\n", path.c_str(), c.key.c_str());
+                return -1;
+            }
+            std::vector<uint64_t> mask((m_keys[k].values.size() + 63) / 64, 0);
+            for (int64_t v : c.values)
+            {
+                auto it = m_keys[k].ids.find(v);
+                if (it != m_keys[k].ids.end())
+                {
+                    SetBit(mask, it->second);
+                }
+            }
+            masks.emplace_back(k, std::move(mask));
+        }
+
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            std::perror(path.c_str());
+            return -1;
+        }
+        int64_t bytesRead = 0;
+        std::vector<char> buffer;
+        std::vector<int64_t> keys(m_keys.size());
+        for (std::size_t i = 0; i < m_groups.size(); ++i)
+        {
+            const Group& g = m_groups[i];
+            if (g.tMax < from || g.tMin > to || !Matches(g, masks))
+            {
+                continue;
+            }
+            // a run of consecutive selected groups is read at once
+            uint64_t offset = g.offset;
+            uint64_t length = g.length;
+            while (i + 1 < m_groups.size() && m_groups[i + 1].offset == offset + length &&
+                   m_groups[i + 1].tMax >= from && m_groups[i + 1].tMin <= to &&
+                   Matches(m_groups[i + 1], masks))
+            {
+                length += m_groups[++i].length;
+            }
+            buffer.resize(length);
+            if (pread(fd, buffer.data(), length, offset) != ssize_t(length))
+            {
+                std::perror(path.c_str());
+                close(fd);
+                return -1;
+            }
+            bytesRead += length;
+            const char* line = buffer.data();
+            const char* end = line + length;
+            while (line < end)
+            {
+                const char* eol = static_cast<const char*>(std::memchr(line, '\n', end - line));
+                eol = eol ? eol + 1 : end;
+                double time;
+                if (ParseLine(line, eol, time, keys) && time >= from && time <= to &&
+                    LineMatches(keys, conditions))
+                {
+                    sink(line, eol - line);
+                }
+                line = eol;
+            }
+        }
+        close(fd);
+        return bytesRead;
+    }
+
+    /// \return the column names line of the trace, empty if it has none
+    const std::string& GetHeader() const
+    {
+        return m_header;
+    }
+
+    /// \return the number of row groups
+    std::size_t GetGroups() const
+    {
+        return m_groups.size();
+    }
+
+    /// \return the size of the trace when it was indexed
+    uint64_t GetFileSize() const
+    {
+        return m_fileSize;
+    }
+
+    /// \return the smallest and largest time of the trace
+    std::pair<double, double> GetTimeRange() const
+    {
+        std::pair<double, double> range{0, 0};
+        for (std::size_t i = 0; i < m_groups.size(); ++i)
+        {
+            range.first = i == 0 ? m_groups[i].tMin : std::min(range.first, m_groups[i].tMin);
+            range.second = i == 0 ? m_groups[i].tMax : std::max(range.second, m_groups[i].tMax);
+        }
+        return range;
+    }
+
+    /// \return the distinct values of every key column
+    std::vector<std::pair<const char*, std::vector<int64_t>>> GetKeyValues() const
+    {
+        std::vector<std::pair<const char*, std::vector<int64_t>>> values;
+        for (std::size_t k = 0; k < m_keys.size(); ++k)
+        {
+            std::vector<int64_t> v = m_keys[k].values;
+            std::sort(v.begin(), v.end());
+            values.emplace_back(m_layout->keys[k].first, std::move(v));
+        }
+        return values;
+    }
+
+  private:
+    static constexpr char MAGIC[8] = {'M', 'W', 'T', 'I', 'D', 'X', '1', '\0'};
+
+    /// The distinct values of a key column, by order of appearance
+    struct KeyColumn
+    {
+        std::vector<int64_t> values;
+        std::map<int64_t, uint32_t> ids;
+
+        uint32_t GetId(int64_t value)
+        {
+            auto it = ids.emplace(value, values.size());
+            if (it.second)
+            {
+                values.push_back(value);
+            }
+            return it.first->second;
+        }
+    };
+
+    struct Group
+    {
+        uint64_t offset{0};
+        uint64_t length{0};
+        uint32_t rows{0};
+        double tMin{0};
+        double tMax{0};
+        std::vector<std::vector<uint64_t>> bitmaps; //!< by key column, by value ID
+    };
+
+    static void SetBit(std::vector<uint64_t>& bitmap, uint32_t id)
+    {
+        if (id / 64 >= bitmap.size())
+        {
+            bitmap.resize(id / 64 + 1, 0);
+        }
+        bitmap[id / 64] |= uint64_t(1) << (id % 64);
+    }
+
+    static bool Matches(const Group& g,
+                        const std::vector<std::pair<std::size_t, std::vector<uint64_t>>>& masks)
+    {
+        for (const auto& m : masks)
+        {
+            const std::vector<uint64_t>& bitmap = g.bitmaps[m.first];
+            bool any = false;
+            for (std::size_t w = 0; w < m.second.size() && w < bitmap.size() && !any; ++w)
+            {
+                any = (m.second[w] & bitmap[w]) != 0;
+            }
+            if (!any)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool LineMatches(const std::vector<int64_t>& keys,
+                     const std::vector<Condition>& conditions) const
+    {
+        for (const Condition& c : conditions)
+        {
+            std::size_t k = 0;
+            while (c.key != m_layout->keys[k].first)
+            {
+                ++k;
+            }
+            if (std::find(c.values.begin(), c.values.end(), keys[k]) == c.values.end())
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Read the time and the keys of a line
+     * \return false if it is not a line of values (empty, or the column names)
+     */
+    bool ParseLine(const char* line,
+                   const char* eol,
+                   double& time,
+                   std::vector<int64_t>& keys) const
+    {
+        const char* p = line;
+        int column = 0;
+        std::size_t found = 0;
+        bool timeFound = false;
+        char token[64];
+        while (p < eol)
+        {
+            while (p < eol && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+            {
+                ++p;
+            }
+            const char* start = p;
+            while (p < eol && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n')
+            {
+                ++p;
+            }
+            if (p == start)
+            {
+                break;
+            }
+            std::size_t length = std::min<std::size_t>(p - start, sizeof(token) - 1);
+            std::memcpy(token, start, length);
+            token[length] = '\0';
+            char* stop;
+            if (column == m_layout->timeColumn)
+            {
+                time = std::strtod(token, &stop);
+                if (stop != token + length)
+                {
+                    return false;
+                }
+                timeFound = true;
+            }
+            for (std::size_t k = 0; k < m_layout->keys.size(); ++k)
+            {
+                if (m_layout->keys[k].second == column)
+                {
+                    keys[k] = std::strtoll(token, &stop, 10);
+                    if (stop != token + length)
+                    {
+                        return false;
+                    }
+                    ++found;
+                }
+            }
+            ++column;
+        }
+        return timeFound && found == m_layout->keys.size();
+    }
+
+    static const char* Map(const std::string& path, std::size_t& size)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            std::perror(path.c_str());
+            return nullptr;
+        }
+        struct stat st;
+        fstat(fd, &st);
+        size = st.st_size;
+        void* map = size > 0 ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : nullptr;
+        close(fd);
+        if (map == MAP_FAILED || !map)
+        {
+            std::fprintf(stderr, "%s: cannot map\n", path.c_str());
+            return nullptr;
+        }
+        madvise(map, size, MADV_SEQUENTIAL);
+        return static_cast<const char*>(map);
+    }
+
+    template <class T>
+    static void Put(std::ofstream& f, const T& value)
+    {
+        f.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <class T>
+    static void Get(std::ifstream& f, T& value)
+    {
+        f.read(reinterpret_cast<char*>(&value), sizeof(T));
+    }
+
+    const Layout* m_layout{nullptr};
+    double m_bucketWidth{1.0};
+    uint32_t m_groupRows{4096};
+    uint64_t m_fileSize{0};
+    std::string m_header;
+    std::vector<KeyColumn> m_keys;
+    std::vector<Group> m_groups;
+};
+
+#endif /* TRACE_INDEX_H */
@@ -0,0 +1,109 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TRACE_NUMBER_H
+#define TRACE_NUMBER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+/// The tokenizer and number parser of the trace tools (trace-analyzer, run-compare)
+
+inline const double g_pow10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                                 1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                                 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+inline bool
+IsSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+/**
+ * Parse a decimal number: the digits are accumulated in an integer with no
+ * branch per digit but the loop test, and scaled once by a power of ten. The
+ * rare forms it does not handle (more than 19 significant digits, large
+ * exponents, inf and nan) fall back to strtod.
+ * \return false if the token is not a number
+ */
+inline bool
+ParseNumber(const char* begin, const char* end, double& value)
+{
+    const char* p = begin;
+    bool negative = false;
+    if (p != end && (*p == '-' || *p == '+'))
+    {
+        negative = *p == '-';
+        ++p;
+    }
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int scale = 0;
+    const char* start = p;
+    while (p != end && unsigned(*p - '0') < 10)
+    {
+        mantissa = mantissa * 10 + unsigned(*p - '0');
+        ++digits;
+        ++p;
+    }
+    if (p != end && *p == '.')
+    {
+        ++p;
+        const char* fraction = p;
+        while (p != end && unsigned(*p - '0') < 10)
+        {
+            mantissa = mantissa * 10 + unsigned(*p - '0');
+            ++p;
+        }
+        digits += p - fraction;
+        scale -= p - fraction;
+    }
+    if (p != end && (*p == 'e' || *p == 'E'))
+    {
+        ++p;
+        bool negativeExponent = false;
+        if (p != end && (*p == '-' || *p == '+'))
+        {
+            negativeExponent = *p == '-';
+            ++p;
+        }
+        int exponent = 0;
+        while (p != end && unsigned(*p - '0') < 10 && exponent < 10000)
+        {
+            exponent = exponent * 10 + (*p - '0');
+            ++p;
+        }
+        scale += negativeExponent ? -exponent : exponent;
+    }
+    if (p == end && p != start && digits > 0 && digits <= 19 && scale >= -22 && scale <= 22)
+    {
+        double v = double(mantissa);
+        v = scale < 0 ? v / g_pow10[-scale] : v * g_pow10[scale];
+        value = negative ? -v : v;
+        return true;
+    }
+    char buffer[64];
+    std::size_t length = std::min<std::size_t>(end - begin, sizeof(buffer) - 1);
+    std::memcpy(buffer, begin, length);
+    buffer[length] = '\0';
+    char* stop;
+    value = std::strtod(buffer, &stop);
+    return stop == buffer + length && length > 0;
+}
+
+#endif /* TRACE_NUMBER_H */
@@ -0,0 +1,44 @@
+#!/usr/bin/env python3
+# Consulta aos traces grandes pelo índice (<trace>.idx) do trace-index.cc: só os
+# grupos de linhas do intervalo de tempo e dos usuários pedidos são lidos.
+#
+#   g++ -O2 -std=c++17 trace-index.cc -o trace-index
+#   from trace_index import query
+#   df = query('RxPacketTrace.txt', t_from=10, t_to=20, rnti=[3, 4])
+#
+# As chaves de cada trace são as colunas cellId e rnti (RxPacketTrace), CellId,
+# IMSI e RNTI (Rlc/PdcpStats), IMSI, CellId e RNTI (CellIdStats), IMSI e CellId
+# (MmWaveSinrTime), SourceCellId e TargetCellId (X2Stats).
+import io
+import os
+import subprocess
+import pandas as pd
+
+TRACE_INDEX = os.environ.get('TRACE_INDEX',
+                             os.path.join(os.path.dirname(os.path.abspath(__file__)), 'trace-index'))
+
+def build(path, bucket=1.0):
+    # Índice de um trace, ou dos traces de um diretório
+    subprocess.run([TRACE_INDEX, 'build', f'--bucket={bucket}', path], check=True)
+
+def query(path, t_from=None, t_to=None, **where):
+    # DataFrame das linhas do trace em [t_from, t_to] com as chaves pedidas; o
+    # índice é construído na primeira consulta
+    args = [TRACE_INDEX, 'query']
+    if t_from is not None:
+        args.append(f'--from={t_from}')
+    if t_to is not None:
+        args.append(f'--to={t_to}')
+    for key, values in where.items():
+        if not isinstance(values, (list, tuple, range)):
+            values = [values]
+        args.append(f'--where={key}=' + ','.join(str(v) for v in values))
+    args.append(path)
+    out = subprocess.run(args, check=True, stdout=subprocess.PIPE).stdout
+    # os traces com cabeçalho (RxPacketTrace, Rlc/PdcpStats) o repetem na saída
+    first = out.split(b'\n', 1)[0].split(b'\t', 1)[0].strip()
+    has_header = first not in (b'', b'DL', b'UL') and not first[:1].isdigit()
+    # as linhas das Rlc/PdcpStats terminam com um tab: sem index_col=False a
+    # coluna vazia a mais faz da primeira coluna o índice e desloca as outras
+    return pd.read_csv(io.BytesIO(out), sep='\t', header=0 if has_header else None,
+                       index_col=False)
@@ -18,6 +18,16 @@
 #include "ns3/mmwave-point-to-point-epc-helper.h"
 #include "ns3/point-to-point-helper.h"
 #include "ns3/global-route-manager.h"
+#include "application-priority.h"
+#include "bat-position-optimizer.h"
+#include "idle-slot-analyzer.h"
+#include "ladder-queue-scheduler.h"
+#include "mmwave-bler-table.h"
+#include "packet-pool-allocator.h"
+#include "profiling-simulator-impl.h"
+#include "simulation-progress-reporter.h"
+#include "steady-state-monitor.h"
+#include "tabulated-antenna-model.h"
 
 using namespace ns3;
 using namespace mmwave;
@@ -49,6 +59,18 @@ main (int argc, char *argv[])
   double frequency = 26.0e9; //Definição da frequencia do cenário
   double simTime = 60; // tempo de simulação
   std::string condition = "l";
+  double antennaTable = 0; // resolução (graus) do padrão 3GPP tabelado (0 = isotrópica)
+  double progress = 0; // intervalo (s de relógio) entre relatórios de progresso, 0 = desativado
+  bool packetPool = false; // alocação de pacotes em pools por tamanho
+  bool profileEvents = false; // perfil do tempo de execução por tipo de evento
+  bool benchmark = false; // imprime o número de eventos executados
+  bool idleSlots = false; // medição dos slots sem dados
+  double autoStop = 0; // largura relativa alvo dos intervalos de confiança, 0 = desativado
+  std::string blerTable = ""; // arquivo com as tabelas SINR->BLER (vazio = desativado)
+  std::string priorities = ""; // classe de prioridade de cada usuário (vazio = bearer padrão)
+  bool optimizePositions = false; // posições dos usuários otimizadas antes da simulação
+  std::string radioMap = ""; // mapa de SINR usado pela otimização das posições (vazio = perda de percurso)
+  bool radioMapLinear = false; // SINR do mapa linear, como nos mapas do RadioEnvironmentMapHelper
 
   // Valores padrão da simulação -- Podem ser alterados indicando a variavel desejada no argumento do inicio da simulação
   CommandLine cmd;
@@ -58,7 +80,25 @@ main (int argc, char *argv[])
   cmd.AddValue ("simTime", "Simulation time", simTime);
   cmd.AddValue ("useEpc", "If enabled use EPC, else use RLC saturation mode", useEpc);
   cmd.AddValue ("condition", "Channel condition, l = LOS, n = NLOS, otherwise the condition is randomly determined", condition);
+  cmd.AddValue ("antennaTable", "If > 0, use the 3GPP element pattern tabulated with this resolution (degrees), else isotropic elements", antennaTable);
+  cmd.AddValue ("progress", "If > 0, report the simulation speed, ETA and memory about every this many wall clock seconds", progress);
+  cmd.AddValue ("packetPool", "If enabled, serve packets, buffers, headers and tags from per-thread size-class pools; needs a build with packet-pool-allocator.cc and -DNS3_PACKET_POOL", packetPool);
+  cmd.AddValue ("blerTable", "File caching the SINR->BLER tables; if set, the tables are validated against the MI error model", blerTable);
+  cmd.AddValue ("idleSlots", "If enabled, write the busy and idle slots of each cell and the events an idle-slot fast-forward would save to IdleSlotStats.txt", idleSlots);
+  cmd.AddValue ("autoStop", "If > 0, stop the simulation once the confidence intervals of the throughput and delay of every flow with traffic have this relative half width", autoStop);
+  cmd.AddValue ("priorities", "Comma separated priority class (high, medium or low) of each UE, e.g. h,l,l,l,m,l,m,m,h,h; if set, the flows of each UE use a dedicated bearer with the QCI of its class and the per-class statistics are written to PriorityClassStats.txt. The class only acts through the QCI: its weight and delay budget are not given to any scheduler", priorities);
+  cmd.AddValue ("optimizePositions", "If enabled, place the UEs with the bat algorithm, using the 3GPP UMa pathloss of the scenario and the priority weights as fitness, before the simulation; the placement is written to BatPositionOptimizer.txt", optimizePositions);
+  cmd.AddValue ("radioMap", "With optimizePositions, file of the SINR (dB) of the UEs over the area (\"x y z sinr\" lines) interpolated in place of the pathloss where it is known. The map is only a surrogate: no short simulation of the candidate placements is run", radioMap);
+  cmd.AddValue ("radioMapLinear", "The SINR of radioMap is linear, as in the radio environment maps written by ns-3", radioMapLinear);
+  cmd.AddValue ("profileEvents", "If enabled, write the execution time and the number of the events of each type to EventProfile.txt", profileEvents);
+  cmd.AddValue ("benchmark", "If enabled, print the number of events executed, for the scheduler benchmark", benchmark);
   cmd.Parse (argc, argv);
+  NS_ABORT_MSG_IF (packetPool && !PoolAllocator::IsBuiltIn (), "packetPool needs a build with packet-pool-allocator.cc and -DNS3_PACKET_POOL");
+  PoolAllocator::Enable (packetPool);
+  if (profileEvents)
+    {
+      GlobalValue::Bind ("SimulatorImplementationType", StringValue ("ns3::ProfilingSimulatorImpl"));
+    }
   
   Time::SetResolution (Time::NS);
   
@@ -82,7 +122,17 @@ main (int argc, char *argv[])
 
    // por padrão, antenas isotrópicas são usadas. Para usar o padrão de radiação 3GPP, use o <ThreeGppAntennaArrayModel>
    // cuidado: é necessária a configuração adequada dos ângulos de rolamento e inclinação
-  Config::SetDefault ("ns3::PhasedArrayModel::AntennaElement", PointerValue (CreateObject<IsotropicAntennaModel> ())); 
+  if (antennaTable > 0)
+    {
+      // padrão 3GPP amostrado uma vez numa grade azimute/inclinação, consultas por interpolação
+      Ptr<TabulatedAntennaModel> element = CreateObject<TabulatedAntennaModel> ();
+      element->SetResolution (antennaTable);
+      Config::SetDefault ("ns3::PhasedArrayModel::AntennaElement", PointerValue (element));
+    }
+  else
+    {
+      Config::SetDefault ("ns3::PhasedArrayModel::AntennaElement", PointerValue (CreateObject<IsotropicAntennaModel> ()));
+    }
 
   Ptr<MmWaveHelper> helper = CreateObject<MmWaveHelper> ();
   
@@ -96,6 +146,15 @@ main (int argc, char *argv[])
     helper->SetChannelConditionModelType ("ns3::NeverLosChannelConditionModel");
   }
   
+  // Parada automática quando as estatísticas convergem
+  Ptr<SteadyStateMonitor> steadyState;
+  Ptr<PriorityClassStats> priorityStats;
+  if (autoStop > 0)
+    {
+      steadyState = CreateObject<SteadyStateMonitor> ();
+      steadyState->SetAttribute ("RelativePrecision", DoubleValue (autoStop));
+    }
+
   // Criação do EPC
   Ipv4Address remoteHostAddr;
   Ptr<Node> remoteHost;
@@ -179,6 +238,35 @@ main (int argc, char *argv[])
   uemobility.SetPositionAllocator (uePositionAlloc);
   uemobility.Install (ueNodes);
   BuildingsHelper::Install (ueNodes);
+
+  // posições otimizadas pelo algoritmo do morcego (batman.py) no lugar das coordenadas
+  // acima: perda de percurso 3GPP UMa do cenário e pesos das classes de prioridade
+  if (optimizePositions)
+    {
+      std::vector<double> weights;
+      if (!priorities.empty ())
+        {
+          for (const ApplicationPriority &c : ApplicationPriority::Parse (priorities))
+            {
+              weights.push_back (c.weight);
+            }
+        }
+      Ptr<BatPositionOptimizer> optimizer = CreateObject<BatPositionOptimizer> ();
+      optimizer->SetAttribute ("Frequency", DoubleValue (frequency));
+      optimizer->SetAttribute ("Bandwidth", DoubleValue (totalBandwidth));
+      optimizer->SetAttribute ("Bounds", BoxValue (Box (0, 100, 0, 100, 0, 10)));
+      optimizer->SetAttribute ("MinUeDistance", DoubleValue (10));
+      optimizer->SetAttribute ("MinEnbDistance", DoubleValue (10));
+      optimizer->SetAttribute ("RadioMap", StringValue (radioMap));
+      optimizer->SetAttribute ("RadioMapLinear", BooleanValue (radioMapLinear));
+      if (condition == "l" || condition == "n")
+        {
+          optimizer->SetAttribute ("LosProbability", DoubleValue (condition == "l" ? 1 : 0));
+        }
+      std::pair<double, double> fitness = optimizer->Optimize (enbNodes, ueNodes, weights);
+      std::cout << "UE positions optimized, fitness " << fitness.first << " -> "
+                << fitness.second << std::endl;
+    }
   // Imprime as coordenadas dos Uenodes
   std::cout << "UE1 position: " << ueNodes.Get (0)->GetObject<MobilityModel> ()->GetPosition () << std::endl;
   std::cout << "UE2 position: " << ueNodes.Get (1)->GetObject<MobilityModel> ()->GetPosition () << std::endl;
@@ -326,7 +414,7 @@ main (int argc, char *argv[])
       dlClient5.SetAttribute("Interval", TimeValue(MilliSeconds(interPacketInterval)));
       dlClient5.SetAttribute("MaxPackets", UintegerValue(1000000));
 
-      UdpClientHelper ulClient5(remoteHostAddr, ulPort + 5);
+      UdpClientHelper ulClient5(remoteHostAddr, ulPort + 4);
       ulClient5.SetAttribute("Interval", TimeValue(MilliSeconds(interPacketInterval)));
       ulClient5.SetAttribute("MaxPackets", UintegerValue(1000000));
 
@@ -413,6 +501,34 @@ main (int argc, char *argv[])
 
       clientApps.Add(dlClient10.Install(remoteHost));
       clientApps.Add(ulClient10.Install(ueNodes.Get(9)));
+
+      if (steadyState)
+        {
+          steadyState->AddFlows (serverApps);
+          steadyState->Start ();
+        }
+
+      // classes de prioridade das aplicações (BATMAN): um bearer dedicado por usuário,
+      // com o QCI da classe, e estatísticas de vazão e atraso por classe
+      if (!priorities.empty ())
+        {
+          std::vector<ApplicationPriority> classes = ApplicationPriority::Parse (priorities);
+          NS_ABORT_MSG_UNLESS (classes.size () == ueNodes.GetN (),
+                               "One priority class per UE is needed");
+          priorityStats = CreateObject<PriorityClassStats> ();
+          for (uint32_t u = 0; u < ueNodes.GetN (); ++u)
+            {
+              // TFT e estatísticas a partir das aplicações instaladas, não da ordem das portas
+              std::pair<Ptr<PacketSink>, Ptr<PacketSink>> flows =
+                PriorityClassStats::FindUeFlows (ueNodes.Get (u), serverApps, clientApps);
+              helper->ActivateDedicatedEpsBearer (ueNetDevices.Get (u),
+                                                  EpsBearer (classes[u].qci),
+                                                  ApplicationPriority::CreateTft (PriorityClassStats::GetPort (flows.first),
+                                                                                  PriorityClassStats::GetPort (flows.second)));
+              priorityStats->AddFlow (flows.first, classes[u], "dl");
+              priorityStats->AddFlow (flows.second, classes[u], "ul");
+            }
+        }
     }
   else
     {
@@ -426,10 +542,58 @@ main (int argc, char *argv[])
   
   helper->EnableTraces ();
   Traces ("./"); // habilitando o uplink tracer
-  
+  Ptr<IdleSlotAnalyzer> idleSlotAnalyzer;
+  if (idleSlots)
+    {
+      idleSlotAnalyzer = CreateObject<IdleSlotAnalyzer> ();
+      idleSlotAnalyzer->Connect (phyMacConfig0);
+    }
+
+  // tabelas de abstração de enlace: carregadas do cache e comparadas com o modelo de erro a cada TB
+  Ptr<MmWaveBlerTable> table;
+  Ptr<MmWaveBlerTableValidator> validator;
+  if (!blerTable.empty ())
+    {
+      table = CreateObject<MmWaveBlerTable> ();
+      table->Load (blerTable);
+      validator = Create<MmWaveBlerTableValidator> (table);
+      validator->Connect ();
+    }
 
   Simulator::Stop (Seconds (simTime)); 
+  Ptr<SimulationProgressReporter> reporter;
+  if (progress > 0)
+    {
+      reporter = CreateObject<SimulationProgressReporter> ();
+      reporter->SetAttribute ("Interval", DoubleValue (progress));
+      reporter->Start (Seconds (simTime));
+    }
   Simulator::Run ();
+  if (benchmark)
+    {
+      std::cout << "Events executed: " << Simulator::GetEventCount () << std::endl;
+    }
+  if (steadyState)
+    {
+      steadyState->Print ();
+    }
+  if (priorityStats)
+    {
+      priorityStats->Print ();
+    }
+  if (idleSlotAnalyzer)
+    {
+      idleSlotAnalyzer->Print ("IdleSlotStats.txt");
+    }
+  if (packetPool)
+    {
+      PoolAllocator::PrintStats ("PoolAllocatorStats.txt");
+    }
+  if (table)
+    {
+      validator->Print ("BlerTableValidation.txt");
+      table->Save (blerTable);
+    }
   Simulator::Destroy ();
   
   //flowMonitor->SerializeToXmlFile("flow5g.xml", true, true);     
@@ -0,0 +1,301 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef APPLICATION_PRIORITY_H
+#define APPLICATION_PRIORITY_H
+
+#include "ns3/applications-module.h"
+#include "ns3/core-module.h"
+#include "ns3/eps-bearer.h"
+#include "ns3/epc-tft.h"
+#include "ns3/network-module.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * The application priority classes of the BATMAN positioning
+ * (ML_Python/batman.py): video, voice and data, with weights 1.0, 0.8 and 0.5.
+ *
+ * Each class is carried by a dedicated EPS bearer whose QCI gives the MAC
+ * scheduler its priority and packet delay budget. In the scenarios this QCI is
+ * the only effect of the class on the scheduling: the weight and the budget can
+ * be given to the priority and deadline terms of MaxWeightKernel (SetPriority,
+ * SetDelayBudget), but the mmWave MAC schedulers do not use that kernel.
+ */
+struct ApplicationPriority
+{
+    std::string name;
+    double weight;
+    EpsBearer::Qci qci;
+
+    /// The packet delay budget of the QCI, in ms
+    double GetDelayBudget() const
+    {
+        return EpsBearer(qci).GetPacketDelayBudgetMs();
+    }
+
+    /**
+     * \param name "high" (or "video", "h"), "medium" ("voice", "m") or "low" ("data", "l")
+     * \return the class
+     */
+    static ApplicationPriority FromName(std::string name)
+    {
+        if (name == "high" || name == "video" || name == "h")
+        {
+            return {"high", 1.0, EpsBearer::GBR_CONV_VIDEO};
+        }
+        if (name == "medium" || name == "voice" || name == "m")
+        {
+            return {"medium", 0.8, EpsBearer::GBR_CONV_VOICE};
+        }
+        NS_ABORT_MSG_UNLESS(name == "low" || name == "data" || name == "l",
+                            "Unknown priority class " << name);
+        return {"low", 0.5, EpsBearer::NGBR_VIDEO_TCP_DEFAULT};
+    }
+
+    /**
+     * \param list comma separated classes, one per UE
+     * \return the classes
+     */
+    static std::vector<ApplicationPriority> Parse(std::string list)
+    {
+        std::vector<ApplicationPriority> priorities;
+        std::stringstream ss(list);
+        std::string name;
+        while (std::getline(ss, name, ','))
+        {
+            priorities.push_back(FromName(name));
+        }
+        return priorities;
+    }
+
+    /**
+     * The traffic filter of the downlink and uplink flows of a UE
+     * \param dlPort the local port of the downlink flow, at the UE
+     * \param ulPort the remote port of the uplink flow
+     * \return the TFT
+     */
+    static Ptr<EpcTft> CreateTft(uint16_t dlPort, uint16_t ulPort)
+    {
+        Ptr<EpcTft> tft = Create<EpcTft>();
+        EpcTft::PacketFilter dl;
+        dl.direction = EpcTft::DOWNLINK;
+        dl.localPortStart = dlPort;
+        dl.localPortEnd = dlPort;
+        tft->Add(dl);
+        EpcTft::PacketFilter ul;
+        ul.direction = EpcTft::UPLINK;
+        ul.remotePortStart = ulPort;
+        ul.remotePortEnd = ulPort;
+        tft->Add(ul);
+        return tft;
+    }
+};
+
+/**
+ * Throughput and delay of the flows of each priority class.
+ *
+ * The delay of a packet comes from the SeqTsHeader of the UdpClient, the
+ * throughput from the bytes received after the start of the measurement. The
+ * report gives, per class and direction, the mean throughput per flow, the mean
+ * delay, its 95th percentile and the fraction of the packets delivered within
+ * the delay budget of the class.
+ */
+class PriorityClassStats : public Object
+{
+  public:
+    static TypeId GetTypeId()
+    {
+        static TypeId tid = TypeId("ns3::PriorityClassStats")
+                                .SetParent<Object>()
+                                .AddConstructor<PriorityClassStats>()
+                                .AddAttribute("FileName",
+                                              "File of the per-class statistics",
+                                              StringValue("PriorityClassStats.txt"),
+                                              MakeStringAccessor(&PriorityClassStats::m_fileName),
+                                              MakeStringChecker());
+        return tid;
+    }
+
+    PriorityClassStats() = default;
+
+    /**
+     * Find the flows of a UE among the installed applications, instead of relying
+     * on the order and the ports of their creation
+     * \param ue the UE
+     * \param servers the PacketSink applications of the UEs and of the remote host
+     * \param clients the UdpClient applications of the UEs and of the remote host
+     * \return the downlink sink (on the UE) and the uplink sink (the one listening on
+     *         the port the UdpClient of the UE sends to)
+     */
+    static std::pair<Ptr<PacketSink>, Ptr<PacketSink>> FindUeFlows(
+        Ptr<Node> ue,
+        const ApplicationContainer& servers,
+        const ApplicationContainer& clients)
+    {
+        Ptr<PacketSink> dl;
+        Ptr<PacketSink> ul;
+        int ulPort = -1;
+        for (uint32_t i = 0; i < clients.GetN(); ++i)
+        {
+            if (clients.Get(i)->GetNode() == ue && DynamicCast<UdpClient>(clients.Get(i)))
+            {
+                UintegerValue port;
+                clients.Get(i)->GetAttribute("RemotePort", port);
+                ulPort = port.Get();
+            }
+        }
+        for (uint32_t i = 0; i < servers.GetN(); ++i)
+        {
+            Ptr<PacketSink> sink = DynamicCast<PacketSink>(servers.Get(i));
+            if (!sink)
+            {
+                continue;
+            }
+            if (sink->GetNode() == ue)
+            {
+                dl = sink;
+            }
+            else if (GetPort(sink) == ulPort)
+            {
+                ul = sink;
+            }
+        }
+        NS_ABORT_MSG_UNLESS(dl && ul, "No downlink or uplink sink for node " << ue->GetId());
+        return {dl, ul};
+    }
+
+    /**
+     * \param sink a PacketSink
+     * \return the port it listens on
+     */
+    static uint16_t GetPort(Ptr<PacketSink> sink)
+    {
+        AddressValue local;
+        sink->GetAttribute("Local", local);
+        return InetSocketAddress::ConvertFrom(local.Get()).GetPort();
+    }
+
+    /**
+     * Measure a flow
+     * \param app the PacketSink of the flow
+     * \param priority the class of the flow
+     * \param direction "dl" or "ul"
+     */
+    void AddFlow(Ptr<Application> app, const ApplicationPriority& priority, std::string direction)
+    {
+        Ptr<PacketSink> sink = DynamicCast<PacketSink>(app);
+        NS_ABORT_MSG_UNLESS(sink, "Not a PacketSink");
+        std::string key = priority.name + "\t" + direction;
+        auto it = std::find_if(m_classes.begin(), m_classes.end(), [&key](const Class& c) {
+            return c.key == key;
+        });
+        if (it == m_classes.end())
+        {
+            m_classes.push_back({key, priority.GetDelayBudget()});
+            it = m_classes.end() - 1;
+        }
+        ++it->flows;
+        sink->TraceConnectWithoutContext(
+            "Rx",
+            MakeBoundCallback(&PriorityClassStats::RxCallback, this, it - m_classes.begin()));
+    }
+
+    /// Start counting the received bytes, e.g. after the warm-up
+    void Start()
+    {
+        m_start = Simulator::Now();
+        for (Class& c : m_classes)
+        {
+            c.bytes = 0;
+            c.delaysMs.clear();
+        }
+    }
+
+    /// Write the statistics of every class
+    void Print()
+    {
+        double duration = (Simulator::Now() - m_start).GetSeconds();
+        std::ofstream out(m_fileName.c_str(), std::ios_base::out | std::ios_base::trunc);
+        out << "class\tdirection\tflows\tpackets\tthroughputPerFlow(Mb/s)\tmeanDelay(ms)"
+               "\tp95Delay(ms)\tbudget(ms)\twithinBudget"
+            << std::endl;
+        for (Class& c : m_classes)
+        {
+            std::vector<double>& d = c.delaysMs;
+            double mean = 0;
+            double p95 = 0;
+            uint64_t within = 0;
+            if (!d.empty())
+            {
+                for (double x : d)
+                {
+                    mean += x;
+                    within += x <= c.budgetMs;
+                }
+                mean /= d.size();
+                std::nth_element(d.begin(), d.begin() + d.size() * 95 / 100, d.end());
+                p95 = d[d.size() * 95 / 100];
+            }
+            out << c.key << "\t" << c.flows << "\t" << d.size() << "\t"
+                << c.bytes * 8 / std::max(duration, 1e-9) / 1e6 / c.flows << "\t" << mean << "\t"
+                << p95 << "\t" << c.budgetMs << "\t"
+                << double(within) / std::max<std::size_t>(d.size(), 1) << std::endl;
+        }
+    }
+
+  private:
+    /// The flows of one class and direction
+    struct Class
+    {
+        std::string key; //!< class and direction
+        double budgetMs;
+        uint32_t flows{0};
+        uint64_t bytes{0};
+        std::vector<double> delaysMs;
+    };
+
+    static void RxCallback(PriorityClassStats* stats,
+                           std::size_t index,
+                           Ptr<const Packet> packet,
+                           const Address& from)
+    {
+        Class& c = stats->m_classes[index];
+        c.bytes += packet->GetSize();
+        SeqTsHeader seqTs;
+        if (packet->GetSize() >= seqTs.GetSerializedSize() && packet->PeekHeader(seqTs))
+        {
+            c.delaysMs.push_back((Simulator::Now() - seqTs.GetTs()).GetSeconds() * 1e3);
+        }
+    }
+
+    std::string m_fileName{"PriorityClassStats.txt"};
+    std::vector<Class> m_classes;
+    Time m_start;
+};
+
+NS_OBJECT_ENSURE_REGISTERED(PriorityClassStats);
+
+} // namespace ns3
+
+#endif /* APPLICATION_PRIORITY_H */
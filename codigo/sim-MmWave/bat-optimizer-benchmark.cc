@@ -0,0 +1,173 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Benchmark of the placement of the UEs of Packet5G by BatPositionOptimizer
+ * against a costly SINR evaluator, standing for a simulation of every
+ * candidate placement: the SINR of the 3GPP UMa model with shadowing and
+ * random LOS condition, after a busy wait of simCost ms per call. The
+ * configurations are:
+ * - full: every candidate is evaluated (no cache, no screening);
+ * - cache: the SINR of the UEs is memoized by position quantized to quantum;
+ * - screening: the cache, and only the candidates whose path loss table
+ *   fitness is within margin of their bat are evaluated;
+ * - radioMap: the screening, with the SINR of a radio map of the area sampled
+ *   every mapStep m by one more evaluation (BatRadioMap.txt) as surrogate.
+ * For each, the evaluations, the cache hit rate, the time spent in and saved
+ * from the evaluator and the fitness reached are printed.
+ *
+ * ./ns3 run "bat-optimizer-benchmark --iterations=200 --simCost=5"
+ */
+
+#include "bat-position-optimizer.h"
+
+#include "ns3/core-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/network-module.h"
+#include "ns3/propagation-module.h"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("BatOptimizerBenchmark");
+
+int
+main(int argc, char* argv[])
+{
+    uint32_t iterations = 200;
+    double simCost = 5;
+    double quantum = 1.0;
+    double margin = 0.05;
+    double mapStep = 2.0;
+    double frequency = 26e9;
+    double bandwidth = 200e6;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("iterations", "Iterations of the bat algorithm", iterations);
+    cmd.AddValue("simCost", "Wall clock cost of an evaluation, in ms", simCost);
+    cmd.AddValue("quantum", "Grid of the SINR cache, in m", quantum);
+    cmd.AddValue("margin", "Screening margin of the surrogate fitness", margin);
+    cmd.AddValue("mapStep", "Distance between two samples of the radio map, in m", mapStep);
+    cmd.AddValue("frequency", "Carrier frequency, in Hz", frequency);
+    cmd.AddValue("bandwidth", "Bandwidth of the noise, in Hz", bandwidth);
+    cmd.Parse(argc, argv);
+
+    // the eNB and the UEs of Packet5G
+    NodeContainer enbNodes;
+    enbNodes.Create(1);
+    NodeContainer ueNodes;
+    ueNodes.Create(10);
+    MobilityHelper mobility;
+    mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+    mobility.Install(enbNodes);
+    mobility.Install(ueNodes);
+    enbNodes.Get(0)->GetObject<MobilityModel>()->SetPosition(Vector(10, 10, 15));
+    const std::vector<Vector> original = {Vector(50, 50, 1.6),
+                                          Vector(100, 100, 1.6),
+                                          Vector(30, 80, 1.6),
+                                          Vector(32, 10, 1.6),
+                                          Vector(90, 44, 1.6),
+                                          Vector(12, 34, 1.6),
+                                          Vector(9, 13, 1.6),
+                                          Vector(34, 34, 1.6),
+                                          Vector(27, 67, 1.6),
+                                          Vector(72, 78, 1.6)};
+
+    Ptr<ThreeGppUmaPropagationLossModel> loss = CreateObject<ThreeGppUmaPropagationLossModel>();
+    loss->SetAttribute("Frequency", DoubleValue(frequency));
+    loss->SetAttribute("ShadowingEnabled", BooleanValue(true));
+    loss->SetChannelConditionModel(CreateObject<ThreeGppUmaChannelConditionModel>());
+    loss->AssignStreams(1);
+    Ptr<MobilityModel> enb = enbNodes.Get(0)->GetObject<MobilityModel>();
+    std::vector<Ptr<ConstantPositionMobilityModel>> probes;
+    const double noise = -174 + 10 * std::log10(bandwidth) + 9;
+    BatPositionOptimizer::SinrEvaluator simulate = [&](const std::vector<Vector>& positions) {
+        auto until = std::chrono::steady_clock::now() +
+                     std::chrono::microseconds(int64_t(simCost * 1000));
+        while (std::chrono::steady_clock::now() < until)
+        {
+        }
+        std::vector<double> sinr;
+        for (std::size_t u = 0; u < positions.size(); ++u)
+        {
+            if (u == probes.size())
+            {
+                probes.push_back(CreateObject<ConstantPositionMobilityModel>());
+            }
+            probes[u]->SetPosition(positions[u]);
+            sinr.push_back(loss->CalcRxPower(30, enb, probes[u]) - noise);
+        }
+        return sinr;
+    };
+
+    std::cout << "config\tcandidates\tscreened\tsimulations\tcacheHitRate\tsimSeconds"
+                 "\tsavedSeconds\twallSeconds\tfitness"
+              << std::endl;
+    for (std::string config : {"full", "cache", "screening", "radioMap"})
+    {
+        for (uint32_t u = 0; u < ueNodes.GetN(); ++u)
+        {
+            ueNodes.Get(u)->GetObject<MobilityModel>()->SetPosition(original[u]);
+        }
+        auto start = std::chrono::steady_clock::now();
+        Ptr<BatPositionOptimizer> optimizer = CreateObject<BatPositionOptimizer>();
+        optimizer->SetAttribute("Iterations", UintegerValue(iterations));
+        optimizer->SetAttribute("Frequency", DoubleValue(frequency));
+        optimizer->SetAttribute("Bandwidth", DoubleValue(bandwidth));
+        optimizer->SetAttribute("Bounds", BoxValue(Box(0, 100, 0, 100, 0, 10)));
+        optimizer->SetAttribute("MinUeDistance", DoubleValue(10));
+        optimizer->SetAttribute("MinEnbDistance", DoubleValue(10));
+        optimizer->SetAttribute("CacheQuantum", DoubleValue(config == "full" ? 0 : quantum));
+        optimizer->SetAttribute("ScreeningMargin",
+                                DoubleValue(config == "full" || config == "cache" ? 1 : margin));
+        optimizer->SetAttribute("FileName", StringValue("BatPositionOptimizer-" + config + ".txt"));
+        optimizer->AssignStreams(2);
+        optimizer->SetSinrEvaluator(simulate);
+        if (config == "radioMap")
+        {
+            std::vector<Vector> grid;
+            for (double y = 0; y <= 100; y += mapStep)
+            {
+                for (double x = 0; x <= 100; x += mapStep)
+                {
+                    grid.push_back(Vector(x, y, 1.6));
+                }
+            }
+            std::vector<double> sinr = simulate(grid);
+            std::ofstream map("BatRadioMap.txt");
+            map << "% x y z sinr(dB)\n";
+            for (std::size_t i = 0; i < grid.size(); ++i)
+            {
+                map << grid[i].x << " " << grid[i].y << " " << grid[i].z << " " << sinr[i] << "\n";
+            }
+            optimizer->SetAttribute("RadioMap", StringValue("BatRadioMap.txt"));
+        }
+        std::pair<double, double> fitness = optimizer->Optimize(enbNodes, ueNodes);
+        double wall =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        const BatPositionOptimizer::EvaluationStats& stats = optimizer->GetEvaluationStats();
+        uint64_t lookups = stats.cacheHits + stats.cacheMisses;
+        std::cout << config << "\t" << stats.candidates << "\t" << stats.screened << "\t"
+                  << stats.simulations << "\t"
+                  << (lookups > 0 ? double(stats.cacheHits) / lookups : 0) << "\t"
+                  << stats.simulationSeconds << "\t" << stats.GetSavedSeconds() << "\t" << wall
+                  << "\t" << fitness.second << std::endl;
+    }
+    return 0;
+}
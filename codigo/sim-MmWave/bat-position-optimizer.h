@@ -0,0 +1,827 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef BAT_POSITION_OPTIMIZER_H
+#define BAT_POSITION_OPTIMIZER_H
+
+#include "fitness-cache.h"
+#include "parallel-worker-pool.h"
+
+#include "ns3/box.h"
+#include "ns3/channel-condition-model.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/core-module.h"
+#include "ns3/node-container.h"
+#include "ns3/propagation-loss-model.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <thread>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * Placement of the UEs of a scenario by the bat algorithm, with the 3GPP path
+ * loss of the scenario as fitness, in place of codigo/ML_Python/batman.py and
+ * of copying its result into the position allocator.
+ *
+ * The fitness of a placement is the sum over the UEs of their priority weight
+ * (ApplicationPriority) times the expected spectral efficiency towards their
+ * best eNB, log2(1 + SNR): the received power is the one of PathlossModel
+ * (e.g. ThreeGppUmaPropagationLossModel, at the Frequency of the scenario,
+ * without shadowing) for a LOS and for a NLOS link, weighted by the TR 38.901
+ * LOS probability of the scenario (or LosProbability), and the noise is the thermal noise over
+ * Bandwidth plus NoiseFigure. The loss models keep caches that are not thread
+ * safe, so before the optimization they are sampled on the simulator thread,
+ * every TableStep of 2D distance, into one table per eNB and UE height; the
+ * fitness then interpolates the tables.
+ *
+ * Every bat is a placement of all the UEs. The positions are kept as flat
+ * arrays, one x and one y array per bat, so the distance and fitness kernels
+ * are branch free loops over contiguous arrays the compiler vectorizes. The
+ * constraints are repaired after every move, as in batman.py: the UEs are kept
+ * at least MinUeDistance apart and MinEnbDistance from every eNB, within Bounds
+ * and, if MaxDisplacement is positive, within that distance of their original
+ * position. The moves of every iteration are drawn on the simulator thread, in
+ * bat order, then the repairs and fitness of the bats run on NumThreads
+ * threads, so the result does not depend on NumThreads.
+ *
+ * The algorithm is the one of Yang (2010), with the loudness and pulse rate of
+ * every bat, the velocities pulled towards the best bat. The first bat is the
+ * original placement, so the result is never worse than it.
+ *
+ * With a RadioMap (e.g. a radio environment map of the scenario, with
+ * RadioMapLinear), the spectral efficiency of a UE in the map is interpolated
+ * from its SINR there instead of the tables. With a SinrEvaluator, a costly function giving the
+ * SINR of every UE of a placement (e.g. a short simulation), the fitness is
+ * the one of the SINR it gives, and the fitness above is only a surrogate to
+ * screen the candidates: the evaluator is called for the candidates whose
+ * surrogate fitness is at least (1 - ScreeningMargin) times the one of their
+ * bat, the others are rejected, and the SINR of every UE is memoized by UE and
+ * position quantized to CacheQuantum, so a placement whose UEs are all known
+ * is not evaluated again. The evaluations, cache hits and the time saved are
+ * in the report. The evaluator is a hook for a caller that can run such
+ * simulations, e.g. a separate process per placement: the scenarios of this
+ * directory set none (the simulator of the scenario cannot run a nested
+ * simulation), so their placements only use the tables and the radio map.
+ */
+class BatPositionOptimizer : public Object
+{
+  public:
+    static TypeId GetTypeId()
+    {
+        static TypeId tid =
+            TypeId("ns3::BatPositionOptimizer")
+                .SetParent<Object>()
+                .AddConstructor<BatPositionOptimizer>()
+                .AddAttribute("Population",
+                              "Number of bats",
+                              UintegerValue(30),
+                              MakeUintegerAccessor(&BatPositionOptimizer::m_population),
+                              MakeUintegerChecker<uint32_t>(1))
+                .AddAttribute("Iterations",
+                              "Number of iterations",
+                              UintegerValue(1000),
+                              MakeUintegerAccessor(&BatPositionOptimizer::m_iterations),
+                              MakeUintegerChecker<uint32_t>())
+                .AddAttribute("MinFrequency",
+                              "Smallest pulse frequency",
+                              DoubleValue(0),
+                              MakeDoubleAccessor(&BatPositionOptimizer::m_fMin),
+                              MakeDoubleChecker<double>())
+                .AddAttribute("MaxFrequency",
+                              "Largest pulse frequency",
+                              DoubleValue(2),
+                              MakeDoubleAccessor(&BatPositionOptimizer::m_fMax),
+                              MakeDoubleChecker<double>())
+                .AddAttribute("Loudness",
+                              "Initial loudness of every bat",
+                              DoubleValue(0.9),
+                              MakeDoubleAccessor(&BatPositionOptimizer::m_loudness0),
+                              MakeDoubleChecker<double>(0, 1))
+                .AddAttribute("PulseRate",
+                              "Final pulse emission rate of every bat",
+                              DoubleValue(0.5),
+                              MakeDoubleAccessor(&BatPositionOptimizer::m_pulseRate0),
+                              MakeDoubleChecker<double>(0, 1))
+                .AddAttribute("Alpha",
+                              "Decrease of the loudness at every improvement",
+                              DoubleValue(0.9),
+                              MakeDoubleAccessor(&BatPositionOptimizer::m_alpha),
+                              MakeDoubleChecker<double>(0, 1))
+                .AddAttribute("Gamma",
+                              "Rate of increase of the pulse rate",
+                              DoubleValue(0.9),
+                              MakeDoubleAccessor(&BatPositionOptimizer::m_gamma),
+                              MakeDoubleChecker<double>(0))
+                .AddAttribute("LocalWalk",
+                              "Largest step of the local walk around the best bat, in m, "
+                              "scaled by the mean loudness",
+                              DoubleValue(2.0),
+                              MakeDoubleAccessor(&BatPositionOptimizer::m_localWalk),
+                              MakeDoubleChecker<double>(0))
+                .AddAttribute("Bounds",
+                              "Area of the UEs (the z bounds are not used)",
+                              BoxValue(Box(0, 500, 0, 500, 0, 100)),
+                              MakeBoxAccessor(&BatPositionOptimizer::m_bounds),
+                              MakeBoxChecker())
+                .AddAttribute("MinUeDistance",
+                              "Smallest distance between two UEs, in m",
+                              DoubleValue(50),
+                              MakeDoubleAccessor(&BatPositionOptimizer::m_minUeDistance),
+                              MakeDoubleChecker<double>(0))
+                .AddAttribute("MinEnbDistance",
+                              "Smallest 2D distance between a UE and an eNB, in m",
+                              DoubleValue(50),
+                              MakeDoubleAccessor(&BatPositionOptimizer::m_minEnbDistance),
+                              MakeDoubleChecker<double>(0))
+                .AddAttribute("MaxDisplacement",
+                              "Largest distance of a UE from its original position, in m "
+                              "(0 for no limit)",
+                              DoubleValue(0),
+                              MakeDoubleAccessor(&BatPositionOptimizer::m_maxDisplacement),
+                              MakeDoubleChecker<double>(0))
+                .AddAttribute("PathlossModel",
+                              "The 3GPP propagation loss model of the scenario",
+                              StringValue("ns3::ThreeGppUmaPropagationLossModel"),
+                              MakeStringAccessor(&BatPositionOptimizer::m_pathlossModel),
+                              MakeStringChecker())
+                .AddAttribute("LosProbability",
+                              "Probability of a LOS link, -1 for the TR 38.901 one of the "
+                              "scenario (1 with AlwaysLosChannelConditionModel, 0 with "
+                              "NeverLosChannelConditionModel)",
+                              DoubleValue(-1),
+                              MakeDoubleAccessor(&BatPositionOptimizer::m_losProbability),
+                              MakeDoubleChecker<double>(-1, 1))
+                .AddAttribute("Frequency",
+                              "Carrier frequency, in Hz",
+                              DoubleValue(28e9),
+                              MakeDoubleAccessor(&BatPositionOptimizer::m_frequency),
+                              MakeDoubleChecker<double>(0))
+                .AddAttribute("Bandwidth",
+                              "Bandwidth of the noise, in Hz",
+                              DoubleValue(1e9),
+                              MakeDoubleAccessor(&BatPositionOptimizer::m_bandwidth),
+                              MakeDoubleChecker<double>(0))
+                .AddAttribute("TxPower",
+                              "Transmission power of the eNBs, in dBm",
+                              DoubleValue(30),
+                              MakeDoubleAccessor(&BatPositionOptimizer::m_txPower),
+                              MakeDoubleChecker<double>())
+                .AddAttribute("NoiseFigure",
+                              "Noise figure of the UEs, in dB",
+                              DoubleValue(9),
+                              MakeDoubleAccessor(&BatPositionOptimizer::m_noiseFigure),
+                              MakeDoubleChecker<double>())
+                .AddAttribute("TableStep",
+                              "2D distance between two samples of the spectral efficiency "
+                              "tables, in m",
+                              DoubleValue(0.5),
+                              MakeDoubleAccessor(&BatPositionOptimizer::m_tableStep),
+                              MakeDoubleChecker<double>(0.01))
+                .AddAttribute("RadioMap",
+                              "Radio map of the SINR of the UEs, \"x y z sinr\" or "
+                              "\"ue x y z sinr\" lines (empty for none)",
+                              StringValue(""),
+                              MakeStringAccessor(&BatPositionOptimizer::m_radioMapFile),
+                              MakeStringChecker())
+                .AddAttribute("RadioMapLinear",
+                              "The SINR of the RadioMap is linear, as in the maps of the ns-3 "
+                              "RadioEnvironmentMapHelper, instead of in dB",
+                              BooleanValue(false),
+                              MakeBooleanAccessor(&BatPositionOptimizer::m_radioMapLinear),
+                              MakeBooleanChecker())
+                .AddAttribute("CacheQuantum",
+                              "Grid of the positions of the SINR cache of the evaluator, in m "
+                              "(0 for no cache)",
+                              DoubleValue(1.0),
+                              MakeDoubleAccessor(&BatPositionOptimizer::m_cacheQuantum),
+                              MakeDoubleChecker<double>(0))
+                .AddAttribute("ScreeningMargin",
+                              "Relative margin below the surrogate fitness of a bat of the "
+                              "candidates still evaluated (1 to evaluate them all)",
+                              DoubleValue(0.05),
+                              MakeDoubleAccessor(&BatPositionOptimizer::m_screeningMargin),
+                              MakeDoubleChecker<double>(0, 1))
+                .AddAttribute("NumThreads",
+                              "Number of threads evaluating the bats (0 for all the cores)",
+                              UintegerValue(0),
+                              MakeUintegerAccessor(&BatPositionOptimizer::m_nThreads),
+                              MakeUintegerChecker<uint32_t>())
+                .AddAttribute("FileName",
+                              "Report of the optimization (empty for none)",
+                              StringValue("BatPositionOptimizer.txt"),
+                              MakeStringAccessor(&BatPositionOptimizer::m_fileName),
+                              MakeStringChecker());
+        return tid;
+    }
+
+    /// SINR of every UE, in dB, at the positions given, in UE order
+    typedef std::function<std::vector<double>(const std::vector<Vector>&)> SinrEvaluator;
+
+    /// Counters of the evaluations of the last optimization
+    struct EvaluationStats
+    {
+        uint64_t candidates{0};       //!< placements evaluated by the surrogate
+        uint64_t screened{0};         //!< candidates rejected by the surrogate
+        uint64_t requests{0};         //!< placements given the SINR of the evaluator
+        uint64_t simulations{0};      //!< calls of the evaluator
+        uint64_t cacheHits{0};        //!< UEs whose SINR was memoized
+        uint64_t cacheMisses{0};      //!< UEs whose SINR was not
+        double simulationSeconds{0};  //!< time spent in the evaluator
+
+        /// \return the time the evaluator would have taken for every candidate, less the spent
+        double GetSavedSeconds() const
+        {
+            return simulations > 0
+                       ? simulationSeconds / simulations * (candidates - simulations)
+                       : 0;
+        }
+    };
+
+    BatPositionOptimizer()
+        : m_rng(CreateObject<UniformRandomVariable>())
+    {
+    }
+
+    /**
+     * Set the evaluator of the SINR of the placements, called on the simulator
+     * thread; without one, the fitness is the one of the path loss tables
+     */
+    void SetSinrEvaluator(SinrEvaluator evaluator)
+    {
+        m_evaluator = evaluator;
+    }
+
+    /**
+     * Assign a fixed random variable stream number
+     * \return the number of streams used
+     */
+    int64_t AssignStreams(int64_t stream)
+    {
+        m_rng->SetStream(stream);
+        return 1;
+    }
+
+    /**
+     * Optimize the positions of the UEs and move them there, before Simulator::Run ()
+     * \param enbs the eNBs, with their mobility models
+     * \param ues the UEs, with their mobility models at the original positions
+     * \param weights the priority weight of every UE, empty for 1
+     * \return the fitness of the original and of the optimized placement
+     */
+    std::pair<double, double> Optimize(const NodeContainer& enbs,
+                                       const NodeContainer& ues,
+                                       std::vector<double> weights = {})
+    {
+        m_nUes = ues.GetN();
+        NS_ABORT_MSG_UNLESS(m_nUes > 0 && enbs.GetN() > 0, "No UE or no eNB to place");
+        NS_ABORT_MSG_UNLESS(weights.empty() || weights.size() == m_nUes,
+                            "One priority weight per UE");
+        m_weights = weights.empty() ? std::vector<double>(m_nUes, 1.0) : weights;
+        m_enbX.clear();
+        m_enbY.clear();
+        for (uint32_t e = 0; e < enbs.GetN(); ++e)
+        {
+            Vector p = enbs.Get(e)->GetObject<MobilityModel>()->GetPosition();
+            m_enbX.push_back(p.x);
+            m_enbY.push_back(p.y);
+        }
+        m_originalX.assign(m_nUes, 0);
+        m_originalY.assign(m_nUes, 0);
+        m_ueZ.assign(m_nUes, 0);
+        for (uint32_t u = 0; u < m_nUes; ++u)
+        {
+            Vector p = ues.Get(u)->GetObject<MobilityModel>()->GetPosition();
+            m_originalX[u] = p.x;
+            m_originalY[u] = p.y;
+            m_ueZ[u] = p.z;
+        }
+        BuildTables(enbs);
+        m_radioMap = RadioMapSurrogate();
+        NS_ABORT_MSG_UNLESS(m_radioMapFile.empty() ||
+                                m_radioMap.Load(m_radioMapFile, m_radioMapLinear),
+                            "Cannot read the radio map " << m_radioMapFile);
+
+        std::vector<double> best = Run();
+        for (uint32_t u = 0; u < m_nUes; ++u)
+        {
+            ues.Get(u)->GetObject<MobilityModel>()->SetPosition(
+                Vector(best[u], best[m_nUes + u], m_ueZ[u]));
+        }
+        Report(best);
+        return {m_originalFitness, m_bestFitness};
+    }
+
+    /// \return the best fitness after every iteration
+    const std::vector<double>& GetFitnessHistory() const
+    {
+        return m_history;
+    }
+
+    /// \return the counters of the evaluations of the last optimization
+    const EvaluationStats& GetEvaluationStats() const
+    {
+        return m_stats;
+    }
+
+  protected:
+    void DoDispose() override
+    {
+        m_rng = nullptr;
+        m_evaluator = nullptr;
+        Object::DoDispose();
+    }
+
+  private:
+    /// TR 38.901 Table 7.4.2-1 LOS probability of the scenario of the loss model
+    double GetLosProbability(double d2D, double hUt) const
+    {
+        if (m_losProbability >= 0)
+        {
+            return m_losProbability;
+        }
+        if (m_pathlossModel.find("Rma") != std::string::npos)
+        {
+            return d2D <= 10 ? 1 : std::exp(-(d2D - 10) / 1000);
+        }
+        if (m_pathlossModel.find("Umi") != std::string::npos)
+        {
+            return d2D <= 18 ? 1 : 18 / d2D + std::exp(-d2D / 36) * (1 - 18 / d2D);
+        }
+        if (m_pathlossModel.find("Uma") != std::string::npos)
+        {
+            if (d2D <= 18)
+            {
+                return 1;
+            }
+            double c = hUt <= 13 ? 0 : std::pow((hUt - 13) / 10, 1.5);
+            return (18 / d2D + std::exp(-d2D / 63) * (1 - 18 / d2D)) *
+                   (1 + c * 5.0 / 4 * std::pow(d2D / 100, 3) * std::exp(-d2D / 150));
+        }
+        // indoor or unknown: the LOS loss only
+        return 1;
+    }
+
+    /// Sample the expected spectral efficiency of every eNB and UE height over the 2D distance
+    void BuildTables(const NodeContainer& enbs)
+    {
+        double dx = m_bounds.xMax - m_bounds.xMin;
+        double dy = m_bounds.yMax - m_bounds.yMin;
+        double maxDistance = std::sqrt(dx * dx + dy * dy);
+        for (uint32_t e = 0; e < m_enbX.size(); ++e)
+        {
+            Vector p = enbs.Get(e)->GetObject<MobilityModel>()->GetPosition();
+            maxDistance = std::max({maxDistance,
+                                    std::hypot(p.x - m_bounds.xMin, p.y - m_bounds.yMin),
+                                    std::hypot(p.x - m_bounds.xMax, p.y - m_bounds.yMin),
+                                    std::hypot(p.x - m_bounds.xMin, p.y - m_bounds.yMax),
+                                    std::hypot(p.x - m_bounds.xMax, p.y - m_bounds.yMax)});
+        }
+        m_tableSize = uint32_t(std::ceil(maxDistance / m_tableStep)) + 2;
+
+        ObjectFactory factory(m_pathlossModel);
+        factory.Set("Frequency", DoubleValue(m_frequency));
+        factory.Set("ShadowingEnabled", BooleanValue(false));
+        factory.Set("ChannelConditionModel",
+                    PointerValue(CreateObject<AlwaysLosChannelConditionModel>()));
+        Ptr<PropagationLossModel> los = factory.Create<PropagationLossModel>();
+        factory.Set("ChannelConditionModel",
+                    PointerValue(CreateObject<NeverLosChannelConditionModel>()));
+        Ptr<PropagationLossModel> nlos = factory.Create<PropagationLossModel>();
+        double noise = -174 + 10 * std::log10(m_bandwidth) + m_noiseFigure;
+
+        Ptr<ConstantPositionMobilityModel> enb = CreateObject<ConstantPositionMobilityModel>();
+        Ptr<ConstantPositionMobilityModel> ue = CreateObject<ConstantPositionMobilityModel>();
+        std::map<std::pair<uint32_t, double>, uint32_t> tables;
+        m_tables.clear();
+        m_tableOf.assign(m_enbX.size() * m_nUes, 0);
+        for (uint32_t e = 0; e < m_enbX.size(); ++e)
+        {
+            Vector p = enbs.Get(e)->GetObject<MobilityModel>()->GetPosition();
+            enb->SetPosition(p);
+            for (uint32_t u = 0; u < m_nUes; ++u)
+            {
+                auto it = tables.find({e, m_ueZ[u]});
+                if (it != tables.end())
+                {
+                    m_tableOf[e * m_nUes + u] = it->second;
+                    continue;
+                }
+                std::vector<double> table(m_tableSize);
+                for (uint32_t i = 0; i < m_tableSize; ++i)
+                {
+                    double d = i * m_tableStep;
+                    ue->SetPosition(Vector(p.x + d, p.y, m_ueZ[u]));
+                    double pLos = std::min(1.0, GetLosProbability(d, m_ueZ[u]));
+                    double snrLos = los->CalcRxPower(m_txPower, enb, ue) - noise;
+                    double snrNlos = nlos->CalcRxPower(m_txPower, enb, ue) - noise;
+                    table[i] = pLos * std::log2(1 + std::pow(10, snrLos / 10)) +
+                               (1 - pLos) * std::log2(1 + std::pow(10, snrNlos / 10));
+                }
+                tables[{e, m_ueZ[u]}] = m_tables.size();
+                m_tableOf[e * m_nUes + u] = m_tables.size();
+                m_tables.push_back(std::move(table));
+            }
+        }
+    }
+
+    /**
+     * Fitness of a placement by the tables, or the radio map
+     * \param x the x of every UE
+     * \param y the y of every UE
+     * \param scratch array of 2 nUes
+     */
+    double Fitness(const double* x, const double* y, double* scratch) const
+    {
+        double* distance = scratch;
+        double* best = scratch + m_nUes;
+        std::fill_n(best, m_nUes, 0.0);
+        for (uint32_t e = 0; e < m_enbX.size(); ++e)
+        {
+            const double ex = m_enbX[e];
+            const double ey = m_enbY[e];
+            for (uint32_t u = 0; u < m_nUes; ++u)
+            {
+                double dx = x[u] - ex;
+                double dy = y[u] - ey;
+                distance[u] = std::sqrt(dx * dx + dy * dy);
+            }
+            for (uint32_t u = 0; u < m_nUes; ++u)
+            {
+                const std::vector<double>& table = m_tables[m_tableOf[e * m_nUes + u]];
+                double position = std::min(distance[u] / m_tableStep, double(m_tableSize - 1));
+                uint32_t i = std::min(uint32_t(position), m_tableSize - 2);
+                double f = position - i;
+                best[u] = std::max(best[u], table[i] + f * (table[i + 1] - table[i]));
+            }
+        }
+        if (!m_radioMapFile.empty())
+        {
+            for (uint32_t u = 0; u < m_nUes; ++u)
+            {
+                double sinr = m_radioMap.GetSinr(u, x[u], y[u]);
+                if (!std::isnan(sinr))
+                {
+                    best[u] = std::log2(1 + std::pow(10, sinr / 10));
+                }
+            }
+        }
+        double fitness = 0;
+        for (uint32_t u = 0; u < m_nUes; ++u)
+        {
+            fitness += m_weights[u] * best[u];
+        }
+        return fitness;
+    }
+
+    /// Fitness of a placement by the SINR of the evaluator, memoized
+    double SimulatedFitness(const double* x, const double* y)
+    {
+        ++m_stats.requests;
+        bool known = true;
+        for (uint32_t u = 0; u < m_nUes; ++u)
+        {
+            known = m_cache.Lookup(u, x[u], y[u], m_sinr[u]) && known;
+        }
+        if (!known)
+        {
+            std::vector<Vector> positions(m_nUes);
+            for (uint32_t u = 0; u < m_nUes; ++u)
+            {
+                positions[u] = Vector(x[u], y[u], m_ueZ[u]);
+            }
+            auto start = std::chrono::steady_clock::now();
+            std::vector<double> sinr = m_evaluator(positions);
+            m_stats.simulationSeconds +=
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            ++m_stats.simulations;
+            NS_ABORT_MSG_UNLESS(sinr.size() == m_nUes, "The evaluator gives one SINR per UE");
+            for (uint32_t u = 0; u < m_nUes; ++u)
+            {
+                m_sinr[u] = sinr[u];
+                m_cache.Insert(u, x[u], y[u], sinr[u]);
+            }
+        }
+        double fitness = 0;
+        for (uint32_t u = 0; u < m_nUes; ++u)
+        {
+            fitness += m_weights[u] * std::log2(1 + std::pow(10, m_sinr[u] / 10));
+        }
+        return fitness;
+    }
+
+    /// Repair the constraints of a placement, in place
+    void Repair(double* x, double* y) const
+    {
+        const uint32_t n = m_nUes;
+        if (m_maxDisplacement > 0)
+        {
+            for (uint32_t u = 0; u < n; ++u)
+            {
+                double dx = x[u] - m_originalX[u];
+                double dy = y[u] - m_originalY[u];
+                double d = std::sqrt(dx * dx + dy * dy);
+                double scale = d > m_maxDisplacement ? m_maxDisplacement / d : 1.0;
+                x[u] = m_originalX[u] + dx * scale;
+                y[u] = m_originalY[u] + dy * scale;
+            }
+        }
+        // the UEs too close are pushed apart, half the missing distance each
+        for (uint32_t j = 0; j < n; ++j)
+        {
+            for (uint32_t k = j + 1; k < n; ++k)
+            {
+                double dx = x[j] - x[k];
+                double dy = y[j] - y[k];
+                double d = std::sqrt(dx * dx + dy * dy);
+                if (d >= m_minUeDistance)
+                {
+                    continue;
+                }
+                if (d == 0)
+                {
+                    dx = 1;
+                    d = 1;
+                }
+                double push = (m_minUeDistance - d) / 2 / d;
+                x[j] += dx * push;
+                y[j] += dy * push;
+                x[k] -= dx * push;
+                y[k] -= dy * push;
+            }
+        }
+        for (uint32_t e = 0; e < m_enbX.size(); ++e)
+        {
+            for (uint32_t u = 0; u < n; ++u)
+            {
+                double dx = x[u] - m_enbX[e];
+                double dy = y[u] - m_enbY[e];
+                double d = std::sqrt(dx * dx + dy * dy);
+                if (d >= m_minEnbDistance)
+                {
+                    continue;
+                }
+                if (d == 0)
+                {
+                    dx = 1;
+                    d = 1;
+                }
+                x[u] = m_enbX[e] + dx * m_minEnbDistance / d;
+                y[u] = m_enbY[e] + dy * m_minEnbDistance / d;
+            }
+        }
+        for (uint32_t u = 0; u < n; ++u)
+        {
+            x[u] = std::min(std::max(x[u], m_bounds.xMin), m_bounds.xMax);
+            y[u] = std::min(std::max(y[u], m_bounds.yMin), m_bounds.yMax);
+        }
+    }
+
+    /// \return the best placement, the x of every UE then the y of every UE
+    std::vector<double> Run()
+    {
+        const uint32_t n = m_nUes;
+        const uint32_t nBats = m_population;
+        const std::size_t stride = 2 * n;
+        // every bat: x[n] then y[n]
+        std::vector<double> position(nBats * stride);
+        std::vector<double> velocity(nBats * stride, 0);
+        std::vector<double> candidate(nBats * stride);
+        std::vector<double> fitness(nBats);
+        std::vector<double> candidateFitness(nBats);
+        // with an evaluator, the fitness of the tables screens the candidates
+        const bool simulated = bool(m_evaluator);
+        std::vector<double> surrogate(nBats);
+        std::vector<double> candidateSurrogate(nBats);
+        std::vector<double> loudness(nBats, m_loudness0);
+        std::vector<double> pulseRate(nBats, m_pulseRate0);
+        std::vector<std::vector<double>> scratch(nBats, std::vector<double>(2 * n));
+        WorkerPool pool(m_nThreads > 0 ? m_nThreads
+                                       : std::max(1u, std::thread::hardware_concurrency()));
+
+        // the first bat is the original placement, the others are drawn in the bounds
+        for (uint32_t b = 0; b < nBats; ++b)
+        {
+            double* p = &position[b * stride];
+            for (uint32_t u = 0; u < n; ++u)
+            {
+                p[u] = b == 0 ? m_originalX[u] : m_rng->GetValue(m_bounds.xMin, m_bounds.xMax);
+                p[n + u] =
+                    b == 0 ? m_originalY[u] : m_rng->GetValue(m_bounds.yMin, m_bounds.yMax);
+            }
+        }
+        m_stats = EvaluationStats();
+        m_cache.SetQuantum(m_cacheQuantum);
+        m_sinr.assign(n, 0);
+        pool.ParallelFor(nBats, [&](std::size_t b) {
+            double* p = &position[b * stride];
+            if (b > 0)
+            {
+                Repair(p, p + n);
+            }
+            surrogate[b] = Fitness(p, p + n, scratch[b].data());
+        });
+        m_stats.candidates += nBats;
+        for (uint32_t b = 0; b < nBats; ++b)
+        {
+            double* p = &position[b * stride];
+            fitness[b] = simulated ? SimulatedFitness(p, p + n) : surrogate[b];
+        }
+        m_originalFitness = fitness[0];
+        uint32_t bestBat =
+            std::max_element(fitness.begin(), fitness.end()) - fitness.begin();
+        // the original placement may break the constraints; it is kept if it is the best
+        std::vector<double> best(position.begin() + bestBat * stride,
+                                 position.begin() + (bestBat + 1) * stride);
+        m_bestFitness = fitness[bestBat];
+        m_history.clear();
+
+        const double maxSpeed =
+            std::max(m_bounds.xMax - m_bounds.xMin, m_bounds.yMax - m_bounds.yMin);
+        for (uint32_t t = 1; t <= m_iterations; ++t)
+        {
+            double meanLoudness = 0;
+            for (double a : loudness)
+            {
+                meanLoudness += a / nBats;
+            }
+            // the moves, drawn in bat order
+            for (uint32_t b = 0; b < nBats; ++b)
+            {
+                double* p = &position[b * stride];
+                double* v = &velocity[b * stride];
+                double* c = &candidate[b * stride];
+                double f = m_fMin + (m_fMax - m_fMin) * m_rng->GetValue();
+                bool local = m_rng->GetValue() > pulseRate[b];
+                for (std::size_t i = 0; i < stride; ++i)
+                {
+                    double walk = m_rng->GetValue(-1, 1);
+                    v[i] = std::min(std::max(v[i] + (best[i] - p[i]) * f, -maxSpeed), maxSpeed);
+                    c[i] = local ? best[i] + walk * meanLoudness * m_localWalk : p[i] + v[i];
+                }
+            }
+            pool.ParallelFor(nBats, [&](std::size_t b) {
+                double* c = &candidate[b * stride];
+                Repair(c, c + n);
+                candidateSurrogate[b] = Fitness(c, c + n, scratch[b].data());
+            });
+            m_stats.candidates += nBats;
+            for (uint32_t b = 0; b < nBats; ++b)
+            {
+                double* c = &candidate[b * stride];
+                candidateFitness[b] = candidateSurrogate[b];
+                if (simulated)
+                {
+                    if (candidateSurrogate[b] >= (1 - m_screeningMargin) * surrogate[b])
+                    {
+                        candidateFitness[b] = SimulatedFitness(c, c + n);
+                    }
+                    else
+                    {
+                        ++m_stats.screened;
+                        candidateFitness[b] = -INFINITY;
+                    }
+                }
+            }
+            for (uint32_t b = 0; b < nBats; ++b)
+            {
+                double accept = m_rng->GetValue();
+                if (candidateFitness[b] >= fitness[b] && accept < loudness[b])
+                {
+                    std::copy_n(&candidate[b * stride], stride, &position[b * stride]);
+                    fitness[b] = candidateFitness[b];
+                    surrogate[b] = candidateSurrogate[b];
+                    loudness[b] *= m_alpha;
+                    pulseRate[b] = m_pulseRate0 * (1 - std::exp(-m_gamma * t));
+                }
+                if (candidateFitness[b] > m_bestFitness)
+                {
+                    m_bestFitness = candidateFitness[b];
+                    best.assign(&candidate[b * stride], &candidate[b * stride] + stride);
+                }
+            }
+            m_history.push_back(m_bestFitness);
+        }
+        m_stats.cacheHits = m_cache.GetHits();
+        m_stats.cacheMisses = m_cache.GetMisses();
+        return best;
+    }
+
+    void Report(const std::vector<double>& best) const
+    {
+        if (m_fileName.empty())
+        {
+            return;
+        }
+        std::ofstream out(m_fileName.c_str(), std::ios_base::out | std::ios_base::trunc);
+        out << "# " << m_pathlossModel << " at " << m_frequency / 1e9 << " GHz, "
+            << m_population << " bats, " << m_iterations << " iterations, fitness "
+            << m_originalFitness << " -> " << m_bestFitness << " (weighted b/s/Hz)\n";
+        if (!m_radioMapFile.empty())
+        {
+            out << "# radio map " << m_radioMapFile << "\n";
+        }
+        if (m_evaluator)
+        {
+            uint64_t lookups = m_stats.cacheHits + m_stats.cacheMisses;
+            out << "# " << m_stats.candidates << " candidates, " << m_stats.screened
+                << " screened out, " << m_stats.requests << " evaluated, "
+                << m_stats.simulations << " simulated in " << m_stats.simulationSeconds
+                << " s, cache hit rate " << (lookups > 0 ? double(m_stats.cacheHits) / lookups : 0)
+                << " (" << m_cache.GetSize() << " positions), about "
+                << m_stats.GetSavedSeconds() << " s saved\n";
+        }
+        out << "ue\tweight\tx\ty\toptimizedX\toptimizedY\tdisplacement(m)\tenbDistance(m)"
+               "\toptimizedEnbDistance(m)\n";
+        for (uint32_t u = 0; u < m_nUes; ++u)
+        {
+            double before = INFINITY;
+            double after = INFINITY;
+            for (uint32_t e = 0; e < m_enbX.size(); ++e)
+            {
+                before = std::min(
+                    before,
+                    std::hypot(m_originalX[u] - m_enbX[e], m_originalY[u] - m_enbY[e]));
+                after = std::min(after,
+                                 std::hypot(best[u] - m_enbX[e], best[m_nUes + u] - m_enbY[e]));
+            }
+            out << u + 1 << "\t" << m_weights[u] << "\t" << m_originalX[u] << "\t"
+                << m_originalY[u] << "\t" << best[u] << "\t" << best[m_nUes + u] << "\t"
+                << std::hypot(best[u] - m_originalX[u], best[m_nUes + u] - m_originalY[u])
+                << "\t" << before << "\t" << after << "\n";
+        }
+    }
+
+    uint32_t m_population{30};
+    uint32_t m_iterations{1000};
+    double m_fMin{0};
+    double m_fMax{2};
+    double m_loudness0{0.9};
+    double m_pulseRate0{0.5};
+    double m_alpha{0.9};
+    double m_gamma{0.9};
+    double m_localWalk{2.0};
+    Box m_bounds{0, 500, 0, 500, 0, 100};
+    double m_minUeDistance{50};
+    double m_minEnbDistance{50};
+    double m_maxDisplacement{0};
+    std::string m_pathlossModel{"ns3::ThreeGppUmaPropagationLossModel"};
+    double m_losProbability{-1};
+    double m_frequency{28e9};
+    double m_bandwidth{1e9};
+    double m_txPower{30};
+    double m_noiseFigure{9};
+    double m_tableStep{0.5};
+    std::string m_radioMapFile;
+    bool m_radioMapLinear{false};
+    double m_cacheQuantum{1.0};
+    double m_screeningMargin{0.05};
+    uint32_t m_nThreads{0};
+    std::string m_fileName{"BatPositionOptimizer.txt"};
+    Ptr<UniformRandomVariable> m_rng;
+
+    uint32_t m_nUes{0};
+    std::vector<double> m_weights;
+    std::vector<double> m_enbX;
+    std::vector<double> m_enbY;
+    std::vector<double> m_originalX;
+    std::vector<double> m_originalY;
+    std::vector<double> m_ueZ;
+    std::vector<std::vector<double>> m_tables; //!< spectral efficiency by 2D distance
+    std::vector<uint32_t> m_tableOf;           //!< by eNB, by UE, the index in m_tables
+    uint32_t m_tableSize{0};
+    RadioMapSurrogate m_radioMap;
+    SinrEvaluator m_evaluator;
+    PositionFitnessCache m_cache;
+    std::vector<double> m_sinr; //!< SINR of every UE of the placement evaluated
+    EvaluationStats m_stats;
+    double m_originalFitness{0};
+    double m_bestFitness{0};
+    std::vector<double> m_history;
+};
+
+NS_OBJECT_ENSURE_REGISTERED(BatPositionOptimizer);
+
+} // namespace ns3
+
+#endif /* BAT_POSITION_OPTIMIZER_H */
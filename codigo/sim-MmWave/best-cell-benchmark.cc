@@ -0,0 +1,150 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Benchmark of the best cell selection of the DYNAMIC_TTT secondary cell
+ * handover: the incremental per-UE heaps of BestCellTracker against the scan
+ * of the SINR map of every UE at every report table period
+ * (BestCellReference), for growing numbers of mmWave cells and
+ * multi-connectivity UEs. At every period, each SINR entry changes with
+ * probability changeProbability (a new report from that cell); the best and
+ * second best cells of every UE are then queried and compared.
+ *
+ * ./ns3 run "best-cell-benchmark --nPeriods=1000 --cellCounts=4,64,256"
+ */
+
+#include "best-cell-tracker.h"
+
+#include "ns3/core-module.h"
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <tuple>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("BestCellBenchmark");
+
+/// Parse a comma separated list of numbers
+static std::vector<uint32_t>
+ParseCounts(std::string list)
+{
+    std::vector<uint32_t> counts;
+    std::stringstream ss(list);
+    std::string count;
+    while (std::getline(ss, count, ','))
+    {
+        counts.push_back(std::stoul(count));
+    }
+    return counts;
+}
+
+int
+main(int argc, char* argv[])
+{
+    uint32_t nPeriods = 1000;
+    double changeProbability = 0.1;
+    std::string cellCounts = "4,16,64,256";
+    std::string ueCounts = "10,100,300";
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("nPeriods", "Report table periods simulated for every configuration", nPeriods);
+    cmd.AddValue("changeProbability",
+                 "Probability that the SINR of a UE towards a cell changes in a period",
+                 changeProbability);
+    cmd.AddValue("cellCounts", "Comma separated numbers of mmWave cells", cellCounts);
+    cmd.AddValue("ueCounts", "Comma separated numbers of UEs", ueCounts);
+    cmd.Parse(argc, argv);
+
+    Ptr<UniformRandomVariable> uniform = CreateObject<UniformRandomVariable>();
+    std::cout << "nCells\tnUes\tscanNsPerPeriod\theapNsPerPeriod\tspeedup\tupdates" << std::endl;
+
+    for (uint32_t nCells : ParseCounts(cellCounts))
+    {
+        for (uint32_t nUes : ParseCounts(ueCounts))
+        {
+            BestCellTracker tracker;
+            BestCellReference reference;
+            // cell IDs from 2, as in the scenario, where cell 1 is the LTE eNB
+            for (uint64_t imsi = 1; imsi <= nUes; ++imsi)
+            {
+                for (uint16_t cellId = 2; cellId < nCells + 2; ++cellId)
+                {
+                    double sinr = uniform->GetValue(0, 1000);
+                    tracker.Update(imsi, cellId, sinr);
+                    reference.m_sinr[imsi][cellId] = sinr;
+                }
+            }
+
+            double scanNs = 0;
+            double heapNs = 0;
+            uint64_t nUpdates = 0;
+            std::vector<std::tuple<uint64_t, uint16_t, double>> updates;
+            for (uint32_t period = 0; period < nPeriods; ++period)
+            {
+                // the reports are drawn in advance, so only the bookkeeping is timed
+                updates.clear();
+                for (uint64_t imsi = 1; imsi <= nUes; ++imsi)
+                {
+                    for (uint16_t cellId = 2; cellId < nCells + 2; ++cellId)
+                    {
+                        if (uniform->GetValue() < changeProbability)
+                        {
+                            updates.emplace_back(imsi, cellId, uniform->GetValue(0, 1000));
+                        }
+                    }
+                }
+                nUpdates += updates.size();
+
+                std::vector<std::pair<std::pair<uint16_t, double>, std::pair<uint16_t, double>>>
+                    expected(nUes + 1);
+                auto start = std::chrono::steady_clock::now();
+                for (const auto& u : updates)
+                {
+                    reference.m_sinr[std::get<0>(u)][std::get<1>(u)] = std::get<2>(u);
+                }
+                for (uint64_t imsi = 1; imsi <= nUes; ++imsi)
+                {
+                    expected[imsi] = reference.Scan(imsi);
+                }
+                auto middle = std::chrono::steady_clock::now();
+                for (const auto& u : updates)
+                {
+                    tracker.Update(std::get<0>(u), std::get<1>(u), std::get<2>(u));
+                }
+                bool same = true;
+                for (uint64_t imsi = 1; imsi <= nUes; ++imsi)
+                {
+                    same &= tracker.GetBest(imsi) == expected[imsi].first &&
+                            tracker.GetSecondBest(imsi) == expected[imsi].second;
+                }
+                auto end = std::chrono::steady_clock::now();
+                scanNs += std::chrono::duration<double, std::nano>(middle - start).count();
+                heapNs += std::chrono::duration<double, std::nano>(end - middle).count();
+                NS_ABORT_MSG_UNLESS(same,
+                                    "Different best cells with " << nCells << " cells and "
+                                                                 << nUes << " UEs");
+            }
+
+            std::cout << nCells << "\t" << nUes << "\t" << scanNs / nPeriods << "\t"
+                      << heapNs / nPeriods << "\t" << scanNs / heapNs << "\t" << nUpdates
+                      << std::endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,246 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef BEST_CELL_TRACKER_H
+#define BEST_CELL_TRACKER_H
+
+#include "ns3/assert.h"
+
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ns3
+{
+
+/// No cell, returned when a UE has fewer SINR entries than asked
+static const uint16_t BEST_CELL_NONE = 0;
+
+/**
+ * Best and second best mmWave cell of every UE, maintained incrementally.
+ *
+ * The LTE eNB of the multi-connectivity setup keeps the SINR of every UE
+ * towards every mmWave cell, and with the DYNAMIC_TTT secondary cell handover it
+ * scans the whole table of every UE at every report table period (CrtPeriod) to
+ * find the best cell. The tracker keeps instead, for every UE, an indexed max
+ * heap of its cells: an SINR update that does not change the value costs
+ * nothing, one that does moves a single entry, in O(log cells), and the best
+ * and second best cells are read in O(1). A cell is better if its SINR is
+ * larger, or equal with a smaller cell ID.
+ */
+class BestCellTracker
+{
+  public:
+    /**
+     * Set the SINR of a UE towards a cell
+     * \param imsi the UE
+     * \param cellId the mmWave cell, not BEST_CELL_NONE
+     * \param sinr the SINR, linear
+     */
+    void Update(uint64_t imsi, uint16_t cellId, double sinr)
+    {
+        NS_ASSERT(cellId != BEST_CELL_NONE);
+        Heap& heap = m_ues[imsi];
+        uint32_t index = GetCellIndex(cellId);
+        if (index >= heap.pos.size())
+        {
+            heap.pos.resize(m_cellIds.size(), NOT_IN_HEAP);
+        }
+        uint32_t p = heap.pos[index];
+        if (p == NOT_IN_HEAP)
+        {
+            p = heap.entries.size();
+            heap.entries.push_back({sinr, cellId, index});
+            heap.pos[index] = p;
+            SiftUp(heap, p);
+            return;
+        }
+        double old = heap.entries[p].sinr;
+        if (sinr == old)
+        {
+            return;
+        }
+        heap.entries[p].sinr = sinr;
+        if (sinr > old)
+        {
+            SiftUp(heap, p);
+        }
+        else
+        {
+            SiftDown(heap, p);
+        }
+    }
+
+    /// Forget the SINR entries of a UE, e.g. when it detaches
+    void RemoveUe(uint64_t imsi)
+    {
+        m_ues.erase(imsi);
+    }
+
+    /**
+     * \param imsi the UE
+     * \return the best cell and its SINR, BEST_CELL_NONE if the UE has no entry
+     */
+    std::pair<uint16_t, double> GetBest(uint64_t imsi) const
+    {
+        auto it = m_ues.find(imsi);
+        if (it == m_ues.end() || it->second.entries.empty())
+        {
+            return {BEST_CELL_NONE, 0};
+        }
+        const Entry& e = it->second.entries[0];
+        return {e.cellId, e.sinr};
+    }
+
+    /**
+     * \param imsi the UE
+     * \return the second best cell and its SINR, BEST_CELL_NONE if the UE has fewer than two
+     */
+    std::pair<uint16_t, double> GetSecondBest(uint64_t imsi) const
+    {
+        auto it = m_ues.find(imsi);
+        if (it == m_ues.end() || it->second.entries.size() < 2)
+        {
+            return {BEST_CELL_NONE, 0};
+        }
+        const std::vector<Entry>& entries = it->second.entries;
+        std::size_t c = 1;
+        if (entries.size() > 2 && IsBetter(entries[2], entries[1]))
+        {
+            c = 2;
+        }
+        return {entries[c].cellId, entries[c].sinr};
+    }
+
+  private:
+    static constexpr uint32_t NOT_IN_HEAP = UINT32_MAX;
+
+    struct Entry
+    {
+        double sinr;
+        uint16_t cellId;
+        uint32_t index; //!< dense index of the cell
+    };
+
+    /// The cells of a UE, as an indexed binary max heap
+    struct Heap
+    {
+        std::vector<Entry> entries;
+        std::vector<uint32_t> pos; //!< by dense cell index, the position in entries
+    };
+
+    static bool IsBetter(const Entry& a, const Entry& b)
+    {
+        return a.sinr > b.sinr || (a.sinr == b.sinr && a.cellId < b.cellId);
+    }
+
+    uint32_t GetCellIndex(uint16_t cellId)
+    {
+        auto it = m_cellIndex.find(cellId);
+        if (it != m_cellIndex.end())
+        {
+            return it->second;
+        }
+        uint32_t index = m_cellIds.size();
+        m_cellIds.push_back(cellId);
+        m_cellIndex[cellId] = index;
+        return index;
+    }
+
+    static void Swap(Heap& heap, uint32_t a, uint32_t b)
+    {
+        std::swap(heap.entries[a], heap.entries[b]);
+        heap.pos[heap.entries[a].index] = a;
+        heap.pos[heap.entries[b].index] = b;
+    }
+
+    static void SiftUp(Heap& heap, uint32_t p)
+    {
+        while (p > 0)
+        {
+            uint32_t parent = (p - 1) / 2;
+            if (!IsBetter(heap.entries[p], heap.entries[parent]))
+            {
+                break;
+            }
+            Swap(heap, p, parent);
+            p = parent;
+        }
+    }
+
+    static void SiftDown(Heap& heap, uint32_t p)
+    {
+        uint32_t n = heap.entries.size();
+        while (true)
+        {
+            uint32_t best = p;
+            for (uint32_t c = 2 * p + 1; c <= 2 * p + 2 && c < n; ++c)
+            {
+                if (IsBetter(heap.entries[c], heap.entries[best]))
+                {
+                    best = c;
+                }
+            }
+            if (best == p)
+            {
+                break;
+            }
+            Swap(heap, p, best);
+            p = best;
+        }
+    }
+
+    std::unordered_map<uint64_t, Heap> m_ues;
+    std::unordered_map<uint16_t, uint32_t> m_cellIndex;
+    std::vector<uint16_t> m_cellIds;
+};
+
+/**
+ * The scan of LteEnbRrc: the SINR of every UE in a map by cell, the whole map
+ * scanned at every query. Used to check BestCellTracker and as the baseline of
+ * its benchmark.
+ */
+struct BestCellReference
+{
+    std::map<uint64_t, std::map<uint16_t, double>> m_sinr; //!< by IMSI, by cell ID
+
+    /// \return the best and second best cell of a UE, as BestCellTracker
+    std::pair<std::pair<uint16_t, double>, std::pair<uint16_t, double>> Scan(uint64_t imsi) const
+    {
+        std::pair<uint16_t, double> best{BEST_CELL_NONE, 0};
+        std::pair<uint16_t, double> second{BEST_CELL_NONE, 0};
+        // in increasing cell ID, so ties go to the first cell seen
+        for (const auto& cell : m_sinr.at(imsi))
+        {
+            if (best.first == BEST_CELL_NONE || cell.second > best.second)
+            {
+                second = best;
+                best = cell;
+            }
+            else if (second.first == BEST_CELL_NONE || cell.second > second.second)
+            {
+                second = cell;
+            }
+        }
+        return {best, second};
+    }
+};
+
+} // namespace ns3
+
+#endif /* BEST_CELL_TRACKER_H */
@@ -0,0 +1,208 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef CHANNEL_PRECISION_REPORT_H
+#define CHANNEL_PRECISION_REPORT_H
+
+#include "parallel-three-gpp-channel-model.h"
+
+#include "ns3/channel-list.h"
+#include "ns3/core-module.h"
+#include "ns3/spectrum-channel.h"
+
+#include <complex>
+#include <fstream>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * Single precision copy of the coefficients of a channel matrix, used by
+ * PrintChannelPrecisionReport to measure what float storage would save and cost.
+ *
+ * The real and imaginary parts are stored in two separate float arrays
+ * (structure of arrays), cluster by cluster, with the same (u, s, n) layout
+ * as MatrixBasedChannelModel::ChannelMatrix::m_channel. The long-term
+ * beamforming term of a cluster is accumulated in double.
+ */
+class SinglePrecisionChannelMatrix
+{
+  public:
+    explicit SinglePrecisionChannelMatrix(const MatrixBasedChannelModel::Complex3DVector& h)
+        : m_nRows(h.GetNumRows()),
+          m_nCols(h.GetNumCols()),
+          m_nPages(h.GetNumPages()),
+          m_re(m_nRows * m_nCols * m_nPages),
+          m_im(m_nRows * m_nCols * m_nPages)
+    {
+        for (std::size_t n = 0; n < m_nPages; ++n)
+        {
+            const std::complex<double>* page = h.GetPagePtr(n);
+            for (std::size_t i = 0; i < m_nRows * m_nCols; ++i)
+            {
+                m_re[n * m_nRows * m_nCols + i] = page[i].real();
+                m_im[n * m_nRows * m_nCols + i] = page[i].imag();
+            }
+        }
+    }
+
+    /**
+     * \return the bytes used by the coefficients
+     */
+    std::size_t GetBytes() const
+    {
+        return (m_re.size() + m_im.size()) * sizeof(float);
+    }
+
+    /**
+     * Long-term term of one cluster, sum over u and s of uW[u] H(u, s, n) sW[s]
+     * \param uW beamforming vector of the antenna of the rows
+     * \param sW beamforming vector of the antenna of the columns
+     * \param n the cluster
+     * \return the long-term term, accumulated in double
+     */
+    std::complex<double> GetLongTerm(const PhasedArrayModel::ComplexVector& uW,
+                                     const PhasedArrayModel::ComplexVector& sW,
+                                     std::size_t n) const
+    {
+        std::complex<double> sum(0, 0);
+        std::size_t offset = n * m_nRows * m_nCols;
+        // ValArray pages are column major: element (u, s) is at u + s * nRows
+        for (std::size_t s = 0; s < m_nCols; ++s)
+        {
+            std::complex<double> column(0, 0);
+            for (std::size_t u = 0; u < m_nRows; ++u)
+            {
+                std::size_t i = offset + s * m_nRows + u;
+                column += uW[u] * std::complex<double>(m_re[i], m_im[i]);
+            }
+            sum += column * sW[s];
+        }
+        return sum;
+    }
+
+  private:
+    std::size_t m_nRows;
+    std::size_t m_nCols;
+    std::size_t m_nPages;
+    std::vector<float> m_re;
+    std::vector<float> m_im;
+};
+
+/**
+ * Long-term term of one cluster computed on the double precision coefficients
+ */
+inline std::complex<double>
+GetLongTerm(const MatrixBasedChannelModel::Complex3DVector& h,
+            const PhasedArrayModel::ComplexVector& uW,
+            const PhasedArrayModel::ComplexVector& sW,
+            std::size_t n)
+{
+    std::complex<double> sum(0, 0);
+    for (std::size_t s = 0; s < h.GetNumCols(); ++s)
+    {
+        std::complex<double> column(0, 0);
+        for (std::size_t u = 0; u < h.GetNumRows(); ++u)
+        {
+            column += uW[u] * h(u, s, n);
+        }
+        sum += column * sW[s];
+    }
+    return sum;
+}
+
+/**
+ * For every channel cached by the ParallelThreeGppChannelModel instances of the
+ * simulation, write the memory the coefficients and the long-term vector use in
+ * double precision and would use in single precision, and the error on the
+ * beamforming gain (sum over the clusters of the squared long-term terms) of a
+ * single precision copy, with the current beamforming vectors.
+ *
+ * This is a report only: the simulation keeps the matrices in double, since
+ * ChannelMatrix and the long-term cache of ThreeGppSpectrumPropagationLossModel
+ * are complex<double> in the spectrum module.
+ *
+ * \param filename the output file
+ */
+inline void
+PrintChannelPrecisionReport(std::string filename)
+{
+    std::ofstream out(filename.c_str(), std::ios_base::out | std::ios_base::trunc);
+    out << "aAntenna\tbAntenna\tnU\tnS\tnClusters\tdoubleBytes\tfloatBytes\tgainDb\tgainErrDb"
+        << std::endl;
+    std::size_t totalDouble = 0;
+    std::size_t totalFloat = 0;
+    double maxErrDb = 0;
+
+    for (uint32_t i = 0; i < ChannelList::GetNChannels(); ++i)
+    {
+        Ptr<SpectrumChannel> channel = DynamicCast<SpectrumChannel>(ChannelList::GetChannel(i));
+        if (!channel || !channel->GetPhasedArraySpectrumPropagationLossModel())
+        {
+            continue;
+        }
+        PointerValue model;
+        channel->GetPhasedArraySpectrumPropagationLossModel()->GetAttributeFailSafe("ChannelModel",
+                                                                                    model);
+        Ptr<ParallelThreeGppChannelModel> parallel =
+            DynamicCast<ParallelThreeGppChannelModel>(model.GetObject());
+        if (!parallel)
+        {
+            continue;
+        }
+        parallel->ForEachChannel([&](Ptr<const PhasedArrayModel> a,
+                                     Ptr<const PhasedArrayModel> b,
+                                     Ptr<const MatrixBasedChannelModel::ChannelMatrix> m) {
+            const MatrixBasedChannelModel::Complex3DVector& h = m->m_channel;
+            // the rows of the matrix belong to the second antenna of m_antennaPair
+            bool aIsS = m->m_antennaPair.first == a->GetId();
+            PhasedArrayModel::ComplexVector sW =
+                aIsS ? a->GetBeamformingVector() : b->GetBeamformingVector();
+            PhasedArrayModel::ComplexVector uW =
+                aIsS ? b->GetBeamformingVector() : a->GetBeamformingVector();
+
+            SinglePrecisionChannelMatrix compact(h);
+            double gain = 0;
+            double gainFloat = 0;
+            for (std::size_t n = 0; n < h.GetNumPages(); ++n)
+            {
+                gain += std::norm(GetLongTerm(h, uW, sW, n));
+                gainFloat += std::norm(compact.GetLongTerm(uW, sW, n));
+            }
+            double gainDb = 10 * std::log10(std::max(gain, 1e-300));
+            double errDb = std::abs(10 * std::log10(std::max(gainFloat, 1e-300)) - gainDb);
+
+            std::size_t nCoef = h.GetNumRows() * h.GetNumCols() * h.GetNumPages();
+            std::size_t doubleBytes = nCoef * sizeof(std::complex<double>) +
+                                      h.GetNumPages() * sizeof(std::complex<double>);
+            std::size_t floatBytes =
+                compact.GetBytes() + h.GetNumPages() * sizeof(std::complex<float>);
+            totalDouble += doubleBytes;
+            totalFloat += floatBytes;
+            maxErrDb = std::max(maxErrDb, errDb);
+            out << a->GetId() << "\t" << b->GetId() << "\t" << h.GetNumRows() << "\t"
+                << h.GetNumCols() << "\t" << h.GetNumPages() << "\t" << doubleBytes << "\t"
+                << floatBytes << "\t" << gainDb << "\t" << errDb << std::endl;
+        });
+    }
+    out << "# total\tdouble " << totalDouble << " B\tfloat " << totalFloat
+        << " B\tmax gain error " << maxErrDb << " dB" << std::endl;
+}
+
+} // namespace ns3
+
+#endif /* CHANNEL_PRECISION_REPORT_H */
@@ -0,0 +1,319 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FITNESS_CACHE_H
+#define FITNESS_CACHE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * The value of a UE at a position (e.g. its simulated SINR), memoized by UE
+ * and position quantized to a grid of Quantum meters.
+ *
+ * With a single eNB, or interference from the eNBs only, the SINR of a UE only
+ * depends on its own position, so the placements explored by an optimizer
+ * that differ by less than a quantum for a UE share its value. A quantum of 0
+ * disables the cache.
+ */
+class PositionFitnessCache
+{
+  public:
+    /**
+     * \param quantum the grid, in m; 0 to disable the cache
+     */
+    explicit PositionFitnessCache(double quantum = 1.0)
+        : m_quantum(quantum)
+    {
+    }
+
+    /// Empty the cache and reset its counters, with a new quantum
+    void SetQuantum(double quantum)
+    {
+        m_quantum = quantum;
+        m_values.clear();
+        m_hits = 0;
+        m_misses = 0;
+    }
+
+    /**
+     * \param[out] value the value of the UE at the quantized position, if known
+     * \return true on a hit
+     */
+    bool Lookup(uint32_t ue, double x, double y, double& value)
+    {
+        if (m_quantum <= 0)
+        {
+            ++m_misses;
+            return false;
+        }
+        auto it = m_values.find(MakeKey(ue, x, y));
+        if (it == m_values.end())
+        {
+            ++m_misses;
+            return false;
+        }
+        ++m_hits;
+        value = it->second;
+        return true;
+    }
+
+    void Insert(uint32_t ue, double x, double y, double value)
+    {
+        if (m_quantum > 0)
+        {
+            m_values[MakeKey(ue, x, y)] = value;
+        }
+    }
+
+    uint64_t GetHits() const
+    {
+        return m_hits;
+    }
+
+    uint64_t GetMisses() const
+    {
+        return m_misses;
+    }
+
+    /// \return the number of values kept
+    std::size_t GetSize() const
+    {
+        return m_values.size();
+    }
+
+  private:
+    struct Key
+    {
+        uint32_t ue;
+        int64_t qx;
+        int64_t qy;
+
+        bool operator==(const Key& other) const
+        {
+            return ue == other.ue && qx == other.qx && qy == other.qy;
+        }
+    };
+
+    struct KeyHash
+    {
+        std::size_t operator()(const Key& k) const
+        {
+            uint64_t h = k.ue * 0x9E3779B97F4A7C15ULL;
+            h ^= uint64_t(k.qx) + 0x9E3779B97F4A7C15ULL + (h << 6) + (h >> 2);
+            h ^= uint64_t(k.qy) + 0x9E3779B97F4A7C15ULL + (h << 6) + (h >> 2);
+            return h;
+        }
+    };
+
+    Key MakeKey(uint32_t ue, double x, double y) const
+    {
+        return {ue, std::llround(x / m_quantum), std::llround(y / m_quantum)};
+    }
+
+    double m_quantum;
+    std::unordered_map<Key, double, KeyHash> m_values;
+    uint64_t m_hits{0};
+    uint64_t m_misses{0};
+};
+
+/**
+ * The SINR of the UEs over a precomputed radio map, bilinearly interpolated.
+ *
+ * The map is a text file of regularly spaced samples, one per line: either
+ * "x y z sinr", for all the UEs, or "ue x y z sinr" for a map per UE (ue from
+ * 0). The SINR is in dB, or linear if the map is loaded as linear: the radio
+ * environment maps of ns-3 (RadioEnvironmentMapHelper) have the "x y z sinr"
+ * layout with the linear SINR, so they are loaded with linear = true. Lines
+ * starting with '%' or '#' are skipped. Outside of its map, or next to a
+ * missing sample, the SINR of a UE is unknown (NaN).
+ */
+class RadioMapSurrogate
+{
+  public:
+    /// UE of the map shared by all the UEs
+    static const uint32_t ALL_UES = UINT32_MAX;
+
+    /**
+     * Read a radio map
+     * \param fileName the map
+     * \param linear true if the SINR of the file is linear, as in the ns-3 maps
+     * \return false if the file cannot be read or has no sample
+     */
+    bool Load(const std::string& fileName, bool linear = false)
+    {
+        std::ifstream in(fileName.c_str());
+        if (!in)
+        {
+            return false;
+        }
+        std::string line;
+        while (std::getline(in, line))
+        {
+            if (line.empty() || line[0] == '%' || line[0] == '#')
+            {
+                continue;
+            }
+            std::istringstream fields(line);
+            std::vector<double> v;
+            double d;
+            while (fields >> d)
+            {
+                v.push_back(d);
+            }
+            if (linear && (v.size() == 4 || v.size() == 5))
+            {
+                v.back() = 10 * std::log10(v.back());
+            }
+            if (v.size() == 4)
+            {
+                AddSample(ALL_UES, v[0], v[1], v[3]);
+            }
+            else if (v.size() == 5)
+            {
+                AddSample(uint32_t(v[0]), v[1], v[2], v[4]);
+            }
+        }
+        Build();
+        return !m_maps.empty();
+    }
+
+    /// Add a sample, before Build ()
+    void AddSample(uint32_t ue, double x, double y, double sinrDb)
+    {
+        m_samples[ue].push_back({x, y, sinrDb});
+    }
+
+    /// Arrange the samples added into grids
+    void Build()
+    {
+        for (const auto& s : m_samples)
+        {
+            Map& map = m_maps[s.first];
+            for (const Sample& sample : s.second)
+            {
+                map.xs.push_back(sample.x);
+                map.ys.push_back(sample.y);
+            }
+            Unique(map.xs);
+            Unique(map.ys);
+            map.sinr.assign(map.xs.size() * map.ys.size(), NAN);
+            for (const Sample& sample : s.second)
+            {
+                std::size_t i = std::lower_bound(map.xs.begin(), map.xs.end(), sample.x) -
+                                map.xs.begin();
+                std::size_t j = std::lower_bound(map.ys.begin(), map.ys.end(), sample.y) -
+                                map.ys.begin();
+                map.sinr[j * map.xs.size() + i] = sample.sinrDb;
+            }
+        }
+        m_samples.clear();
+    }
+
+    /// \return true if there is a map for the UE, its own or the shared one
+    bool HasMap(uint32_t ue) const
+    {
+        return m_maps.count(ue) > 0 || m_maps.count(ALL_UES) > 0;
+    }
+
+    /// \return the SINR of the UE at the position, in dB, NaN if unknown
+    double GetSinr(uint32_t ue, double x, double y) const
+    {
+        auto it = m_maps.find(ue);
+        if (it == m_maps.end())
+        {
+            it = m_maps.find(ALL_UES);
+            if (it == m_maps.end())
+            {
+                return NAN;
+            }
+        }
+        const Map& map = it->second;
+        std::size_t i;
+        std::size_t j;
+        double fx;
+        double fy;
+        if (!Locate(map.xs, x, i, fx) || !Locate(map.ys, y, j, fy))
+        {
+            return NAN;
+        }
+        const std::size_t nx = map.xs.size();
+        auto at = [&map, nx](std::size_t a, std::size_t b) { return map.sinr[b * nx + a]; };
+        std::size_t i1 = std::min(i + 1, nx - 1);
+        std::size_t j1 = std::min(j + 1, map.ys.size() - 1);
+        // a missing corner makes the result NaN
+        return (1 - fy) * ((1 - fx) * at(i, j) + fx * at(i1, j)) +
+               fy * ((1 - fx) * at(i, j1) + fx * at(i1, j1));
+    }
+
+  private:
+    struct Sample
+    {
+        double x;
+        double y;
+        double sinrDb;
+    };
+
+    /// A grid: the coordinates of its columns and rows, the SINR by row, by column
+    struct Map
+    {
+        std::vector<double> xs;
+        std::vector<double> ys;
+        std::vector<double> sinr;
+    };
+
+    static void Unique(std::vector<double>& v)
+    {
+        std::sort(v.begin(), v.end());
+        v.erase(std::unique(v.begin(), v.end()), v.end());
+    }
+
+    /// Cell of v holding value, and the position in it; false if outside
+    static bool Locate(const std::vector<double>& v, double value, std::size_t& i, double& f)
+    {
+        if (v.empty() || value < v.front() || value > v.back())
+        {
+            return false;
+        }
+        if (v.size() == 1)
+        {
+            i = 0;
+            f = 0;
+            return true;
+        }
+        i = std::upper_bound(v.begin(), v.end(), value) - v.begin();
+        i = std::min(std::max<std::size_t>(i, 1), v.size() - 1) - 1;
+        f = (value - v[i]) / (v[i + 1] - v[i]);
+        return true;
+    }
+
+    std::map<uint32_t, std::vector<Sample>> m_samples;
+    std::map<uint32_t, Map> m_maps;
+};
+
+} // namespace ns3
+
+#endif /* FITNESS_CACHE_H */
@@ -0,0 +1,322 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Memory of the per-UE HARQ process state, allocated for all the processes
+ * when the UE is added (as the mmWave MAC and schedulers do) or on first use
+ * from a shared pool (LazyHarqProcessPool).
+ *
+ * The state of a process is the one of the flex TTI schedulers and MACs: the
+ * DCI, the RLC PDUs of the TB, the status, the timer and the packet burst
+ * kept for the retransmission, which holds the packet of the TB. Every slot, each UE is scheduled with
+ * probability scheduleProbability on a free process; after harqRtt slots the
+ * TB fails with probability bler and is retransmitted, at most maxRetx times,
+ * else the process is released. Both tables go through the same sequence, and
+ * the heap bytes are counted by the allocation operators of this program.
+ *
+ * ./ns3 run "harq-memory-report --numHarqProcess=100 --ueCounts=10,100,1000"
+ */
+
+#include "lazy-harq-process-pool.h"
+
+#include "ns3/core-module.h"
+#include "ns3/mmwave-phy-mac-common.h"
+#include "ns3/packet-burst.h"
+#include "ns3/packet.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <new>
+#include <random>
+#include <sstream>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("HarqMemoryReport");
+
+/// Bytes allocated on the heap and not yet freed
+static std::size_t g_liveBytes = 0;
+
+// every block is prefixed by its size, so the bytes are known when it is freed
+void*
+operator new(std::size_t size)
+{
+    void* block = std::malloc(size + alignof(std::max_align_t));
+    if (!block)
+    {
+        throw std::bad_alloc();
+    }
+    *static_cast<std::size_t*>(block) = size;
+    g_liveBytes += size;
+    return static_cast<char*>(block) + alignof(std::max_align_t);
+}
+
+void
+operator delete(void* p) noexcept
+{
+    if (p)
+    {
+        void* block = static_cast<char*>(p) - alignof(std::max_align_t);
+        g_liveBytes -= *static_cast<std::size_t*>(block);
+        std::free(block);
+    }
+}
+
+void
+operator delete(void* p, std::size_t) noexcept
+{
+    operator delete(p);
+}
+
+namespace ns3
+{
+
+/// The state of a HARQ process of the flex TTI MAC and schedulers
+struct HarqProcessState
+{
+    mmwave::DciInfoElementTdma dci;
+    std::vector<mmwave::RlcPduInfo> rlcPdus;
+    Ptr<PacketBurst> burst = Create<PacketBurst>();
+    uint8_t status{0};
+    uint8_t timer{0};
+    uint8_t retx{0};
+};
+
+/**
+ * Reset a released process, keeping the capacity of its PDU list. The burst is
+ * replaced: PacketBurst cannot be emptied, and the packets of the previous TB
+ * must not be retransmitted by the next process that takes this state.
+ */
+void
+ResetHarqProcess(HarqProcessState& state)
+{
+    state.dci = mmwave::DciInfoElementTdma();
+    state.rlcPdus.clear();
+    state.burst = Create<PacketBurst>();
+    state.status = 0;
+    state.timer = 0;
+    state.retx = 0;
+}
+
+} // namespace ns3
+
+/// The HARQ tables of all the UEs, eager or lazy, behind the same interface
+class HarqTables
+{
+  public:
+    /**
+     * \param busy the processes in use of every UE, allocated by the caller so
+     * they are not counted with the tables
+     */
+    HarqTables(bool lazy,
+               uint32_t nUes,
+               uint32_t numProcesses,
+               std::vector<std::vector<bool>>& busy)
+        : m_lazy(lazy),
+          m_pool(numProcesses),
+          m_busy(busy)
+    {
+        for (uint16_t rnti = 1; rnti <= nUes; ++rnti)
+        {
+            if (m_lazy)
+            {
+                m_pool.AddUe(rnti);
+            }
+            else
+            {
+                m_eager[rnti].resize(numProcesses);
+            }
+        }
+    }
+
+    /// \return a free process of the UE, numProcesses if none
+    uint32_t GetFree(uint16_t rnti) const
+    {
+        const std::vector<bool>& busy = m_busy[rnti];
+        return std::find(busy.begin(), busy.end(), false) - busy.begin();
+    }
+
+    HarqProcessState& Use(uint16_t rnti, uint32_t harqId)
+    {
+        m_busy[rnti][harqId] = true;
+        return m_lazy ? m_pool.Get(rnti, harqId) : m_eager[rnti][harqId];
+    }
+
+    void Release(uint16_t rnti, uint32_t harqId)
+    {
+        m_busy[rnti][harqId] = false;
+        if (m_lazy)
+        {
+            m_pool.Release(rnti, harqId);
+        }
+        else
+        {
+            ResetHarqProcess(m_eager[rnti][harqId]);
+        }
+    }
+
+    const std::vector<bool>& GetBusy(uint16_t rnti) const
+    {
+        return m_busy[rnti];
+    }
+
+    std::size_t GetPeakLiveProcesses() const
+    {
+        return m_pool.GetPeakLiveProcesses();
+    }
+
+  private:
+    bool m_lazy;
+    LazyHarqProcessPool<HarqProcessState> m_pool;
+    std::map<uint16_t, std::vector<HarqProcessState>> m_eager;
+    std::vector<std::vector<bool>>& m_busy;
+};
+
+/**
+ * Run the HARQ processes of nUes UEs
+ * \return the peak heap bytes of the tables, and the peak processes in use
+ */
+static std::pair<std::size_t, std::size_t>
+Run(bool lazy,
+    uint32_t nUes,
+    uint32_t numProcesses,
+    uint32_t nSlots,
+    double scheduleProbability,
+    double bler,
+    uint32_t harqRtt,
+    uint32_t maxRetx)
+{
+    // the simulation bookkeeping is allocated before the baseline, so only the tables count
+    std::vector<std::vector<bool>> busy(nUes + 1, std::vector<bool>(numProcesses, false));
+    std::size_t baseline = g_liveBytes;
+    std::size_t peak = 0;
+    std::size_t peakLive = 0;
+    {
+        HarqTables tables(lazy, nUes, numProcesses, busy);
+        std::mt19937 rng(1);
+        std::uniform_real_distribution<double> uniform(0, 1);
+        for (uint32_t slot = 0; slot < nSlots; ++slot)
+        {
+            for (uint16_t rnti = 1; rnti <= nUes; ++rnti)
+            {
+                // the processes waiting for their feedback
+                for (uint32_t h = 0; h < numProcesses; ++h)
+                {
+                    if (!tables.GetBusy(rnti)[h])
+                    {
+                        continue;
+                    }
+                    HarqProcessState& state = tables.Use(rnti, h);
+                    if (--state.timer > 0)
+                    {
+                        continue;
+                    }
+                    if (uniform(rng) < bler && state.retx < maxRetx)
+                    {
+                        ++state.retx;
+                        state.dci.m_rv = state.retx;
+                        state.timer = harqRtt;
+                    }
+                    else
+                    {
+                        tables.Release(rnti, h);
+                    }
+                }
+                if (uniform(rng) >= scheduleProbability)
+                {
+                    continue;
+                }
+                uint32_t h = tables.GetFree(rnti);
+                if (h == numProcesses)
+                {
+                    continue;
+                }
+                HarqProcessState& state = tables.Use(rnti, h);
+                NS_ASSERT_MSG(state.burst->GetNPackets() == 0,
+                              "Packets of a previous TB in HARQ process " << h << " of RNTI "
+                                                                          << rnti);
+                state.burst->AddPacket(Create<Packet>(1500));
+                state.dci.m_rnti = rnti;
+                state.dci.m_harqProcess = h;
+                state.dci.m_ndi = 1;
+                state.rlcPdus.push_back(mmwave::RlcPduInfo(3, 1500));
+                state.status = 1;
+                state.timer = harqRtt;
+            }
+            peak = std::max(peak, g_liveBytes - baseline);
+        }
+        peakLive = tables.GetPeakLiveProcesses();
+    }
+    return {peak, peakLive};
+}
+
+int
+main(int argc, char* argv[])
+{
+    uint32_t numHarqProcess = 100;
+    uint32_t nSlots = 2000;
+    double scheduleProbability = 0.5;
+    double bler = 0.1;
+    uint32_t harqRtt = 4;
+    uint32_t maxRetx = 3;
+    std::string ueCounts = "10,100,1000";
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("numHarqProcess", "HARQ processes per UE", numHarqProcess);
+    cmd.AddValue("nSlots", "Slots simulated for every number of UEs", nSlots);
+    cmd.AddValue("scheduleProbability",
+                 "Probability that a UE gets a new TB in a slot",
+                 scheduleProbability);
+    cmd.AddValue("bler", "Probability that a TB needs a retransmission", bler);
+    cmd.AddValue("harqRtt", "Slots between a transmission and its feedback", harqRtt);
+    cmd.AddValue("maxRetx", "Largest number of retransmissions of a TB", maxRetx);
+    cmd.AddValue("ueCounts", "Comma separated numbers of UEs", ueCounts);
+    cmd.Parse(argc, argv);
+
+    std::cout << "nUes\teagerBytes\tlazyBytes\teagerBytesPerUe\tlazyBytesPerUe\tsavingPerUe"
+                 "\tpeakLiveProcesses"
+              << std::endl;
+    std::stringstream counts(ueCounts);
+    std::string count;
+    while (std::getline(counts, count, ','))
+    {
+        uint32_t nUes = std::stoul(count);
+        auto eager = Run(false,
+                         nUes,
+                         numHarqProcess,
+                         nSlots,
+                         scheduleProbability,
+                         bler,
+                         harqRtt,
+                         maxRetx);
+        auto lazy = Run(true,
+                        nUes,
+                        numHarqProcess,
+                        nSlots,
+                        scheduleProbability,
+                        bler,
+                        harqRtt,
+                        maxRetx);
+        std::cout << nUes << "\t" << eager.first << "\t" << lazy.first << "\t"
+                  << eager.first / nUes << "\t" << lazy.first / nUes << "\t"
+                  << (double(eager.first) - double(lazy.first)) / nUes << "\t" << lazy.second
+                  << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,40 @@
+#!/bin/bash
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License version 2 as
+# published by the Free Software Foundation;
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#
+#  Run the low load scenarios, Packet5G.cc and outdoor-mmwave.cc, with
+#  --idleSlots and collect the fraction of idle slots and the events that an
+#  idle-slot fast-forward of the mmWave PHY and MAC would save.
+#
+#  Run from the root of an ns-3 tree with the scenarios in scratch/:
+#  $ bash idle-slot-analysis.sh
+#  SIMTIME sets the simulated time (default 5 s).
+#
+
+SIMTIME=${SIMTIME:-5}
+OUT=${OUT:-idle-slot-analysis.txt}
+SCENARIOS="Packet5G outdoor-mmwave"
+
+./ns3 build $SCENARIOS || exit 1
+
+: > $OUT
+for scenario in $SCENARIOS; do
+    dir=$(mktemp -d)
+    ./ns3 run --no-build --cwd=$dir "$scenario --simTime=$SIMTIME --idleSlots=true" \
+        > $dir/log.txt 2>&1
+    echo "# $scenario" | tee -a $OUT
+    cat $dir/IdleSlotStats.txt | tee -a $OUT
+    rm -rf $dir
+done
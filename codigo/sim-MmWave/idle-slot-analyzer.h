@@ -0,0 +1,167 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef IDLE_SLOT_ANALYZER_H
+#define IDLE_SLOT_ANALYZER_H
+
+#include "ns3/core-module.h"
+#include "ns3/mmwave-phy-mac-common.h"
+#include "ns3/mmwave-spectrum-phy.h"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * Measures how many slots of a simulation carry data, and how many events an
+ * idle-slot fast-forward of the mmWave PHY and MAC could save.
+ *
+ * A slot is busy when a TB is received in it, in downlink (RxPacketTraceUe) or
+ * uplink (RxPacketTraceEnb); the slot duration is the one of the PHY/MAC
+ * configuration (24 symbols of 4.16 us by default, 99.84 us). For every cell the
+ * report gives the busy and idle slots and the longest run of idle slots. For
+ * the whole simulation, the events
+ * executed per slot inside idle stretches are estimated from the event counter
+ * sampled at the busy slots (median over the gaps of at least MinGap slots),
+ * and multiplied by the idle slots: this is the number of events a fast-forward
+ * to the next busy slot would elide, if the per-slot control were elided too.
+ */
+class IdleSlotAnalyzer : public Object
+{
+  public:
+    static TypeId GetTypeId()
+    {
+        static TypeId tid =
+            TypeId("ns3::IdleSlotAnalyzer")
+                .SetParent<Object>()
+                .AddConstructor<IdleSlotAnalyzer>()
+                .AddAttribute("MinGap",
+                              "Shortest gap between busy slots used to estimate the events per "
+                              "idle slot",
+                              UintegerValue(8),
+                              MakeUintegerAccessor(&IdleSlotAnalyzer::m_minGap),
+                              MakeUintegerChecker<uint32_t>(1));
+        return tid;
+    }
+
+    IdleSlotAnalyzer() = default;
+
+    /**
+     * Connect to the RxPacketTrace sources of the UE and eNB PHYs
+     * \param config the PHY/MAC configuration of the carrier, for the slot duration
+     */
+    void Connect(Ptr<mmwave::MmWavePhyMacCommon> config)
+    {
+        m_slotPeriod = config->GetSymbolPeriod() * config->GetSymbolsPerSlot();
+        Config::ConnectWithoutContextFailSafe(
+            "/NodeList/*/DeviceList/*/ComponentCarrierMapUe/*/MmWaveUePhy/DlSpectrumPhy/"
+            "RxPacketTraceUe",
+            MakeCallback(&IdleSlotAnalyzer::RxPacketTrace, this));
+        Config::ConnectWithoutContextFailSafe(
+            "/NodeList/*/DeviceList/*/ComponentCarrierMap/*/MmWaveEnbPhy/DlSpectrumPhy/"
+            "RxPacketTraceEnb",
+            MakeCallback(&IdleSlotAnalyzer::RxPacketTrace, this));
+    }
+
+    /**
+     * Write the per-cell occupancy and the estimate of the elidable events
+     * \param filename the output file
+     */
+    void Print(std::string filename) const
+    {
+        uint64_t nSlots = Simulator::Now().GetTimeStep() / m_slotPeriod.GetTimeStep();
+        std::ofstream out(filename.c_str(), std::ios_base::out | std::ios_base::trunc);
+        out << "cell\tslots\tbusySlots\tidleSlots\tidleFraction\tlongestIdleRun" << std::endl;
+        for (const auto& cell : m_busySlots)
+        {
+            PrintOccupancy(out, std::to_string(cell.first), cell.second, nSlots);
+        }
+        PrintOccupancy(out, "any", m_anyBusy, nSlots);
+
+        std::vector<double> rates;
+        for (std::size_t i = 1; i < m_anyBusy.size(); ++i)
+        {
+            uint64_t gap = m_anyBusy[i] - m_anyBusy[i - 1];
+            if (gap >= m_minGap)
+            {
+                rates.push_back(double(m_events[i] - m_events[i - 1]) / gap);
+            }
+        }
+        uint64_t events = Simulator::GetEventCount();
+        out << "# events " << events;
+        if (!rates.empty())
+        {
+            std::nth_element(rates.begin(), rates.begin() + rates.size() / 2, rates.end());
+            double perIdleSlot = rates[rates.size() / 2];
+            double elidable = perIdleSlot * (nSlots - std::min<uint64_t>(nSlots, m_anyBusy.size()));
+            out << ", events per idle slot " << perIdleSlot << ", elidable events " << elidable
+                << " (" << 100.0 * elidable / std::max<uint64_t>(events, 1) << " %)";
+        }
+        out << std::endl;
+    }
+
+  private:
+    void RxPacketTrace(mmwave::RxPacketTraceParams params)
+    {
+        // the trace is fired at the end of the TB, which may coincide with the end of the slot
+        uint64_t slot = (Simulator::Now().GetTimeStep() - 1) / m_slotPeriod.GetTimeStep();
+        std::vector<uint64_t>& busy = m_busySlots[params.m_cellId];
+        if (busy.empty() || busy.back() != slot)
+        {
+            busy.push_back(slot);
+        }
+        if (m_anyBusy.empty() || m_anyBusy.back() != slot)
+        {
+            m_anyBusy.push_back(slot);
+            m_events.push_back(Simulator::GetEventCount());
+        }
+    }
+
+    static void PrintOccupancy(std::ostream& out,
+                               std::string cell,
+                               const std::vector<uint64_t>& busy,
+                               uint64_t nSlots)
+    {
+        uint64_t longest = busy.empty() ? nSlots : busy.front();
+        for (std::size_t i = 1; i < busy.size(); ++i)
+        {
+            longest = std::max<uint64_t>(longest, busy[i] - busy[i - 1] - 1);
+        }
+        if (!busy.empty() && nSlots > busy.back())
+        {
+            longest = std::max<uint64_t>(longest, nSlots - busy.back() - 1);
+        }
+        uint64_t idle = nSlots - std::min<uint64_t>(nSlots, busy.size());
+        out << cell << "\t" << nSlots << "\t" << busy.size() << "\t" << idle << "\t"
+            << double(idle) / std::max<uint64_t>(nSlots, 1) << "\t" << longest << std::endl;
+    }
+
+    Time m_slotPeriod;
+    uint32_t m_minGap{8};
+    std::map<uint64_t, std::vector<uint64_t>> m_busySlots; //!< per cell, in increasing order
+    std::vector<uint64_t> m_anyBusy; //!< slots busy in at least one cell
+    std::vector<uint64_t> m_events;  //!< event count at the first TB of each of m_anyBusy
+};
+
+NS_OBJECT_ENSURE_REGISTERED(IdleSlotAnalyzer);
+
+} // namespace ns3
+
+#endif /* IDLE_SLOT_ANALYZER_H */
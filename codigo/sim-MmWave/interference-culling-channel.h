@@ -0,0 +1,653 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef INTERFERENCE_CULLING_CHANNEL_H
+#define INTERFERENCE_CULLING_CHANNEL_H
+
+#include "ns3/angles.h"
+#include "ns3/antenna-model.h"
+#include "ns3/channel-list.h"
+#include "ns3/core-module.h"
+#include "ns3/mobility-model.h"
+#include "ns3/net-device.h"
+#include "ns3/node.h"
+#include "ns3/phased-array-model.h"
+#include "ns3/phased-array-spectrum-propagation-loss-model.h"
+#include "ns3/propagation-delay-model.h"
+#include "ns3/propagation-loss-model.h"
+#include "ns3/spectrum-channel.h"
+#include "ns3/spectrum-converter.h"
+#include "ns3/spectrum-phy.h"
+#include "ns3/spectrum-propagation-loss-model.h"
+#include "ns3/spectrum-signal-parameters.h"
+#include "ns3/spectrum-value.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <ostream>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * Spectrum channel that only delivers a transmission to the receivers where
+ * its power may be above the thermal noise floor minus a margin.
+ *
+ * The bound uses the free space pathloss at the carrier frequency, which is never
+ * larger than the 3GPP pathloss, plus the largest gain G of the antennas of both
+ * ends. For a PhasedArrayModel, G is the beamforming gain 10 log10 of its number of
+ * elements plus the peak gain of its element; for other antennas, it is
+ * MaxAntennaGain. A transmitter with power P reaches at most the radius d at which
+ * P + G - FSPL (d) = N - Margin, N being the noise power in the bandwidth of the
+ * signal.
+ *
+ * The receiver positions are snapshot in a uniform grid every RefreshPeriod. For
+ * each transmitter the receivers within its radius, padded by the distance both
+ * ends can cover at MaxSpeed before the next snapshot, are gathered from the grid
+ * cells that intersect its disc, once per snapshot or change of transmit power.
+ * A transmission then only visits these receivers, so its cost follows the local
+ * density of the receivers instead of their total number. Past the culling, each
+ * receiver goes through the same pipeline as in MultiModelSpectrumChannel:
+ * spectrum conversion, antenna gains, pathloss and MaxLossDb, delay, and spectrum
+ * or phased array propagation loss.
+ */
+class InterferenceCullingChannel : public SpectrumChannel
+{
+  public:
+    static TypeId GetTypeId()
+    {
+        static TypeId tid =
+            TypeId("ns3::InterferenceCullingChannel")
+                .SetParent<SpectrumChannel>()
+                .SetGroupName("Spectrum")
+                .AddConstructor<InterferenceCullingChannel>()
+                .AddAttribute("Margin",
+                              "Margin (dB) below the thermal noise floor under which a signal is "
+                              "culled",
+                              DoubleValue(10.0),
+                              MakeDoubleAccessor(&InterferenceCullingChannel::m_marginDb),
+                              MakeDoubleChecker<double>(0.0))
+                .AddAttribute("NoiseFigure",
+                              "Lowest noise figure (dB) among the receivers",
+                              DoubleValue(5.0),
+                              MakeDoubleAccessor(&InterferenceCullingChannel::m_noiseFigureDb),
+                              MakeDoubleChecker<double>())
+                .AddAttribute("MaxAntennaGain",
+                              "Upper bound (dB) of the gain of an antenna that is not a "
+                              "PhasedArrayModel",
+                              DoubleValue(30.0),
+                              MakeDoubleAccessor(&InterferenceCullingChannel::m_maxAntennaGainDb),
+                              MakeDoubleChecker<double>())
+                .AddAttribute("RefreshPeriod",
+                              "Interval between two snapshots of the receiver positions",
+                              TimeValue(MilliSeconds(100)),
+                              MakeTimeAccessor(&InterferenceCullingChannel::m_refreshPeriod),
+                              MakeTimeChecker())
+                .AddAttribute("MaxSpeed",
+                              "Maximum speed (m/s) of the nodes, used to pad the culling radius "
+                              "between two snapshots",
+                              DoubleValue(30.0),
+                              MakeDoubleAccessor(&InterferenceCullingChannel::m_maxSpeed),
+                              MakeDoubleChecker<double>(0.0))
+                .AddAttribute("CellSize",
+                              "Side (m) of the cells of the spatial grid",
+                              DoubleValue(50.0),
+                              MakeDoubleAccessor(&InterferenceCullingChannel::m_cellSize),
+                              MakeDoubleChecker<double>(1.0));
+        return tid;
+    }
+
+    InterferenceCullingChannel() = default;
+
+    void AddRx(Ptr<SpectrumPhy> phy) override
+    {
+        if (std::find_if(m_receivers.begin(), m_receivers.end(), [phy](const Receiver& r) {
+                return r.phy == phy;
+            }) == m_receivers.end())
+        {
+            m_receivers.push_back({phy, Vector(), 1.0});
+            m_snapshotTime = Time::Max(); // force a new snapshot
+        }
+    }
+
+    void RemoveRx(Ptr<SpectrumPhy> phy) override
+    {
+        auto it = std::find_if(m_receivers.begin(), m_receivers.end(), [phy](const Receiver& r) {
+            return r.phy == phy;
+        });
+        if (it != m_receivers.end())
+        {
+            m_receivers.erase(it);
+            m_snapshotTime = Time::Max();
+        }
+    }
+
+    void StartTx(Ptr<SpectrumSignalParameters> txParams) override
+    {
+        NS_ASSERT(txParams->txPhy);
+        NS_ASSERT(txParams->psd);
+        m_txSigsTrace(txParams);
+        ++m_nTransmissions;
+
+        if (m_snapshotTime == Time::Max() || Simulator::Now() - m_snapshotTime >= m_refreshPeriod)
+        {
+            TakeSnapshot();
+        }
+        Ptr<MobilityModel> txMobility = txParams->txPhy->GetMobility();
+        const std::vector<std::size_t>* visited = &m_allReceivers;
+        if (txMobility)
+        {
+            // the radius of a transmitter only changes with its power or the snapshot
+            Transmitter& tx = m_transmitters[PeekPointer(txParams->txPhy)];
+            double txPowerW = Integral(*txParams->psd);
+            if (tx.snapshot != m_snapshotId || tx.txPowerW != txPowerW)
+            {
+                tx.snapshot = m_snapshotId;
+                tx.txPowerW = txPowerW;
+                FillInRange(tx, txParams, txMobility->GetPosition(), GetMaxGainDb(txParams->txPhy));
+            }
+            visited = &tx.inRange;
+        }
+        m_nPairs += m_receivers.size();
+        m_nCulled += m_receivers.size() - visited->size();
+
+        SpectrumModelUid_t txModelUid = txParams->psd->GetSpectrumModelUid();
+        for (std::size_t i : *visited)
+        {
+            Ptr<SpectrumPhy> rxPhy = m_receivers[i].phy;
+            if (rxPhy == txParams->txPhy)
+            {
+                continue;
+            }
+            if (m_filter && m_filter->Filter(txParams, rxPhy))
+            {
+                continue;
+            }
+            Ptr<SpectrumSignalParameters> rxParams = txParams->Copy();
+            Ptr<const SpectrumModel> rxModel = rxPhy->GetRxSpectrumModel();
+            if (rxModel->GetUid() != txModelUid)
+            {
+                rxParams->psd = GetConverter(txParams->psd->GetSpectrumModel(), rxModel)
+                                    .Convert(txParams->psd);
+            }
+            Time delay = MicroSeconds(0);
+            Ptr<MobilityModel> rxMobility = rxPhy->GetMobility();
+            if (txMobility && rxMobility)
+            {
+                double txAntennaGain = 0;
+                double rxAntennaGain = 0;
+                double propagationGainDb = 0;
+                double pathLossDb = 0;
+                if (rxParams->txAntenna)
+                {
+                    Angles txAngles(rxMobility->GetPosition(), txMobility->GetPosition());
+                    txAntennaGain = rxParams->txAntenna->GetGainDb(txAngles);
+                    pathLossDb -= txAntennaGain;
+                }
+                Ptr<AntennaModel> rxAntenna = DynamicCast<AntennaModel>(rxPhy->GetAntenna());
+                if (rxAntenna)
+                {
+                    Angles rxAngles(txMobility->GetPosition(), rxMobility->GetPosition());
+                    rxAntennaGain = rxAntenna->GetGainDb(rxAngles);
+                    pathLossDb -= rxAntennaGain;
+                }
+                if (m_propagationLoss)
+                {
+                    propagationGainDb = m_propagationLoss->CalcRxPower(0, txMobility, rxMobility);
+                    pathLossDb -= propagationGainDb;
+                }
+                m_gainTrace(txMobility,
+                            rxMobility,
+                            txAntennaGain,
+                            rxAntennaGain,
+                            propagationGainDb,
+                            pathLossDb);
+                m_pathLossTrace(txParams->txPhy, rxPhy, pathLossDb);
+                if (pathLossDb > m_maxLossDb)
+                {
+                    continue;
+                }
+                *(rxParams->psd) *= std::pow(10.0, -pathLossDb / 10.0);
+                if (m_propagationDelay)
+                {
+                    delay = m_propagationDelay->GetDelay(txMobility, rxMobility);
+                }
+                if (m_spectrumPropagationLoss)
+                {
+                    rxParams->psd =
+                        m_spectrumPropagationLoss->CalcRxPowerSpectralDensity(rxParams,
+                                                                              txMobility,
+                                                                              rxMobility);
+                }
+                else if (m_phasedArraySpectrumPropagationLoss)
+                {
+                    Ptr<const PhasedArrayModel> txArray =
+                        DynamicCast<PhasedArrayModel>(txParams->txPhy->GetAntenna());
+                    Ptr<const PhasedArrayModel> rxArray =
+                        DynamicCast<PhasedArrayModel>(rxPhy->GetAntenna());
+                    NS_ASSERT_MSG(txArray && rxArray,
+                                  "PhasedArrayModel instances should be installed at both TX "
+                                  "and RX SpectrumPhy in order to use "
+                                  "PhasedArraySpectrumPropagationLossModel.");
+                    rxParams = m_phasedArraySpectrumPropagationLoss->CalcRxPowerSpectralDensity(
+                        rxParams,
+                        txMobility,
+                        rxMobility,
+                        txArray,
+                        rxArray);
+                }
+            }
+            Ptr<NetDevice> netDev = rxPhy->GetDevice();
+            uint32_t dstNode = netDev ? netDev->GetNode()->GetId() : 0xffffffff;
+            Simulator::ScheduleWithContext(dstNode,
+                                           delay,
+                                           &InterferenceCullingChannel::StartRx,
+                                           rxParams,
+                                           rxPhy);
+        }
+    }
+
+    std::size_t GetNDevices() const override
+    {
+        return m_receivers.size();
+    }
+
+    Ptr<NetDevice> GetDevice(std::size_t i) const override
+    {
+        return m_receivers.at(i).phy->GetDevice();
+    }
+
+    /**
+     * \return the number of (transmission, receiver) pairs on the channel
+     */
+    uint64_t GetNPairs() const
+    {
+        return m_nPairs;
+    }
+
+    /**
+     * \return the number of (transmission, receiver) pairs culled
+     */
+    uint64_t GetNCulled() const
+    {
+        return m_nCulled;
+    }
+
+    /**
+     * Print the counters, one line per channel
+     * \param os the output stream
+     * \param channelId identifier of the channel replaced
+     */
+    void PrintStats(std::ostream& os, uint32_t channelId) const
+    {
+        os << channelId << "\t" << m_nTransmissions << "\t" << m_nPairs << "\t" << m_nCulled
+           << "\t" << (m_nPairs ? double(m_nCulled) / m_nPairs : 0.0) << "\t"
+           << m_receivers.size() << "\t" << m_transmitters.size() << std::endl;
+    }
+
+  protected:
+    void DoDispose() override
+    {
+        m_receivers.clear();
+        m_allReceivers.clear();
+        m_unplaced.clear();
+        m_grid.clear();
+        m_transmitters.clear();
+        m_elementGains.clear();
+        m_converters.clear();
+        SpectrumChannel::DoDispose();
+    }
+
+  private:
+    /// A receiver, its position at the last snapshot and its culling radius scale
+    struct Receiver
+    {
+        Ptr<SpectrumPhy> phy;
+        Vector position;
+        double radiusScale; //!< 10^((G - max G) / 20), G the largest gain of its antenna
+    };
+
+    /// Receivers in range of a transmitter, valid for one snapshot and transmit power
+    struct Transmitter
+    {
+        double txPowerW{-1.0};
+        uint64_t snapshot{0};
+        std::vector<std::size_t> inRange; //!< indices in m_receivers
+    };
+
+    static void StartRx(Ptr<SpectrumSignalParameters> params, Ptr<SpectrumPhy> receiver)
+    {
+        receiver->StartRx(params);
+    }
+
+    const SpectrumConverter& GetConverter(Ptr<const SpectrumModel> from,
+                                          Ptr<const SpectrumModel> to)
+    {
+        auto key = std::make_pair(from->GetUid(), to->GetUid());
+        auto it = m_converters.find(key);
+        if (it == m_converters.end())
+        {
+            it = m_converters.emplace(key, SpectrumConverter(from, to)).first;
+        }
+        return it->second;
+    }
+
+    static int64_t CellKey(int64_t cx, int64_t cy)
+    {
+        return (cx << 32) ^ (cy & 0xffffffff);
+    }
+
+    /**
+     * Largest gain of the antenna of a phy, i.e., the beamforming gain of a
+     * PhasedArrayModel plus the peak gain of its element, or MaxAntennaGain
+     */
+    double GetMaxGainDb(Ptr<const SpectrumPhy> phy)
+    {
+        Ptr<const PhasedArrayModel> array = DynamicCast<const PhasedArrayModel>(phy->GetAntenna());
+        if (!array)
+        {
+            return m_maxAntennaGainDb;
+        }
+        Ptr<const AntennaModel> element = array->GetAntennaElement();
+        auto it = m_elementGains.find(PeekPointer(element));
+        if (it == m_elementGains.end())
+        {
+            // the element pattern is sampled once, on a 1 degree grid holding the boresight
+            double peakDb = -std::numeric_limits<double>::infinity();
+            for (int azimuth = -180; azimuth <= 180; ++azimuth)
+            {
+                for (int inclination = 0; inclination <= 180; ++inclination)
+                {
+                    Angles angles(azimuth * M_PI / 180, inclination * M_PI / 180);
+                    peakDb = std::max(peakDb, element->GetGainDb(angles));
+                }
+            }
+            it = m_elementGains.emplace(PeekPointer(element), peakDb).first;
+        }
+        return 10 * std::log10(double(array->GetNumElems())) + it->second;
+    }
+
+    void TakeSnapshot()
+    {
+        m_grid.clear();
+        m_allReceivers.clear();
+        m_unplaced.clear();
+        std::vector<double> gainsDb;
+        gainsDb.reserve(m_receivers.size());
+        m_maxRxGainDb = -std::numeric_limits<double>::infinity();
+        for (const Receiver& receiver : m_receivers)
+        {
+            gainsDb.push_back(GetMaxGainDb(receiver.phy));
+            m_maxRxGainDb = std::max(m_maxRxGainDb, gainsDb.back());
+        }
+        for (std::size_t i = 0; i < m_receivers.size(); ++i)
+        {
+            m_receivers[i].radiusScale = std::pow(10, (gainsDb[i] - m_maxRxGainDb) / 20);
+            m_allReceivers.push_back(i);
+            Ptr<MobilityModel> mobility = m_receivers[i].phy->GetMobility();
+            if (!mobility)
+            {
+                m_unplaced.push_back(i);
+                continue;
+            }
+            Vector pos = mobility->GetPosition();
+            m_receivers[i].position = pos;
+            int64_t cx = std::floor(pos.x / m_cellSize);
+            int64_t cy = std::floor(pos.y / m_cellSize);
+            m_grid[CellKey(cx, cy)].push_back(i);
+        }
+        m_snapshotTime = Simulator::Now();
+        ++m_snapshotId;
+    }
+
+    /**
+     * Culling radius of a signal, i.e., the distance at which the free space received
+     * power with the given antenna gain falls Margin dB below the noise floor
+     * \param params the signal
+     * \param antennaGainDb the sum of the largest transmit and receive antenna gains
+     */
+    double GetCullingRadius(Ptr<const SpectrumSignalParameters> params,
+                            double antennaGainDb) const
+    {
+        Ptr<const SpectrumModel> model = params->psd->GetSpectrumModel();
+        double bandwidth = 0.0;
+        double weightedFrequency = 0.0;
+        for (auto band = model->Begin(); band != model->End(); ++band)
+        {
+            double width = band->fh - band->fl;
+            bandwidth += width;
+            weightedFrequency += band->fc * width;
+        }
+        if (bandwidth <= 0.0)
+        {
+            return std::numeric_limits<double>::infinity();
+        }
+        double frequency = weightedFrequency / bandwidth;
+        const double boltzmann = 1.38064852e-23;
+        double noiseDbm = 10 * std::log10(boltzmann * 290 * bandwidth * 1000) + m_noiseFigureDb;
+        double txPowerDbm = 10 * std::log10(Integral(*params->psd) * 1000);
+        double maxPathlossDb = txPowerDbm + antennaGainDb - noiseDbm + m_marginDb;
+        // FSPL (d) = 20 log10 (4 pi d f / c)
+        return 299792458.0 / (4 * M_PI * frequency) * std::pow(10, maxPathlossDb / 20);
+    }
+
+    void FillInRange(Transmitter& tx,
+                     Ptr<const SpectrumSignalParameters> params,
+                     const Vector& txPos,
+                     double txGainDb)
+    {
+        // the radius of the receiver with the largest gain; each receiver scales it
+        // by its own gain, then both ends may move until the next snapshot
+        double cullingRadius = GetCullingRadius(params, txGainDb + m_maxRxGainDb);
+        double padding = 2 * m_maxSpeed * m_refreshPeriod.GetSeconds();
+        double radius = cullingRadius + padding;
+        if (!std::isfinite(radius) || radius / m_cellSize > 1e4)
+        {
+            tx.inRange = m_allReceivers;
+            return;
+        }
+        // receivers without mobility are never culled
+        tx.inRange = m_unplaced;
+        int64_t cxMin = std::floor((txPos.x - radius) / m_cellSize);
+        int64_t cxMax = std::floor((txPos.x + radius) / m_cellSize);
+        int64_t cyMin = std::floor((txPos.y - radius) / m_cellSize);
+        int64_t cyMax = std::floor((txPos.y + radius) / m_cellSize);
+        if (double(cxMax - cxMin + 1) * (cyMax - cyMin + 1) > 2.0 * m_grid.size())
+        {
+            // the disc covers more cells than there are occupied cells: scan the latter
+            for (const auto& cell : m_grid)
+            {
+                AddInRange(tx, cell.second, txPos, cullingRadius, padding);
+            }
+        }
+        else
+        {
+            for (int64_t cx = cxMin; cx <= cxMax; ++cx)
+            {
+                for (int64_t cy = cyMin; cy <= cyMax; ++cy)
+                {
+                    auto cell = m_grid.find(CellKey(cx, cy));
+                    if (cell != m_grid.end())
+                    {
+                        AddInRange(tx, cell->second, txPos, cullingRadius, padding);
+                    }
+                }
+            }
+        }
+        // deliver in the order of AddRx, as the stock channels do
+        std::sort(tx.inRange.begin(), tx.inRange.end());
+    }
+
+    void AddInRange(Transmitter& tx,
+                    const std::vector<std::size_t>& cell,
+                    const Vector& txPos,
+                    double cullingRadius,
+                    double padding) const
+    {
+        for (std::size_t i : cell)
+        {
+            Vector d = m_receivers[i].position - txPos;
+            double radius = cullingRadius * m_receivers[i].radiusScale + padding;
+            if (d.x * d.x + d.y * d.y + d.z * d.z <= radius * radius)
+            {
+                tx.inRange.push_back(i);
+            }
+        }
+    }
+
+    double m_marginDb{10.0};
+    double m_noiseFigureDb{5.0};
+    double m_maxAntennaGainDb{30.0};
+    Time m_refreshPeriod;
+    double m_maxSpeed{30.0};
+    double m_cellSize{50.0};
+
+    std::vector<Receiver> m_receivers;
+    std::vector<std::size_t> m_allReceivers; //!< 0 .. m_receivers.size () - 1
+    std::vector<std::size_t> m_unplaced;     //!< receivers without a mobility model
+    std::unordered_map<int64_t, std::vector<std::size_t>> m_grid; //!< cell -> receiver indices
+    std::unordered_map<const SpectrumPhy*, Transmitter> m_transmitters;
+    std::unordered_map<const AntennaModel*, double> m_elementGains; //!< element -> peak gain (dB)
+    double m_maxRxGainDb{0.0}; //!< largest antenna gain among the receivers at the snapshot
+    std::map<std::pair<SpectrumModelUid_t, SpectrumModelUid_t>, SpectrumConverter> m_converters;
+    Time m_snapshotTime{Time::Max()};
+    uint64_t m_snapshotId{0};
+    uint64_t m_nTransmissions{0};
+    uint64_t m_nPairs{0};
+    uint64_t m_nCulled{0};
+};
+
+NS_OBJECT_ENSURE_REGISTERED(InterferenceCullingChannel);
+
+/**
+ * Move the mmWave spectrum phys from the channel created by MmWaveHelper to an
+ * InterferenceCullingChannel configured with the default attribute values. The
+ * new channel takes over the loss, delay and MaxLossDb of the original one,
+ * which is left without receivers. Call after the devices are installed. The UE
+ * phys are found on both MmWaveUeNetDevice and McUeNetDevice, and the simulation
+ * aborts if no eNB or no UE phy is found.
+ *
+ * Only one mmWave channel, i.e. one component carrier, is supported: the phys
+ * found through the Config paths cannot be told apart by carrier.
+ *
+ * \return the installed channels, indexed by the id of the channel they replace
+ */
+inline std::map<uint32_t, Ptr<InterferenceCullingChannel>>
+InstallInterferenceCulling()
+{
+    std::map<uint32_t, Ptr<InterferenceCullingChannel>> channels;
+    Ptr<SpectrumChannel> original;
+    for (auto it = ChannelList::Begin(); it != ChannelList::End(); ++it)
+    {
+        Ptr<SpectrumChannel> channel = DynamicCast<SpectrumChannel>(*it);
+        if (channel && channel->GetPhasedArraySpectrumPropagationLossModel() &&
+            !DynamicCast<InterferenceCullingChannel>(channel))
+        {
+            NS_ABORT_MSG_IF(original, "Interference culling supports one mmWave carrier only");
+            original = channel;
+        }
+    }
+    if (!original)
+    {
+        return channels;
+    }
+
+    Ptr<InterferenceCullingChannel> culling = CreateObject<InterferenceCullingChannel>();
+    if (original->GetPropagationLossModel())
+    {
+        culling->AddPropagationLossModel(original->GetPropagationLossModel());
+    }
+    if (original->GetSpectrumPropagationLossModel())
+    {
+        culling->AddSpectrumPropagationLossModel(original->GetSpectrumPropagationLossModel());
+    }
+    culling->AddPhasedArraySpectrumPropagationLossModel(
+        original->GetPhasedArraySpectrumPropagationLossModel());
+    PointerValue delay;
+    if (original->GetAttributeFailSafe("PropagationDelayModel", delay) &&
+        delay.Get<PropagationDelayModel>())
+    {
+        culling->SetPropagationDelayModel(delay.Get<PropagationDelayModel>());
+    }
+    DoubleValue maxLoss;
+    original->GetAttribute("MaxLossDb", maxLoss);
+    culling->SetAttribute("MaxLossDb", maxLoss);
+
+    // MmWaveUeNetDevice and McUeNetDevice name their carrier maps differently
+    std::vector<Ptr<SpectrumPhy>> phys;
+    std::size_t nEnbPhys = 0;
+    for (std::string path :
+         {"/NodeList/*/DeviceList/*/ComponentCarrierMap/*/MmWaveEnbPhy/DlSpectrumPhy",
+          "/NodeList/*/DeviceList/*/ComponentCarrierMap/*/MmWaveEnbPhy/UlSpectrumPhy",
+          "/NodeList/*/DeviceList/*/ComponentCarrierMapUe/*/MmWaveUePhy/DlSpectrumPhy",
+          "/NodeList/*/DeviceList/*/ComponentCarrierMapUe/*/MmWaveUePhy/UlSpectrumPhy",
+          "/NodeList/*/DeviceList/*/MmWaveComponentCarrierMapUe/*/MmWaveUePhy/DlSpectrumPhy",
+          "/NodeList/*/DeviceList/*/MmWaveComponentCarrierMapUe/*/MmWaveUePhy/UlSpectrumPhy"})
+    {
+        Config::MatchContainer matches = Config::LookupMatches(path);
+        for (auto it = matches.Begin(); it != matches.End(); ++it)
+        {
+            Ptr<SpectrumPhy> phy = DynamicCast<SpectrumPhy>(*it);
+            if (phy && std::find(phys.begin(), phys.end(), phy) == phys.end())
+            {
+                phys.push_back(phy);
+            }
+        }
+        if (path.find("MmWaveEnbPhy") != std::string::npos)
+        {
+            nEnbPhys = phys.size();
+        }
+    }
+    // moving only one side would leave the links split over two channels
+    NS_ABORT_MSG_IF(nEnbPhys == 0, "Interference culling found no mmWave eNB phy");
+    NS_ABORT_MSG_IF(phys.size() == nEnbPhys, "Interference culling found no mmWave UE phy");
+    for (Ptr<SpectrumPhy> phy : phys)
+    {
+        original->RemoveRx(phy);
+        phy->SetChannel(culling);
+        culling->AddRx(phy);
+    }
+    channels[original->GetId()] = culling;
+    return channels;
+}
+
+/**
+ * Write the counters of the channels returned by InstallInterferenceCulling
+ * \param filename the output file
+ * \param channels the installed channels
+ */
+inline void
+PrintInterferenceCullingStats(std::string filename,
+                              const std::map<uint32_t, Ptr<InterferenceCullingChannel>>& channels)
+{
+    std::ofstream outFile(filename.c_str(), std::ios_base::out | std::ios_base::trunc);
+    outFile << "ChannelId\tTransmissions\tPairs\tCulled\tCulledRatio\tReceivers\tTransmitters"
+            << std::endl;
+    for (const auto& entry : channels)
+    {
+        entry.second->PrintStats(outFile, entry.first);
+    }
+}
+
+} // namespace ns3
+
+#endif /* INTERFERENCE_CULLING_CHANNEL_H */
@@ -0,0 +1,356 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LADDER_QUEUE_SCHEDULER_H
+#define LADDER_QUEUE_SCHEDULER_H
+
+#include "ns3/core-module.h"
+#include "ns3/scheduler.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * Ladder queue event scheduler (W. T. Tang, R. S. M. Goh, I. L.-J. Thng,
+ * "Ladder queue: An O(1) priority queue structure for large-scale discrete
+ * event simulation", ACM TOMACS 2005).
+ *
+ * Events far in the future are appended, unsorted, to the top list. When the
+ * near future is exhausted the top list is spread over the buckets of the first
+ * rung of the ladder; a bucket holding more than BucketThreshold events is in
+ * turn spread over a finer rung, and the first small bucket is sorted into the
+ * bottom list, from which the events are dequeued. Every event is sorted only
+ * when it reaches the bottom, among few others, so insertion and removal take
+ * constant amortized time on the dense, almost monotonic event streams of the
+ * slot based MAC and PHY. A bottom list that grows past HeapThreshold, with
+ * events scheduled in the near future or a bucket that cannot be split, turns
+ * into a binary heap, so that an insertion stays logarithmic.
+ *
+ * Select it with --SchedulerType=ns3::LadderQueueScheduler, or with
+ * ObjectFactory factory ("ns3::LadderQueueScheduler");
+ * Simulator::SetScheduler (factory);
+ */
+class LadderQueueScheduler : public Scheduler
+{
+  public:
+    static TypeId GetTypeId()
+    {
+        static TypeId tid =
+            TypeId("ns3::LadderQueueScheduler")
+                .SetParent<Scheduler>()
+                .SetGroupName("Core")
+                .AddConstructor<LadderQueueScheduler>()
+                .AddAttribute("BucketThreshold",
+                              "Largest bucket sorted into the bottom list; larger buckets "
+                              "are spread over a new rung",
+                              UintegerValue(50),
+                              MakeUintegerAccessor(&LadderQueueScheduler::m_threshold),
+                              MakeUintegerChecker<uint32_t>(1))
+                .AddAttribute("MaxRungs",
+                              "Largest number of rungs of the ladder",
+                              UintegerValue(8),
+                              MakeUintegerAccessor(&LadderQueueScheduler::m_maxRungs),
+                              MakeUintegerChecker<uint32_t>(1))
+                .AddAttribute("HeapThreshold",
+                              "Length of the bottom list past which it is kept as a binary heap "
+                              "instead of a sorted list",
+                              UintegerValue(400),
+                              MakeUintegerAccessor(&LadderQueueScheduler::m_heapThreshold),
+                              MakeUintegerChecker<uint32_t>(1));
+        return tid;
+    }
+
+    LadderQueueScheduler()
+    {
+        GetInstance() = this;
+    }
+
+    ~LadderQueueScheduler() override
+    {
+        if (GetInstance() == this)
+        {
+            GetInstance() = nullptr;
+        }
+    }
+
+    /**
+     * The simulator implementations do not give access to their scheduler: this
+     * is the last LadderQueueScheduler created and still alive, if any
+     * \return the scheduler, or nullptr
+     */
+    static LadderQueueScheduler*& GetInstance()
+    {
+        static LadderQueueScheduler* instance = nullptr;
+        return instance;
+    }
+
+    /**
+     * \return the number of events in the queue
+     */
+    std::size_t GetSize() const
+    {
+        return m_size;
+    }
+
+    void Insert(const Event& ev) override
+    {
+        ++m_size;
+        uint64_t ts = ev.key.m_ts;
+        if (m_nRungs == 0 && m_bottom.empty())
+        {
+            // nothing scheduled in the near future: the event belongs to the top
+            m_top.push_back(ev);
+            m_topMin = std::min(m_topMin, ts);
+            m_topMax = std::max(m_topMax, ts);
+            return;
+        }
+        if (ts >= m_topStart)
+        {
+            m_top.push_back(ev);
+            m_topMin = std::min(m_topMin, ts);
+            m_topMax = std::max(m_topMax, ts);
+            return;
+        }
+        for (uint32_t r = 0; r < m_nRungs; ++r)
+        {
+            Rung& rung = m_rungs[r];
+            if (ts >= rung.GetCurrentStart())
+            {
+                rung.buckets[rung.GetBucket(ts)].push_back(ev);
+                ++rung.nEvents;
+                return;
+            }
+        }
+        if (!m_bottomIsHeap && m_bottom.size() >= m_heapThreshold)
+        {
+            m_bottomIsHeap = true;
+            std::make_heap(m_bottom.begin(), m_bottom.end(), &Later);
+        }
+        if (m_bottomIsHeap)
+        {
+            m_bottom.push_back(ev);
+            std::push_heap(m_bottom.begin(), m_bottom.end(), &Later);
+            return;
+        }
+        // sorted in decreasing order, the next event is at the back
+        auto it = std::upper_bound(m_bottom.begin(), m_bottom.end(), ev, &Later);
+        m_bottom.insert(it, ev);
+    }
+
+    bool IsEmpty() const override
+    {
+        return m_size == 0;
+    }
+
+    Event PeekNext() const override
+    {
+        NS_ASSERT(!IsEmpty());
+        const_cast<LadderQueueScheduler*>(this)->Refill();
+        return m_bottomIsHeap ? m_bottom.front() : m_bottom.back();
+    }
+
+    Event RemoveNext() override
+    {
+        NS_ASSERT(!IsEmpty());
+        Refill();
+        if (m_bottomIsHeap)
+        {
+            std::pop_heap(m_bottom.begin(), m_bottom.end(), &Later);
+        }
+        Event ev = m_bottom.back();
+        m_bottom.pop_back();
+        --m_size;
+        return ev;
+    }
+
+    void Remove(const Event& ev) override
+    {
+        if (m_bottomIsHeap)
+        {
+            if (EraseFrom(m_bottom, ev))
+            {
+                std::make_heap(m_bottom.begin(), m_bottom.end(), &Later);
+                --m_size;
+                return;
+            }
+        }
+        else
+        {
+            auto it = std::lower_bound(m_bottom.begin(), m_bottom.end(), ev, &Later);
+            if (it != m_bottom.end() && it->key.m_uid == ev.key.m_uid)
+            {
+                m_bottom.erase(it);
+                --m_size;
+                return;
+            }
+        }
+        for (uint32_t r = 0; r < m_nRungs; ++r)
+        {
+            Rung& rung = m_rungs[r];
+            if (ev.key.m_ts >= rung.GetCurrentStart() &&
+                rung.GetBucket(ev.key.m_ts) < rung.buckets.size() &&
+                EraseFrom(rung.buckets[rung.GetBucket(ev.key.m_ts)], ev))
+            {
+                --rung.nEvents;
+                --m_size;
+                return;
+            }
+        }
+        NS_ABORT_MSG_UNLESS(EraseFrom(m_top, ev), "Event " << ev.key.m_uid << " not scheduled");
+        --m_size;
+    }
+
+  private:
+    /// One rung of the ladder: buckets of equal width, consumed in order
+    struct Rung
+    {
+        uint64_t start{0};      //!< timestamp of the beginning of the first bucket
+        uint64_t width{1};      //!< bucket width, in time steps
+        std::size_t current{0}; //!< first bucket not yet consumed
+        std::size_t nEvents{0};
+        std::vector<std::vector<Event>> buckets;
+
+        uint64_t GetCurrentStart() const
+        {
+            return start + current * width;
+        }
+
+        std::size_t GetBucket(uint64_t ts) const
+        {
+            return (ts - start) / width;
+        }
+
+        void Reset(uint64_t s, uint64_t w, std::size_t nBuckets)
+        {
+            start = s;
+            width = w;
+            current = 0;
+            nEvents = 0;
+            // a rung is only reused once all its buckets are empty, and the bucket
+            // vectors keep their capacity from one use to the next
+            if (buckets.size() < nBuckets)
+            {
+                buckets.resize(nBuckets);
+            }
+        }
+    };
+
+    static bool Later(const Event& a, const Event& b)
+    {
+        return b.key < a.key;
+    }
+
+    static bool EraseFrom(std::vector<Event>& events, const Event& ev)
+    {
+        for (auto it = events.begin(); it != events.end(); ++it)
+        {
+            if (it->key.m_uid == ev.key.m_uid)
+            {
+                *it = events.back();
+                events.pop_back();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// Spread events over a new rung covering [start, start + span)
+    void SpawnRung(std::vector<Event>& events, uint64_t start, uint64_t span)
+    {
+        // never reallocated, so the bucket being spread stays valid
+        m_rungs.reserve(m_maxRungs);
+        if (m_rungs.size() <= m_nRungs)
+        {
+            m_rungs.emplace_back();
+        }
+        uint64_t width = std::max<uint64_t>(span / events.size(), 1);
+        std::size_t nBuckets = (span + width - 1) / width;
+        Rung& rung = m_rungs[m_nRungs++];
+        rung.Reset(start, width, nBuckets);
+        for (const Event& ev : events)
+        {
+            rung.buckets[rung.GetBucket(ev.key.m_ts)].push_back(ev);
+        }
+        rung.nEvents = events.size();
+        events.clear();
+    }
+
+    /// Move the next events to the bottom list, if it is empty
+    void Refill()
+    {
+        while (m_bottom.empty())
+        {
+            if (m_nRungs == 0)
+            {
+                NS_ASSERT(!m_top.empty());
+                // the top list becomes the first rung, later events go to a new top
+                uint64_t span = m_topMax - m_topMin + 1;
+                m_topStart = m_topMax + 1;
+                SpawnRung(m_top, m_topMin, span);
+                m_topMin = UINT64_MAX;
+                m_topMax = 0;
+                continue;
+            }
+
+            Rung& rung = m_rungs[m_nRungs - 1];
+            if (rung.nEvents == 0)
+            {
+                --m_nRungs;
+                continue;
+            }
+            while (rung.buckets[rung.current].empty())
+            {
+                ++rung.current;
+            }
+            std::vector<Event>& bucket = rung.buckets[rung.current];
+            uint64_t bucketStart = rung.GetCurrentStart();
+            ++rung.current;
+            rung.nEvents -= bucket.size();
+
+            if (bucket.size() > m_threshold && m_nRungs < m_maxRungs && rung.width > 1)
+            {
+                SpawnRung(bucket, bucketStart, rung.width);
+                continue;
+            }
+            m_bottom.swap(bucket);
+            bucket.clear();
+            std::sort(m_bottom.begin(), m_bottom.end(), &Later);
+            m_bottomIsHeap = false;
+        }
+    }
+
+    uint32_t m_threshold{50};
+    uint32_t m_maxRungs{8};
+    uint32_t m_heapThreshold{400};
+    std::size_t m_size{0};
+    std::vector<Event> m_top; //!< far future events, unsorted
+    uint64_t m_topMin{UINT64_MAX};
+    uint64_t m_topMax{0};
+    uint64_t m_topStart{0}; //!< events at or after this go to the top list
+    std::vector<Rung> m_rungs;
+    uint32_t m_nRungs{0};
+    std::vector<Event> m_bottom; //!< next events, sorted in decreasing order or a heap
+    bool m_bottomIsHeap{false};  //!< the bottom list is a heap, the next event at the front
+};
+
+NS_OBJECT_ENSURE_REGISTERED(LadderQueueScheduler);
+
+} // namespace ns3
+
+#endif /* LADDER_QUEUE_SCHEDULER_H */
@@ -0,0 +1,189 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LAZY_HARQ_PROCESS_POOL_H
+#define LAZY_HARQ_PROCESS_POOL_H
+
+#include "ns3/assert.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * The HARQ process state of every UE, allocated on first use.
+ *
+ * The mmWave MAC and schedulers size the per-UE HARQ tables for
+ * MmWavePhyMacCommon::NumHarqProcess processes when the UE is added (with 100
+ * processes, 100 DCIs, RLC PDU lists, timers and packet bursts per UE and per
+ * side), although only the processes of the TBs in flight are ever used. Here a
+ * UE only has a table of NumHarqProcess indices; the state of a process is
+ * taken from a pool shared by all the UEs when the process is first used, and
+ * returned to it when the process is released, so its memory (and the
+ * capacity of its containers) is reused by the next process of any UE.
+ *
+ * \tparam State the state of a process, default constructible. It is reset by
+ * ResetHarqProcess(State&), found by argument dependent lookup, or by assigning
+ * State() if there is none. The reset must drop everything the released process
+ * held, e.g. replace its packet burst, since the state is handed to the next
+ * process of any UE; only the capacity of the containers may be kept.
+ */
+template <class State>
+class LazyHarqProcessPool
+{
+  public:
+    /**
+     * \param numProcesses the HARQ processes of a UE
+     */
+    explicit LazyHarqProcessPool(uint32_t numProcesses)
+        : m_numProcesses(numProcesses)
+    {
+    }
+
+    /// Add a UE; its processes take no state until used
+    void AddUe(uint16_t rnti)
+    {
+        m_ues.emplace(rnti, std::vector<uint32_t>(m_numProcesses, NONE));
+    }
+
+    /// Remove a UE and release its processes
+    void RemoveUe(uint16_t rnti)
+    {
+        auto it = m_ues.find(rnti);
+        if (it == m_ues.end())
+        {
+            return;
+        }
+        for (uint32_t index : it->second)
+        {
+            if (index != NONE)
+            {
+                Recycle(index);
+            }
+        }
+        m_ues.erase(it);
+    }
+
+    /**
+     * \param rnti the UE
+     * \param harqId the process
+     * \return the state of the process, allocated if the process was not in use
+     */
+    State& Get(uint16_t rnti, uint8_t harqId)
+    {
+        uint32_t& index = GetIndex(rnti, harqId);
+        if (index == NONE)
+        {
+            if (m_free.empty())
+            {
+                index = m_states.size();
+                m_states.emplace_back();
+            }
+            else
+            {
+                index = m_free.back();
+                m_free.pop_back();
+            }
+            ++m_live;
+            m_peakLive = std::max(m_peakLive, m_live);
+        }
+        return m_states[index];
+    }
+
+    /**
+     * \return the state of the process, nullptr if the process is not in use
+     */
+    State* Find(uint16_t rnti, uint8_t harqId)
+    {
+        uint32_t index = GetIndex(rnti, harqId);
+        return index == NONE ? nullptr : &m_states[index];
+    }
+
+    /// Release a process (e.g. on ACK or after the last retransmission)
+    void Release(uint16_t rnti, uint8_t harqId)
+    {
+        uint32_t& index = GetIndex(rnti, harqId);
+        if (index != NONE)
+        {
+            Recycle(index);
+            index = NONE;
+        }
+    }
+
+    /// \return the processes in use
+    std::size_t GetLiveProcesses() const
+    {
+        return m_live;
+    }
+
+    /// \return the largest number of processes in use at the same time
+    std::size_t GetPeakLiveProcesses() const
+    {
+        return m_peakLive;
+    }
+
+    /// \return the states allocated, in use or free
+    std::size_t GetAllocatedStates() const
+    {
+        return m_states.size();
+    }
+
+  private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    uint32_t& GetIndex(uint16_t rnti, uint8_t harqId)
+    {
+        auto it = m_ues.find(rnti);
+        NS_ASSERT_MSG(it != m_ues.end(), "RNTI " << rnti << " not added");
+        NS_ASSERT_MSG(harqId < m_numProcesses, "HARQ process " << +harqId << " out of range");
+        return it->second[harqId];
+    }
+
+    void Recycle(uint32_t index)
+    {
+        ResetState(m_states[index]);
+        m_free.push_back(index);
+        --m_live;
+    }
+
+    template <class S>
+    static auto ResetState(S& state) -> decltype(ResetHarqProcess(state), void())
+    {
+        ResetHarqProcess(state);
+    }
+
+    template <class S, class... Ignored>
+    static void ResetState(S& state, Ignored...)
+    {
+        state = S();
+    }
+
+    uint32_t m_numProcesses;
+    std::unordered_map<uint16_t, std::vector<uint32_t>> m_ues; //!< process to state index
+    std::deque<State> m_states; //!< stable addresses, never shrinks
+    std::vector<uint32_t> m_free;
+    std::size_t m_live{0};
+    std::size_t m_peakLive{0};
+};
+
+} // namespace ns3
+
+#endif /* LAZY_HARQ_PROCESS_POOL_H */
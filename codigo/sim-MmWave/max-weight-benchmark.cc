@@ -0,0 +1,163 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Benchmark of the MaxWeight slot allocation with the per-UE state in arrays
+ * (MaxWeightKernel) against the same policy on per-UE maps with a full sort
+ * (MaxWeightReference), from 10 to 1000 active UEs per cell. Every slot, a
+ * fraction of the UEs receives new data and a new CQI, some TBs fail and need a
+ * retransmission, and the allocated symbols drain the buffers. The two
+ * allocations are compared at every slot. Both schedulers reuse their output
+ * and scratch vectors, so no allocation is timed.
+ *
+ * ./ns3 run "max-weight-benchmark --nSlots=20000"
+ */
+
+#include "max-weight-kernel.h"
+
+#include "ns3/core-module.h"
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("MaxWeightBenchmark");
+
+/// Arrivals, CQI updates and HARQ failures of one slot, applied to both schedulers
+struct SlotInput
+{
+    std::vector<std::pair<uint16_t, uint32_t>> arrivals; //!< rnti, bytes
+    std::vector<std::pair<uint16_t, float>> rates;       //!< rnti, bytes per symbol
+    std::vector<uint16_t> failures;                      //!< rnti of the failed TBs
+};
+
+int
+main(int argc, char* argv[])
+{
+    uint32_t nSlots = 20000;
+    uint32_t symPerSlot = 6;
+    uint32_t minSymbols = 1;
+    double arrivalProbability = 0.1;
+    double failureProbability = 0.1;
+    std::string ueCounts = "10,30,100,300,1000";
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("nSlots", "Slots simulated for every number of UEs", nSlots);
+    cmd.AddValue("symPerSlot", "Data symbols per slot", symPerSlot);
+    cmd.AddValue("minSymbols", "Fewest symbols given to a UE", minSymbols);
+    cmd.AddValue("arrivalProbability",
+                 "Probability that a UE receives new data in a slot",
+                 arrivalProbability);
+    cmd.AddValue("failureProbability",
+                 "Probability that a new transmission needs a HARQ retransmission",
+                 failureProbability);
+    cmd.AddValue("ueCounts", "Comma separated numbers of UEs", ueCounts);
+    cmd.Parse(argc, argv);
+
+    Ptr<UniformRandomVariable> uniform = CreateObject<UniformRandomVariable>();
+    std::cout << "nUes\tmapNsPerSlot\tarrayNsPerSlot\tspeedup\tallocations" << std::endl;
+
+    std::stringstream counts(ueCounts);
+    std::string count;
+    while (std::getline(counts, count, ','))
+    {
+        uint32_t nUes = std::stoul(count);
+
+        // the inputs are drawn in advance, so only the scheduling is timed
+        std::vector<SlotInput> inputs(nSlots);
+        for (SlotInput& input : inputs)
+        {
+            for (uint16_t rnti = 1; rnti <= nUes; ++rnti)
+            {
+                if (uniform->GetValue() < arrivalProbability)
+                {
+                    input.arrivals.emplace_back(rnti, uniform->GetInteger(20, 1500));
+                    input.rates.emplace_back(rnti, uniform->GetValue(10, 400));
+                }
+                if (uniform->GetValue() < failureProbability)
+                {
+                    input.failures.push_back(rnti);
+                }
+            }
+        }
+
+        MaxWeightKernel kernel;
+        MaxWeightReference reference;
+        for (uint16_t rnti = 1; rnti <= nUes; ++rnti)
+        {
+            kernel.AddUe(rnti);
+            reference.m_ues[rnti];
+        }
+
+        double kernelNs = 0;
+        double referenceNs = 0;
+        uint64_t nAllocations = 0;
+        for (const SlotInput& input : inputs)
+        {
+            for (const auto& a : input.arrivals)
+            {
+                kernel.SetBuffer(a.first, kernel.GetBuffer(a.first) + a.second);
+                reference.m_ues[a.first].buffer += a.second;
+            }
+            for (const auto& r : input.rates)
+            {
+                kernel.SetRate(r.first, r.second);
+                reference.m_ues[r.first].rate = r.second;
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            const std::vector<MaxWeightAllocation>& expected =
+                reference.Schedule(symPerSlot, minSymbols);
+            auto middle = std::chrono::steady_clock::now();
+            const std::vector<MaxWeightAllocation>& allocations =
+                kernel.Schedule(symPerSlot, minSymbols);
+            auto end = std::chrono::steady_clock::now();
+            referenceNs += std::chrono::duration<double, std::nano>(middle - start).count();
+            kernelNs += std::chrono::duration<double, std::nano>(end - middle).count();
+            NS_ABORT_MSG_UNLESS(allocations == expected,
+                                "Different allocations with " << nUes << " UEs");
+            nAllocations += allocations.size();
+
+            // drain the buffers; a failed new transmission is retransmitted in a later slot
+            for (const MaxWeightAllocation& a : allocations)
+            {
+                MaxWeightReference::Ue& ue = reference.m_ues[a.rnti];
+                if (a.retx)
+                {
+                    ue.retx = 0;
+                    kernel.SetRetx(a.rnti, 0);
+                    continue;
+                }
+                if (std::find(input.failures.begin(), input.failures.end(), a.rnti) !=
+                    input.failures.end())
+                {
+                    ue.retx = a.symbols;
+                    kernel.SetRetx(a.rnti, a.symbols);
+                }
+                uint32_t sent = std::min<uint32_t>(ue.buffer, a.symbols * ue.rate);
+                ue.buffer -= sent;
+                kernel.SetBuffer(a.rnti, ue.buffer);
+            }
+        }
+
+        std::cout << nUes << "\t" << referenceNs / nSlots << "\t" << kernelNs / nSlots << "\t"
+                  << referenceNs / kernelNs << "\t" << nAllocations << std::endl;
+    }
+    return 0;
+}
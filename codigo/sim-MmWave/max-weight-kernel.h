@@ -0,0 +1,422 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MAX_WEIGHT_KERNEL_H
+#define MAX_WEIGHT_KERNEL_H
+
+#include "ns3/assert.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+namespace ns3
+{
+
+/// A symbol allocation of one slot
+struct MaxWeightAllocation
+{
+    uint16_t rnti;
+    uint32_t symbols;
+    bool retx; //!< HARQ retransmission
+
+    bool operator==(const MaxWeightAllocation& o) const
+    {
+        return rnti == o.rnti && symbols == o.symbols && retx == o.retx;
+    }
+};
+
+/**
+ * Slot allocation of the MaxWeight policy of MmWaveFlexTtiMaxWeightMacScheduler,
+ * with the per-UE state in contiguous arrays.
+ *
+ * Every UE has a dense slot, assigned when it is added and reused when it is
+ * removed (the last UE is moved in its place), and the RNTI to slot map is a
+ * flat table. The buffer, the rate (bytes per symbol at the current MCS) and the
+ * HARQ retransmission symbols are stored in separate arrays (structure of
+ * arrays), so the weights, backlog times rate, are computed by a loop the
+ * compiler vectorizes. Only as many UEs as the slot can serve are then
+ * selected, by partial selection (nth_element) instead of sorting all of them.
+ *
+ * Each slot, the pending retransmissions are served first, in RNTI order. Then
+ * come the UEs with a delay budget whose head of line delay has reached the
+ * urgency fraction of the budget, by increasing slack. The remaining symbols go
+ * to the UEs of largest weight, backlog times rate times priority. Each UE
+ * receives the symbols needed to empty its buffer, at least MinSymbols, until
+ * the slot is full. Ties are broken by RNTI.
+ *
+ * The kernel is exercised by max-weight-benchmark only: no scenario installs it
+ * in the MAC, so the priority and the delay budget set here do not reach the
+ * simulations, where the priority class of a flow acts through its QCI alone.
+ */
+class MaxWeightKernel
+{
+  public:
+    MaxWeightKernel()
+        : m_slotOf(UINT16_MAX + 1, NO_SLOT)
+    {
+    }
+
+    /**
+     * \param rnti the UE
+     * \return the dense slot of the UE
+     */
+    uint32_t AddUe(uint16_t rnti)
+    {
+        if (m_slotOf[rnti] != NO_SLOT)
+        {
+            return m_slotOf[rnti];
+        }
+        uint32_t slot = m_rnti.size();
+        m_slotOf[rnti] = slot;
+        m_rnti.push_back(rnti);
+        m_buffer.push_back(0);
+        m_rate.push_back(0);
+        m_retx.push_back(0);
+        m_priority.push_back(1);
+        m_holDelay.push_back(0);
+        m_budget.push_back(0);
+        m_served.push_back(0);
+        m_weight.push_back(0);
+        return slot;
+    }
+
+    void RemoveUe(uint16_t rnti)
+    {
+        uint32_t slot = m_slotOf[rnti];
+        NS_ASSERT_MSG(slot != NO_SLOT, "RNTI " << rnti << " not added");
+        uint32_t last = m_rnti.size() - 1;
+        m_slotOf[m_rnti[last]] = slot;
+        m_rnti[slot] = m_rnti[last];
+        m_buffer[slot] = m_buffer[last];
+        m_rate[slot] = m_rate[last];
+        m_retx[slot] = m_retx[last];
+        m_priority[slot] = m_priority[last];
+        m_holDelay[slot] = m_holDelay[last];
+        m_budget[slot] = m_budget[last];
+        m_rnti.pop_back();
+        m_buffer.pop_back();
+        m_rate.pop_back();
+        m_retx.pop_back();
+        m_priority.pop_back();
+        m_holDelay.pop_back();
+        m_budget.pop_back();
+        m_served.pop_back();
+        m_weight.pop_back();
+        m_slotOf[rnti] = NO_SLOT;
+    }
+
+    std::size_t GetNUes() const
+    {
+        return m_rnti.size();
+    }
+
+    /// Set the RLC backlog of a UE, in bytes
+    void SetBuffer(uint16_t rnti, uint32_t bytes)
+    {
+        m_buffer[GetSlot(rnti)] = bytes;
+    }
+
+    uint32_t GetBuffer(uint16_t rnti) const
+    {
+        return m_buffer[GetSlot(rnti)];
+    }
+
+    /// Set the bytes a UE can receive per symbol, at the MCS of its last CQI
+    void SetRate(uint16_t rnti, float bytesPerSymbol)
+    {
+        m_rate[GetSlot(rnti)] = bytesPerSymbol;
+    }
+
+    /// Set the symbols of the pending HARQ retransmission of a UE, 0 if none
+    void SetRetx(uint16_t rnti, uint32_t symbols)
+    {
+        m_retx[GetSlot(rnti)] = symbols;
+    }
+
+    /// Set the priority weight of a UE, 1 by default
+    void SetPriority(uint16_t rnti, float priority)
+    {
+        m_priority[GetSlot(rnti)] = priority;
+    }
+
+    /**
+     * Set the delay budget of a UE, 0 (the default) if it has none
+     * \param rnti the UE
+     * \param budgetMs the delay budget of the class of the UE
+     */
+    void SetDelayBudget(uint16_t rnti, float budgetMs)
+    {
+        m_budget[GetSlot(rnti)] = budgetMs;
+    }
+
+    /// Set the head of line delay of the buffer of a UE
+    void SetHolDelay(uint16_t rnti, float holDelayMs)
+    {
+        m_holDelay[GetSlot(rnti)] = holDelayMs;
+    }
+
+    /// Set the fraction of the delay budget after which a UE is urgent, 0.5 by default
+    void SetUrgency(float urgency)
+    {
+        m_urgency = urgency;
+    }
+
+    /**
+     * Allocate the symbols of a slot
+     * \param nSymbols the symbols available for data
+     * \param minSymbols the fewest symbols given to a UE, 0 is taken as 1
+     * \return the allocations, valid until the next call
+     */
+    const std::vector<MaxWeightAllocation>& Schedule(uint32_t nSymbols, uint32_t minSymbols)
+    {
+        // a UE with data always needs at least one symbol, and the candidates are cut
+        // at remaining / minSymbols
+        minSymbols = std::max<uint32_t>(minSymbols, 1);
+        m_allocations.clear();
+        std::size_t n = m_rnti.size();
+        uint32_t remaining = nSymbols;
+
+        // HARQ retransmissions first, in RNTI order
+        m_candidates.clear();
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            if (m_retx[i] > 0)
+            {
+                m_candidates.push_back(i);
+            }
+        }
+        std::sort(m_candidates.begin(), m_candidates.end(), [this](uint32_t a, uint32_t b) {
+            return m_rnti[a] < m_rnti[b];
+        });
+        for (uint32_t i : m_candidates)
+        {
+            if (m_retx[i] > remaining)
+            {
+                continue;
+            }
+            remaining -= m_retx[i];
+            m_allocations.push_back({m_rnti[i], m_retx[i], true});
+        }
+
+        // UEs close to their delay budget, by increasing slack
+        m_candidates.clear();
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            m_served[i] = 0;
+            if (m_budget[i] > 0 && m_buffer[i] > 0 && m_rate[i] > 0 && m_retx[i] == 0 &&
+                m_holDelay[i] >= m_urgency * m_budget[i])
+            {
+                m_candidates.push_back(i);
+            }
+        }
+        std::sort(m_candidates.begin(), m_candidates.end(), [this](uint32_t a, uint32_t b) {
+            float slackA = m_budget[a] - m_holDelay[a];
+            float slackB = m_budget[b] - m_holDelay[b];
+            return slackA < slackB || (slackA == slackB && m_rnti[a] < m_rnti[b]);
+        });
+        for (uint32_t i : m_candidates)
+        {
+            if (remaining < minSymbols)
+            {
+                break;
+            }
+            remaining -= Allocate(i, remaining, minSymbols);
+            m_served[i] = 1;
+        }
+
+        // weights: no branches and no indirection, vectorized
+        const uint32_t* buffer = m_buffer.data();
+        const float* rate = m_rate.data();
+        const float* priority = m_priority.data();
+        const uint32_t* retx = m_retx.data();
+        const uint8_t* served = m_served.data();
+        float* weight = m_weight.data();
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            weight[i] = float(buffer[i]) * rate[i] * priority[i] * float(retx[i] == 0) *
+                        float(served[i] == 0);
+        }
+
+        m_candidates.clear();
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            if (weight[i] > 0)
+            {
+                m_candidates.push_back(i);
+            }
+        }
+        auto higher = [this](uint32_t a, uint32_t b) {
+            return m_weight[a] > m_weight[b] ||
+                   (m_weight[a] == m_weight[b] && m_rnti[a] < m_rnti[b]);
+        };
+        std::size_t k = std::min<std::size_t>(m_candidates.size(), remaining / minSymbols);
+        if (k < m_candidates.size())
+        {
+            std::nth_element(m_candidates.begin(),
+                             m_candidates.begin() + k,
+                             m_candidates.end(),
+                             higher);
+        }
+        std::sort(m_candidates.begin(), m_candidates.begin() + k, higher);
+
+        for (std::size_t j = 0; j < k && remaining >= minSymbols; ++j)
+        {
+            remaining -= Allocate(m_candidates[j], remaining, minSymbols);
+        }
+        return m_allocations;
+    }
+
+  private:
+    static constexpr uint32_t NO_SLOT = UINT32_MAX;
+
+    /// Give a UE the symbols to empty its buffer, return them
+    uint32_t Allocate(uint32_t i, uint32_t remaining, uint32_t minSymbols)
+    {
+        uint32_t needed = std::ceil(m_buffer[i] / m_rate[i]);
+        uint32_t symbols = std::min(std::max(needed, minSymbols), remaining);
+        m_allocations.push_back({m_rnti[i], symbols, false});
+        return symbols;
+    }
+
+    uint32_t GetSlot(uint16_t rnti) const
+    {
+        NS_ASSERT_MSG(m_slotOf[rnti] != NO_SLOT, "RNTI " << rnti << " not added");
+        return m_slotOf[rnti];
+    }
+
+    std::vector<uint32_t> m_slotOf; //!< dense slot of every RNTI
+    std::vector<uint16_t> m_rnti;
+    std::vector<uint32_t> m_buffer;
+    std::vector<float> m_rate;
+    std::vector<uint32_t> m_retx;
+    std::vector<float> m_priority;
+    std::vector<float> m_holDelay; //!< ms
+    std::vector<float> m_budget;   //!< ms, 0 if none
+    std::vector<uint8_t> m_served; //!< in the current slot, before the weights
+    std::vector<float> m_weight;
+    float m_urgency{0.5};
+    std::vector<uint32_t> m_candidates;
+    std::vector<MaxWeightAllocation> m_allocations;
+};
+
+/**
+ * The same policy on per-UE maps with a full sort, as the MmWaveFlexTti
+ * schedulers keep their state, for the validation and the benchmark of
+ * MaxWeightKernel. Like the kernel, it reuses its buffers from slot to slot,
+ * so that the benchmark compares the layout and the sort, not the allocations.
+ */
+class MaxWeightReference
+{
+  public:
+    struct Ue
+    {
+        uint32_t buffer{0};
+        float rate{0};
+        uint32_t retx{0};
+        float priority{1};
+        float holDelay{0};
+        float budget{0};
+    };
+
+    std::map<uint16_t, Ue> m_ues;
+    float m_urgency{0.5};
+
+    /// \copydoc MaxWeightKernel::Schedule
+    const std::vector<MaxWeightAllocation>& Schedule(uint32_t nSymbols, uint32_t minSymbols)
+    {
+        minSymbols = std::max<uint32_t>(minSymbols, 1);
+        std::vector<MaxWeightAllocation>& allocations = m_allocations;
+        std::vector<std::pair<float, uint16_t>>& urgent = m_urgent;
+        std::vector<uint16_t>& served = m_served;
+        std::vector<std::pair<float, uint16_t>>& weights = m_weights;
+        allocations.clear();
+        urgent.clear();
+        served.clear();
+        weights.clear();
+        uint32_t remaining = nSymbols;
+        for (const auto& ue : m_ues)
+        {
+            if (ue.second.retx > 0 && ue.second.retx <= remaining)
+            {
+                remaining -= ue.second.retx;
+                allocations.push_back({ue.first, ue.second.retx, true});
+            }
+        }
+        for (const auto& ue : m_ues)
+        {
+            const Ue& u = ue.second;
+            if (u.budget > 0 && u.buffer > 0 && u.rate > 0 && u.retx == 0 &&
+                u.holDelay >= m_urgency * u.budget)
+            {
+                urgent.emplace_back(u.budget - u.holDelay, ue.first);
+            }
+        }
+        std::sort(urgent.begin(), urgent.end());
+        for (const auto& w : urgent)
+        {
+            if (remaining < minSymbols)
+            {
+                break;
+            }
+            const Ue& ue = m_ues.at(w.second);
+            uint32_t needed = std::ceil(ue.buffer / ue.rate);
+            uint32_t symbols = std::min(std::max(needed, minSymbols), remaining);
+            remaining -= symbols;
+            allocations.push_back({w.second, symbols, false});
+            served.push_back(w.second);
+        }
+
+        for (const auto& ue : m_ues)
+        {
+            bool isServed = std::find(served.begin(), served.end(), ue.first) != served.end();
+            float weight = float(ue.second.buffer) * ue.second.rate * ue.second.priority *
+                           float(ue.second.retx == 0) * float(!isServed);
+            if (weight > 0)
+            {
+                weights.emplace_back(weight, ue.first);
+            }
+        }
+        std::sort(weights.begin(), weights.end(), [](const auto& a, const auto& b) {
+            return a.first > b.first || (a.first == b.first && a.second < b.second);
+        });
+        for (const auto& w : weights)
+        {
+            if (remaining < minSymbols)
+            {
+                break;
+            }
+            const Ue& ue = m_ues.at(w.second);
+            uint32_t needed = std::ceil(ue.buffer / ue.rate);
+            uint32_t symbols = std::min(std::max(needed, minSymbols), remaining);
+            remaining -= symbols;
+            allocations.push_back({w.second, symbols, false});
+        }
+        return allocations;
+    }
+
+  private:
+    std::vector<MaxWeightAllocation> m_allocations;
+    std::vector<std::pair<float, uint16_t>> m_urgent;  //!< slack, rnti
+    std::vector<uint16_t> m_served;                    //!< rnti of the urgent UEs served
+    std::vector<std::pair<float, uint16_t>> m_weights; //!< weight, rnti
+};
+
+} // namespace ns3
+
+#endif /* MAX_WEIGHT_KERNEL_H */
@@ -0,0 +1,62 @@
+#!/bin/bash
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License version 2 as
+# published by the Free Software Foundation;
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#
+#  Compare the wall clock time of mc-twoenbs.cc run sequentially and in the
+#  distributed mode (remote host on MPI rank 1), and check that two distributed
+#  runs produce the same traces. The events executed by each rank bound the
+#  speedup: (events 0 + events 1) / max (events 0, events 1).
+#
+#  Run from the root of an ns-3 tree configured with --enable-mpi, with
+#  mc-twoenbs.cc in scratch/. Extra arguments are passed to the scenario, e.g.
+#  $ bash mc-twoenbs-pdes-benchmark.sh --interPckInterval=20
+#
+
+RUNS=${RUNS:-3}
+OUT=${OUT:-pdes-benchmark}
+ARGS="--print=false $*"
+
+mkdir -p $OUT
+./ns3 build mc-twoenbs || exit 1
+
+elapsed() {
+    local start=$(date +%s.%N)
+    "$@" > /dev/null 2>&1
+    echo "$(date +%s.%N) - $start" | bc
+}
+
+echo -e "run\tsequential(s)\tdistributed(s)\tspeedup\trank0Events\trank1Events\tspeedupBound" \
+    | tee $OUT/speedup.txt
+for run in $(seq 1 $RUNS); do
+    mkdir -p $OUT/seq-$run $OUT/mpi-$run
+    seq=$(elapsed ./ns3 run "mc-twoenbs $ARGS --outPath=$OUT/seq-$run/")
+    mpi=$(elapsed ./ns3 run mc-twoenbs \
+        --command-template="mpiexec -np 2 %s $ARGS --distributed=true --outPath=$OUT/mpi-$run/")
+    e0=$(cut -f2 $OUT/mpi-$run/PdesEvents0.txt)
+    e1=$(cut -f2 $OUT/mpi-$run/PdesEvents1.txt)
+    bound=$(echo "scale=3; ($e0 + $e1) / $(( e0 > e1 ? e0 : e1 ))" | bc)
+    echo -e "$run\t$seq\t$mpi\t$(echo "scale=3; $seq / $mpi" | bc)\t$e0\t$e1\t$bound" \
+        | tee -a $OUT/speedup.txt
+done
+
+# the null message synchronization is deterministic: every distributed run must
+# produce the same traces
+for run in $(seq 2 $RUNS); do
+    if diff -rq $OUT/mpi-1 $OUT/mpi-$run > /dev/null; then
+        echo "distributed run $run: identical to run 1"
+    else
+        echo "distributed run $run: DIFFERENT from run 1"
+    fi
+done
@@ -16,6 +16,18 @@
  * Author: Michele Polese <michele.polese@gmail.com>
  */
 
+#include "channel-precision-report.h"
+#include "interference-culling-channel.h"
+#include "ladder-queue-scheduler.h"
+#include "packet-pool-allocator.h"
+#include "parallel-three-gpp-channel-model.h"
+#include "profiling-simulator-impl.h"
+#include "rlc-buffer-pool.h"
+#include "simulation-progress-reporter.h"
+#include "tabulated-antenna-model.h"
+#include "warm-up-detector.h"
+#include "x2-stats-collector.h"
+
 #include "ns3/applications-module.h"
 #include "ns3/buildings-helper.h"
 #include "ns3/buildings-module.h"
@@ -32,11 +44,19 @@
 #include "ns3/point-to-point-helper.h"
 #include <ns3/lte-ue-net-device.h>
 #include <ns3/random-variable-stream.h>
+#ifdef NS3_MPI
+#include "ns3/mpi-interface.h"
+
+#include <mpi.h>
+#endif
 
+#include <cmath>
 #include <ctime>
 #include <iostream>
 #include <list>
+#include <map>
 #include <stdlib.h>
+#include <vector>
 
 using namespace ns3;
 using namespace mmwave;
@@ -293,6 +313,23 @@ static ns3::GlobalValue g_bufferSize("bufferSize",
                                      "RLC tx buffer size (MB)",
                                      ns3::UintegerValue(20),
                                      ns3::MakeUintegerChecker<uint32_t>());
+static ns3::GlobalValue g_rlcPoolSize(
+    "rlcPoolSize",
+    "If > 0, the RLC tx buffers of each eNB share a pool of this size (MB), and bufferSize is the "
+    "quota of a single bearer",
+    ns3::UintegerValue(0),
+    ns3::MakeUintegerChecker<uint32_t>());
+static ns3::GlobalValue g_rlcPoolPolicy("rlcPoolPolicy",
+                                        "How the RLC pool is divided among the bearers: Partition "
+                                        "(equal shares) or Shared (on demand)",
+                                        ns3::StringValue("Shared"),
+                                        ns3::MakeStringChecker());
+static ns3::GlobalValue g_x2StatsEpoch(
+    "x2StatsEpoch",
+    "If > 0, aggregate the X2 messages per link and type over epochs of this duration (ms) in "
+    "X2EpochStats, instead of a line per message in X2Stats",
+    ns3::UintegerValue(100),
+    ns3::MakeUintegerChecker<uint32_t>());
 static ns3::GlobalValue g_x2Latency("x2Latency",
                                     "Latency on X2 interface (us)",
                                     ns3::DoubleValue(500),
@@ -323,6 +360,13 @@ static ns3::GlobalValue g_outPath("outPath",
                                   "The path of output log files",
                                   ns3::StringValue("./"),
                                   ns3::MakeStringChecker());
+static ns3::GlobalValue g_autoWarmUp(
+    "autoWarmUp",
+    "If true, start the applications, the UE movement, the traces and the X2 statistics as soon "
+    "as the SINR estimates reported to the LTE eNB are stationary, instead of after the "
+    "transient of the SINR filter (when the traces start at time 0)",
+    ns3::BooleanValue(false),
+    ns3::MakeBooleanChecker());
 static ns3::GlobalValue g_noiseAndFilter(
     "noiseAndFilter",
     "If true, use noisy SINR samples, filtered. If false, just use the SINR measure",
@@ -344,6 +388,142 @@ static ns3::GlobalValue g_lteUplink("lteUplink",
                                     "If true, always use LTE for uplink signalling",
                                     ns3::BooleanValue(false),
                                     ns3::MakeBooleanChecker());
+static ns3::GlobalValue g_channelThreads(
+    "channelThreads",
+    "If > 0, regenerate the 3GPP channels in batches at every UpdatePeriod, on this number of "
+    "threads. If 0, use the lazy, serial ThreeGppChannelModel",
+    ns3::UintegerValue(0),
+    ns3::MakeUintegerChecker<uint32_t>());
+static ns3::GlobalValue g_cullingMargin(
+    "cullingMargin",
+    "If >= 0, skip the receivers where a signal is guaranteed to arrive this many dB below the "
+    "thermal noise floor. If < 0, evaluate every transmission at every receiver",
+    ns3::DoubleValue(-1),
+    ns3::MakeDoubleChecker<double>());
+static ns3::GlobalValue g_distributed(
+    "distributed",
+    "If true, simulate the remote host in a second logical process (MPI rank 1), synchronized "
+    "with the RAN and the EPC (rank 0) by null messages, with the remote host link delay as "
+    "lookahead. Only the remote host is partitioned: the EPC helper creates the PGW, SGW and MME "
+    "on system 0 and the spectrum channels couple all the cells. Needs an MPI build, "
+    "mpirun -np 2 and print=false",
+    ns3::BooleanValue(false),
+    ns3::MakeBooleanChecker());
+static ns3::GlobalValue g_packetPool(
+    "packetPool",
+    "If true, serve the small allocations (packets, buffers, headers, tags, events) from "
+    "per-thread size-class pools and write the allocation counters at the end of the simulation. "
+    "Needs a build with packet-pool-allocator.cc and -DNS3_PACKET_POOL",
+    ns3::BooleanValue(false),
+    ns3::MakeBooleanChecker());
+static ns3::GlobalValue g_progressInterval(
+    "progressInterval",
+    "If > 0, report the simulation speed, ETA and memory about every this many wall clock seconds",
+    ns3::DoubleValue(0),
+    ns3::MakeDoubleChecker<double>(0.0));
+static ns3::GlobalValue g_profileEvents(
+    "profileEvents",
+    "If true, run with the ProfilingSimulatorImpl and write the execution time and the number of "
+    "the events of each type at the end of the simulation",
+    ns3::BooleanValue(false),
+    ns3::MakeBooleanChecker());
+static ns3::GlobalValue g_benchmark(
+    "benchmark",
+    "If true, print the number of events executed, for the scheduler benchmark",
+    ns3::BooleanValue(false),
+    ns3::MakeBooleanChecker());
+static ns3::GlobalValue g_print("print",
+                                "If true, only print the map of buildings, UEs and eNBs, without "
+                                "running the simulation",
+                                ns3::BooleanValue(true),
+                                ns3::MakeBooleanChecker());
+static ns3::GlobalValue g_channelPrecisionReport(
+    "channelPrecisionReport",
+    "If true and channelThreads > 0, report the memory the channel coefficients use in double "
+    "precision and would use in single precision, and the beamforming gain error of the latter, "
+    "at the end of the simulation. The simulation itself always uses double precision",
+    ns3::BooleanValue(false),
+    ns3::MakeBooleanChecker());
+static ns3::GlobalValue g_antennaTableResolution(
+    "antennaTableResolution",
+    "If > 0, use the 3GPP antenna element pattern, tabulated with this resolution (degrees). If 0, "
+    "use isotropic elements",
+    ns3::DoubleValue(0),
+    ns3::MakeDoubleChecker<double>(0.0));
+
+/**
+ * Install the applications of the remote host: the downlink clients towards the
+ * UEs and the uplink sinks
+ */
+void
+InstallRemoteHostApplications(Ptr<Node> remoteHost,
+                              const std::vector<Ipv4Address>& ueAddresses,
+                              bool dl,
+                              bool ul,
+                              uint16_t dlPort,
+                              uint16_t ulPort,
+                              uint32_t interPacketInterval,
+                              ApplicationContainer& clientApps,
+                              ApplicationContainer& serverApps)
+{
+    for (uint32_t u = 0; u < ueAddresses.size(); ++u)
+    {
+        if (dl)
+        {
+            UdpClientHelper dlClient(ueAddresses[u], dlPort);
+            dlClient.SetAttribute("Interval", TimeValue(MicroSeconds(interPacketInterval)));
+            dlClient.SetAttribute("MaxPackets", UintegerValue(0xFFFFFFFF));
+            clientApps.Add(dlClient.Install(remoteHost));
+        }
+        if (ul)
+        {
+            PacketSinkHelper ulPacketSinkHelper(
+                "ns3::UdpSocketFactory",
+                InetSocketAddress(Ipv4Address::GetAny(), ulPort + 1 + u));
+            ulPacketSinkHelper.SetAttribute("PacketWindowSize", UintegerValue(256));
+            serverApps.Add(ulPacketSinkHelper.Install(remoteHost));
+        }
+    }
+}
+
+/**
+ * Write the number of events executed by this logical process, so that the load
+ * balance of the distributed mode, and the speedup it allows, can be computed
+ */
+void
+PrintRankEvents(std::string fileName)
+{
+    std::ofstream outFile(fileName.c_str(), std::ios_base::out | std::ios_base::trunc);
+    outFile << Simulator::GetSystemId() << "\t" << Simulator::GetEventCount() << std::endl;
+}
+
+/**
+ * Number of SINR samples of the transient of the filter, for a report periodicity:
+ * 150, 100 and 50 samples at 1600, 12800 and 25600 us, piecewise linear in the
+ * logarithm of the periodicity in between, constant outside
+ */
+int
+GetWindowForTransient(int reportTablePeriodicity)
+{
+    const double periodicities[] = {1600, 12800, 25600};
+    const double windows[] = {150, 100, 50};
+    double p = std::log2(std::max(reportTablePeriodicity, 1));
+    if (p <= std::log2(periodicities[0]))
+    {
+        return windows[0];
+    }
+    for (uint32_t i = 1; i < 3; ++i)
+    {
+        double hi = std::log2(periodicities[i]);
+        if (p <= hi)
+        {
+            double lo = std::log2(periodicities[i - 1]);
+            return std::lround(windows[i - 1] +
+                               (windows[i] - windows[i - 1]) * (p - lo) / (hi - lo));
+        }
+    }
+    return windows[2];
+}
 
 int
 main(int argc, char* argv[])
@@ -362,6 +542,30 @@ main(int argc, char* argv[])
     StringValue stringValue;
     DoubleValue doubleValue;
     // EnumValue enumValue;
+
+    GlobalValue::GetValueByName("distributed", booleanValue);
+    bool distributed = booleanValue.Get();
+    GlobalValue::GetValueByName("print", booleanValue);
+    bool print = booleanValue.Get();
+    GlobalValue::GetValueByName("packetPool", booleanValue);
+    bool packetPool = booleanValue.Get();
+    NS_ABORT_MSG_IF(packetPool && !PoolAllocator::IsBuiltIn(),
+                    "packetPool needs a build with packet-pool-allocator.cc and -DNS3_PACKET_POOL");
+    PoolAllocator::Enable(packetPool);
+    uint32_t systemId = 0;
+    if (distributed)
+    {
+#ifdef NS3_MPI
+        NS_ABORT_MSG_IF(print, "The distributed mode needs print=false");
+        GlobalValue::Bind("SimulatorImplementationType",
+                          StringValue("ns3::NullMessageSimulatorImpl"));
+        MpiInterface::Enable(&argc, &argv);
+        NS_ABORT_MSG_IF(MpiInterface::GetSize() != 2, "The distributed mode needs 2 MPI ranks");
+        systemId = MpiInterface::GetSystemId();
+#else
+        NS_FATAL_ERROR("The distributed mode needs ns-3 built with MPI support");
+#endif
+    }
     GlobalValue::GetValueByName("numBlocks", uintegerValue);
     uint32_t numBlocks = uintegerValue.Get();
     GlobalValue::GetValueByName("maxXAxis", doubleValue);
@@ -373,25 +577,10 @@ main(int argc, char* argv[])
     double ueFinalPosition = 110;
 
     // Variables for the RT
-    int windowForTransient = 150; // number of samples for the vector to use in the filter
     GlobalValue::GetValueByName("reportTablePeriodicity", uintegerValue);
     int ReportTablePeriodicity = (int)uintegerValue.Get(); // in microseconds
-    if (ReportTablePeriodicity == 1600)
-    {
-        windowForTransient = 150;
-    }
-    else if (ReportTablePeriodicity == 25600)
-    {
-        windowForTransient = 50;
-    }
-    else if (ReportTablePeriodicity == 12800)
-    {
-        windowForTransient = 100;
-    }
-    else
-    {
-        NS_ASSERT_MSG(false, "Unrecognized");
-    }
+    // number of samples for the vector to use in the filter
+    int windowForTransient = GetWindowForTransient(ReportTablePeriodicity);
 
     int vectorTransient = windowForTransient * ReportTablePeriodicity;
 
@@ -443,6 +632,15 @@ main(int argc, char* argv[])
     std::string udpSentFilename = "UdpSent";
     std::string udpReceivedFilename = "UdpReceived";
     std::string extension = ".txt";
+    GlobalValue::GetValueByName("profileEvents", booleanValue);
+    if (booleanValue.Get())
+    {
+        NS_ABORT_MSG_IF(distributed, "The event profile needs distributed=false");
+        GlobalValue::Bind("SimulatorImplementationType",
+                          StringValue("ns3::ProfilingSimulatorImpl"));
+        Config::SetDefault("ns3::ProfilingSimulatorImpl::ProfileFile",
+                           StringValue(path + "EventProfile" + extension));
+    }
     std::string version;
     version = "mc";
     Config::SetDefault("ns3::MmWaveUeMac::UpdateUeSinrEstimatePeriod", DoubleValue(0));
@@ -482,6 +680,11 @@ main(int argc, char* argv[])
                        TimeValue(MicroSeconds(1000)));
     Config::SetDefault("ns3::MmWavePointToPointEpcHelper::S1apLinkDelay",
                        TimeValue(MicroSeconds(mmeLatency)));
+    GlobalValue::GetValueByName("x2StatsEpoch", uintegerValue);
+    uint32_t x2StatsEpoch = uintegerValue.Get();
+    Config::SetDefaultFailSafe(
+        "ns3::CoreNetworkStatsCalculator::X2FileName",
+        StringValue(x2StatsEpoch > 0 ? "/dev/null" : path + x2statOutputFilename + extension));
     Config::SetDefault("ns3::LteRlcUm::MaxTxBufferSize", UintegerValue(bufferSize * 1024 * 1024));
     Config::SetDefault("ns3::LteRlcUmLowLat::MaxTxBufferSize",
                        UintegerValue(bufferSize * 1024 * 1024));
@@ -535,11 +738,34 @@ main(int argc, char* argv[])
     Config::SetDefault("ns3::ThreeGppChannelModel::NumNonselfBlocking",
                        IntegerValue(4)); // number of non-self blocking obstacles
 
+    GlobalValue::GetValueByName("channelThreads", uintegerValue);
+    uint32_t channelThreads = uintegerValue.Get();
+    if (channelThreads > 0)
+    {
+        // regenerate all the links due for an update in one batch, on channelThreads threads
+        Config::SetDefault("ns3::ThreeGppSpectrumPropagationLossModel::ChannelModel",
+                           StringValue("ns3::ParallelThreeGppChannelModel"));
+        Config::SetDefault("ns3::ParallelThreeGppChannelModel::NumThreads",
+                           UintegerValue(channelThreads));
+    }
+
     // by default, isotropic antennas are used. To use the 3GPP radiation pattern instead, use the
     // <ThreeGppAntennaArrayModel> beware: proper configuration of the bearing and downtilt angles
     // is needed
-    Config::SetDefault("ns3::PhasedArrayModel::AntennaElement",
-                       PointerValue(CreateObject<IsotropicAntennaModel>()));
+    GlobalValue::GetValueByName("antennaTableResolution", doubleValue);
+    double antennaTableResolution = doubleValue.Get();
+    if (antennaTableResolution > 0)
+    {
+        // 3GPP pattern sampled once on a grid, so the channel updates do not evaluate it
+        Ptr<TabulatedAntennaModel> element = CreateObject<TabulatedAntennaModel>();
+        element->SetResolution(antennaTableResolution);
+        Config::SetDefault("ns3::PhasedArrayModel::AntennaElement", PointerValue(element));
+    }
+    else
+    {
+        Config::SetDefault("ns3::PhasedArrayModel::AntennaElement",
+                           PointerValue(CreateObject<IsotropicAntennaModel>()));
+    }
 
     Ptr<MmWaveHelper> mmwaveHelper = CreateObject<MmWaveHelper>();
     mmwaveHelper->SetPathlossModelType("ns3::ThreeGppUmiStreetCanyonPropagationLossModel");
@@ -565,7 +791,9 @@ main(int argc, char* argv[])
     // Get SGW/PGW and create a single RemoteHost
     Ptr<Node> pgw = epcHelper->GetPgwNode();
     NodeContainer remoteHostContainer;
-    remoteHostContainer.Create(1);
+    // the spectrum channels couple all the cells with no lookahead, and the EPC nodes
+    // are created by the helper on system 0: the remote host is the only partition
+    remoteHostContainer.Create(1, distributed ? 1 : 0);
     Ptr<Node> remoteHost = remoteHostContainer.Get(0);
     InternetStackHelper internet;
     internet.Install(remoteHostContainer);
@@ -586,6 +814,55 @@ main(int argc, char* argv[])
         ipv4RoutingHelper.GetStaticRouting(remoteHost->GetObject<Ipv4>());
     remoteHostStaticRouting->AddNetworkRouteTo(Ipv4Address("7.0.0.0"), Ipv4Mask("255.0.0.0"), 1);
 
+    uint32_t numUes = 3;
+    uint16_t dlPort = 1234;
+    uint16_t ulPort = 2000;
+    bool dl = 1;
+    bool ul = 0;
+
+    if (systemId == 1)
+    {
+        // remote host logical process: the RAN and the EPC are simulated by rank 0,
+        // which sends the addresses its EPC helper assigned to the UEs
+        std::vector<uint32_t> addresses(numUes);
+#ifdef NS3_MPI
+        MPI_Recv(addresses.data(),
+                 numUes,
+                 MPI_UINT32_T,
+                 0,
+                 0,
+                 MpiInterface::GetCommunicator(),
+                 MPI_STATUS_IGNORE);
+#endif
+        std::vector<Ipv4Address> ueAddresses;
+        for (uint32_t address : addresses)
+        {
+            ueAddresses.push_back(Ipv4Address(address));
+        }
+        ApplicationContainer clientApps;
+        ApplicationContainer serverApps;
+        InstallRemoteHostApplications(remoteHost,
+                                      ueAddresses,
+                                      dl,
+                                      ul,
+                                      dlPort,
+                                      ulPort,
+                                      interPacketInterval,
+                                      clientApps,
+                                      serverApps);
+        serverApps.Start(Seconds(transientDuration));
+        clientApps.Start(Seconds(transientDuration));
+        clientApps.Stop(Seconds(simTime - 1));
+        Simulator::Stop(Seconds(simTime));
+        Simulator::Run();
+        PrintRankEvents(path + "PdesEvents" + std::to_string(systemId) + extension);
+        Simulator::Destroy();
+#ifdef NS3_MPI
+        MpiInterface::Disable();
+#endif
+        return 0;
+    }
+
     // create LTE, mmWave eNB nodes and UE node
     NodeContainer ueNodes;
     NodeContainer mmWaveEnbNodes;
@@ -593,7 +870,7 @@ main(int argc, char* argv[])
     NodeContainer allEnbNodes;
     mmWaveEnbNodes.Create(2);
     lteEnbNodes.Create(1);
-    ueNodes.Create(3);
+    ueNodes.Create(numUes);
     allEnbNodes.Add(lteEnbNodes);
     allEnbNodes.Add(mmWaveEnbNodes);
 
@@ -665,6 +942,16 @@ main(int argc, char* argv[])
     NetDeviceContainer mcUeDevs;
     mcUeDevs = mmwaveHelper->InstallMcUeDevice(ueNodes);
 
+    // Cull the links whose received power is far below the noise floor
+    GlobalValue::GetValueByName("cullingMargin", doubleValue);
+    double cullingMargin = doubleValue.Get();
+    std::map<uint32_t, Ptr<InterferenceCullingChannel>> cullingChannels;
+    if (cullingMargin >= 0)
+    {
+        Config::SetDefault("ns3::InterferenceCullingChannel::Margin", DoubleValue(cullingMargin));
+        cullingChannels = InstallInterferenceCulling();
+    }
+
     // Install the IP stack on the UEs
     internet.Install(ueNodes);
     Ipv4InterfaceContainer ueIpIface;
@@ -686,53 +973,104 @@ main(int argc, char* argv[])
     mmwaveHelper->AttachToClosestEnb(mcUeDevs, mmWaveEnbDevs, lteEnbDevs);
 
     // Install and start applications on UEs and remote host
-    uint16_t dlPort = 1234;
-    uint16_t ulPort = 2000;
-    ApplicationContainer clientApps;
-    ApplicationContainer serverApps;
-    bool dl = 1;
-    bool ul = 0;
-
+    std::vector<Ipv4Address> ueAddresses;
     for (uint32_t u = 0; u < ueNodes.GetN(); ++u)
     {
-        if (dl)
+        ueAddresses.push_back(ueIpIface.GetAddress(u));
+    }
+#ifdef NS3_MPI
+    if (distributed)
+    {
+        std::vector<uint32_t> addresses;
+        for (const Ipv4Address& address : ueAddresses)
         {
-            UdpServerHelper dlPacketSinkHelper(dlPort);
-            dlPacketSinkHelper.SetAttribute("PacketWindowSize", UintegerValue(256));
-            serverApps.Add(dlPacketSinkHelper.Install(ueNodes.Get(u)));
-
-            // Simulator::Schedule(MilliSeconds(20), &PrintLostUdpPackets,
-            // DynamicCast<UdpServer>(serverApps.Get(serverApps.GetN()-1)), lostFilename);
+            addresses.push_back(address.Get());
+        }
+        MPI_Send(addresses.data(),
+                 addresses.size(),
+                 MPI_UINT32_T,
+                 1,
+                 0,
+                 MpiInterface::GetCommunicator());
+    }
+#endif
+    // the start and stop times of the applications are relative to their installation
+    auto installApplications = [=](Time startDelay) {
+        ApplicationContainer clientApps;
+        ApplicationContainer serverApps;
+        for (uint32_t u = 0; u < ueNodes.GetN(); ++u)
+        {
+            if (dl)
+            {
+                UdpServerHelper dlPacketSinkHelper(dlPort);
+                dlPacketSinkHelper.SetAttribute("PacketWindowSize", UintegerValue(256));
+                serverApps.Add(dlPacketSinkHelper.Install(ueNodes.Get(u)));
 
-            UdpClientHelper dlClient(ueIpIface.GetAddress(u), dlPort);
-            dlClient.SetAttribute("Interval", TimeValue(MicroSeconds(interPacketInterval)));
-            dlClient.SetAttribute("MaxPackets", UintegerValue(0xFFFFFFFF));
-            clientApps.Add(dlClient.Install(remoteHost));
+                // Simulator::Schedule(MilliSeconds(20), &PrintLostUdpPackets,
+                // DynamicCast<UdpServer>(serverApps.Get(serverApps.GetN()-1)), lostFilename);
+            }
+            if (ul)
+            {
+                UdpClientHelper ulClient(remoteHostAddr, ulPort + 1 + u);
+                ulClient.SetAttribute("Interval", TimeValue(MicroSeconds(interPacketInterval)));
+                ulClient.SetAttribute("MaxPackets", UintegerValue(0xFFFFFFFF));
+                clientApps.Add(ulClient.Install(ueNodes.Get(u)));
+            }
         }
-        if (ul)
+        if (!distributed)
         {
-            ++ulPort;
-            PacketSinkHelper ulPacketSinkHelper("ns3::UdpSocketFactory",
-                                                InetSocketAddress(Ipv4Address::GetAny(), ulPort));
-            ulPacketSinkHelper.SetAttribute("PacketWindowSize", UintegerValue(256));
-            serverApps.Add(ulPacketSinkHelper.Install(remoteHost));
-            UdpClientHelper ulClient(remoteHostAddr, ulPort);
-            ulClient.SetAttribute("Interval", TimeValue(MicroSeconds(interPacketInterval)));
-            ulClient.SetAttribute("MaxPackets", UintegerValue(0xFFFFFFFF));
-            clientApps.Add(ulClient.Install(ueNodes.Get(u)));
+            InstallRemoteHostApplications(remoteHost,
+                                          ueAddresses,
+                                          dl,
+                                          ul,
+                                          dlPort,
+                                          ulPort,
+                                          interPacketInterval,
+                                          clientApps,
+                                          serverApps);
         }
-    }
 
-    // Start applications
-    NS_LOG_UNCOND("transientDuration " << transientDuration << " simTime " << simTime);
-    serverApps.Start(Seconds(transientDuration));
-    clientApps.Start(Seconds(transientDuration));
-    clientApps.Stop(Seconds(simTime - 1));
+        serverApps.Start(startDelay);
+        clientApps.Start(startDelay);
+        // the clients stop at simTime - 1 in absolute time; a stop time of zero (or one in the
+        // past, when the applications are installed late) means that they are never stopped
+        if (Seconds(simTime - 1) > Simulator::Now())
+        {
+            clientApps.Stop(Seconds(simTime - 1) - Simulator::Now());
+        }
 
-    Simulator::Schedule(Seconds(transientDuration),
-                        &ChangeSpeed,
-                        ueNodes.Get(0),
-                        Vector(ueSpeed, 0, 0)); // start UE movement after Seconds(0.5)
+        Simulator::Schedule(startDelay,
+                            &ChangeSpeed,
+                            ueNodes.Get(0),
+                            Vector(ueSpeed, 0, 0)); // start UE movement after the transient
+    };
+
+    GlobalValue::GetValueByName("autoWarmUp", booleanValue);
+    bool autoWarmUp = booleanValue.Get();
+    Ptr<WarmUpDetector> warmUpDetector;
+    Ptr<X2StatsCollector> x2Stats;
+    if (autoWarmUp)
+    {
+        NS_ABORT_MSG_IF(distributed, "The warm-up detection needs distributed=false");
+        // never later than the transient of the filter; the traces and the statistics start
+        // with the applications, so that they do not include the warm-up
+        warmUpDetector = CreateObject<WarmUpDetector>();
+        warmUpDetector->SetAttribute("MaxTime", TimeValue(Seconds(transientDuration)));
+        warmUpDetector->Start([=, &x2Stats]() {
+            installApplications(Seconds(0));
+            mmwaveHelper->EnableTraces();
+            if (x2Stats)
+            {
+                x2Stats->Start();
+            }
+        });
+    }
+    else
+    {
+        // Start applications
+        NS_LOG_UNCOND("transientDuration " << transientDuration << " simTime " << simTime);
+        installApplications(Seconds(transientDuration));
+    }
     Simulator::Schedule(Seconds(simTime - 1),
                         &ChangeSpeed,
                         ueNodes.Get(0),
@@ -744,10 +1082,12 @@ main(int argc, char* argv[])
         Simulator::Schedule(Seconds(i * simTime / numPrints), &PrintPosition, ueNodes.Get(0));
     }
 
-    mmwaveHelper->EnableTraces();
+    if (!autoWarmUp)
+    {
+        mmwaveHelper->EnableTraces();
+    }
 
-    // set to true if you want to print the map of buildings, ues and enbs
-    bool print = true;
+    // print the map of buildings, ues and enbs instead of running the simulation
     if (print)
     {
         PrintGnuplottableBuildingListToFile("buildings.txt");
@@ -757,9 +1097,81 @@ main(int argc, char* argv[])
     else
     {
         Simulator::Stop(Seconds(simTime));
+        GlobalValue::GetValueByName("progressInterval", doubleValue);
+        Ptr<SimulationProgressReporter> progress;
+        if (doubleValue.Get() > 0)
+        {
+            progress = CreateObject<SimulationProgressReporter>();
+            progress->SetAttribute("Interval", DoubleValue(doubleValue.Get()));
+            progress->SetAttribute("FileName", StringValue(path + "ProgressStats" + extension));
+            progress->Start(Seconds(simTime));
+        }
+        // one budget for the RLC tx buffers of each eNB, instead of bufferSize per bearer
+        GlobalValue::GetValueByName("rlcPoolSize", uintegerValue);
+        Ptr<RlcBufferPool> rlcPool;
+        if (uintegerValue.Get() > 0)
+        {
+            rlcPool = CreateObject<RlcBufferPool>();
+            rlcPool->SetAttribute("PoolSize", UintegerValue(uintegerValue.Get() * 1024 * 1024));
+            rlcPool->SetAttribute("BearerQuota", UintegerValue(bufferSize * 1024 * 1024));
+            GlobalValue::GetValueByName("rlcPoolPolicy", stringValue);
+            NS_ABORT_MSG_UNLESS(stringValue.Get() == "Partition" || stringValue.Get() == "Shared",
+                                "Unknown RLC pool policy " << stringValue.Get());
+            rlcPool->SetAttribute("Policy", EnumValue(stringValue.Get() == "Partition"
+                                                          ? RlcBufferPool::PARTITION
+                                                          : RlcBufferPool::SHARED));
+            rlcPool->Start();
+        }
+        if (x2StatsEpoch > 0)
+        {
+            x2Stats = CreateObject<X2StatsCollector>();
+            x2Stats->SetAttribute("Epoch", TimeValue(MilliSeconds(x2StatsEpoch)));
+            x2Stats->SetAttribute("FileName", StringValue(path + "X2EpochStats" + extension));
+            if (!autoWarmUp)
+            {
+                x2Stats->Start();
+            }
+        }
         Simulator::Run();
+        GlobalValue::GetValueByName("benchmark", booleanValue);
+        if (booleanValue.Get())
+        {
+            std::cout << "Events executed: " << Simulator::GetEventCount() << std::endl;
+        }
+        if (distributed)
+        {
+            PrintRankEvents(path + "PdesEvents" + std::to_string(systemId) + extension);
+        }
+        if (!cullingChannels.empty())
+        {
+            PrintInterferenceCullingStats(path + "InterferenceCullingStats" + extension,
+                                          cullingChannels);
+        }
+        if (packetPool)
+        {
+            PoolAllocator::PrintStats(path + "PoolAllocatorStats" + extension);
+        }
+        if (rlcPool)
+        {
+            rlcPool->Print(path + "RlcPoolStats" + extension);
+        }
+        if (x2Stats)
+        {
+            x2Stats->Stop();
+        }
+        GlobalValue::GetValueByName("channelPrecisionReport", booleanValue);
+        if (booleanValue.Get())
+        {
+            PrintChannelPrecisionReport(path + "ChannelPrecisionReport" + extension);
+        }
     }
 
     Simulator::Destroy();
+#ifdef NS3_MPI
+    if (distributed)
+    {
+        MpiInterface::Disable();
+    }
+#endif
     return 0;
 }
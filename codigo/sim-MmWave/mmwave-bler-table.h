@@ -0,0 +1,345 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MMWAVE_BLER_TABLE_H
+#define MMWAVE_BLER_TABLE_H
+
+#include "ns3/core-module.h"
+#include "ns3/mmwave-mi-error-model.h"
+#include "ns3/mmwave-phy-mac-common.h"
+#include "ns3/spectrum-model.h"
+#include "ns3/spectrum-value.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * Link abstraction tables for the mmWave MI error model.
+ *
+ * For every MCS and TB size bucket the table stores the TB error rate obtained
+ * by MmWaveMiErrorModel for a flat SINR over a grid of SINR values.
+ * Rows are computed the first time they are needed and can be saved to and
+ * loaded from a text file, so that a sweep builds them once.
+ *
+ * The TB error rate is a bilinear interpolation in (SINR, log2 TB size). The
+ * SINR is the one reported by the PHY traces, i.e., the mean over the RBs of
+ * the TB: a frequency selective channel is not compressed to an effective SINR.
+ */
+class MmWaveBlerTable : public Object
+{
+  public:
+    static TypeId GetTypeId()
+    {
+        static TypeId tid =
+            TypeId("ns3::MmWaveBlerTable")
+                .SetParent<Object>()
+                .AddConstructor<MmWaveBlerTable>()
+                .AddAttribute("MinSinr",
+                              "Lowest SINR (dB) of the table",
+                              DoubleValue(-10.0),
+                              MakeDoubleAccessor(&MmWaveBlerTable::m_minSinrDb),
+                              MakeDoubleChecker<double>())
+                .AddAttribute("MaxSinr",
+                              "Highest SINR (dB) of the table",
+                              DoubleValue(40.0),
+                              MakeDoubleAccessor(&MmWaveBlerTable::m_maxSinrDb),
+                              MakeDoubleChecker<double>())
+                .AddAttribute("SinrStep",
+                              "SINR resolution (dB) of the table",
+                              DoubleValue(0.25),
+                              MakeDoubleAccessor(&MmWaveBlerTable::m_stepDb),
+                              MakeDoubleChecker<double>(0.01));
+        return tid;
+    }
+
+    MmWaveBlerTable() = default;
+
+    /// Largest MCS index of the mmWave AMC tables
+    static constexpr uint8_t MAX_MCS = 28;
+    /// TB sizes are bucketed by powers of two, from 2^3 to 2^MAX_LOG2_SIZE bytes
+    static constexpr uint32_t MIN_LOG2_SIZE = 3;
+    static constexpr uint32_t MAX_LOG2_SIZE = 20;
+
+    /**
+     * \param mcs the MCS index
+     * \param tbSize the TB size in bytes
+     * \param sinrDb the mean SINR of the TB in dB
+     * \return the TB error rate
+     */
+    double GetBler(uint8_t mcs, uint32_t tbSize, double sinrDb)
+    {
+        double log2Size = std::log2(std::max<uint32_t>(tbSize, 1));
+        log2Size = std::min<double>(std::max<double>(log2Size, MIN_LOG2_SIZE), MAX_LOG2_SIZE);
+        uint32_t lower = std::floor(log2Size);
+        uint32_t upper = std::min<uint32_t>(lower + 1, MAX_LOG2_SIZE);
+        double w = log2Size - lower;
+        double blerLower = Interpolate(GetRow(mcs, lower), sinrDb);
+        if (w == 0.0 || upper == lower)
+        {
+            return blerLower;
+        }
+        return (1 - w) * blerLower + w * Interpolate(GetRow(mcs, upper), sinrDb);
+    }
+
+    /**
+     * Save the rows computed so far
+     * \param filename the output file
+     */
+    void Save(std::string filename) const
+    {
+        std::ofstream out(filename.c_str(), std::ios_base::out | std::ios_base::trunc);
+        out << "mcs\tlog2TbSize\tminSinr\tstep\tbler..." << std::endl;
+        for (const auto& row : m_rows)
+        {
+            out << (row.first >> 8) << "\t" << (row.first & 0xff) << "\t" << m_minSinrDb << "\t"
+                << m_stepDb;
+            for (double bler : row.second)
+            {
+                out << "\t" << bler;
+            }
+            out << std::endl;
+        }
+    }
+
+    /**
+     * Load rows saved by Save (). Rows computed with a different SINR grid are ignored.
+     * \param filename the input file
+     * \return the number of rows loaded
+     */
+    uint32_t Load(std::string filename)
+    {
+        std::ifstream in(filename.c_str());
+        std::string header;
+        if (!in.is_open() || !std::getline(in, header))
+        {
+            return 0;
+        }
+        uint32_t nLoaded = 0;
+        std::string line;
+        while (std::getline(in, line))
+        {
+            std::istringstream iss(line);
+            uint32_t mcs;
+            uint32_t log2Size;
+            double minSinr;
+            double step;
+            if (!(iss >> mcs >> log2Size >> minSinr >> step) || minSinr != m_minSinrDb ||
+                step != m_stepDb)
+            {
+                continue;
+            }
+            std::vector<double> row;
+            double bler;
+            while (iss >> bler)
+            {
+                row.push_back(bler);
+            }
+            if (row.size() == GetNPoints())
+            {
+                m_rows[(mcs << 8) | log2Size] = row;
+                ++nLoaded;
+            }
+        }
+        return nLoaded;
+    }
+
+  private:
+    std::size_t GetNPoints() const
+    {
+        return std::floor((m_maxSinrDb - m_minSinrDb) / m_stepDb) + 1;
+    }
+
+    double Interpolate(const std::vector<double>& row, double sinrDb) const
+    {
+        double x = (sinrDb - m_minSinrDb) / m_stepDb;
+        if (x <= 0)
+        {
+            return row.front();
+        }
+        if (x >= row.size() - 1)
+        {
+            return row.back();
+        }
+        std::size_t i = std::floor(x);
+        double w = x - i;
+        return (1 - w) * row[i] + w * row[i + 1];
+    }
+
+    /// \return a flat SINR vector of one RB, with the given value in dB
+    SpectrumValue MakeFlatSinr(double sinrDb)
+    {
+        if (!m_oneRbModel)
+        {
+            m_oneRbModel = Create<SpectrumModel>(std::vector<double>{1.0});
+        }
+        SpectrumValue sinr(m_oneRbModel);
+        sinr[0] = std::pow(10, sinrDb / 10);
+        return sinr;
+    }
+
+    const std::vector<double>& GetRow(uint8_t mcs, uint32_t log2Size)
+    {
+        uint32_t key = (uint32_t(mcs) << 8) | log2Size;
+        auto it = m_rows.find(key);
+        if (it != m_rows.end())
+        {
+            return it->second;
+        }
+        std::vector<double> row(GetNPoints());
+        std::vector<int> rbMap{0};
+        uint32_t tbSize = 1u << log2Size;
+        for (std::size_t i = 0; i < row.size(); ++i)
+        {
+            SpectrumValue sinr = MakeFlatSinr(m_minSinrDb + i * m_stepDb);
+            row[i] = mmwave::MmWaveMiErrorModel::GetTbDecodificationStats(
+                         sinr,
+                         rbMap,
+                         tbSize,
+                         mcs,
+                         mmwave::MmWaveHarqProcessInfoList_t())
+                         .tbler;
+        }
+        return m_rows[key] = row;
+    }
+
+    double m_minSinrDb{-10.0};
+    double m_maxSinrDb{40.0};
+    double m_stepDb{0.25};
+    Ptr<SpectrumModel> m_oneRbModel;
+    std::map<uint32_t, std::vector<double>> m_rows; //!< (mcs << 8 | log2 size) -> BLER
+};
+
+NS_OBJECT_ENSURE_REGISTERED(MmWaveBlerTable);
+
+/**
+ * Compares the table lookups with the MI error model on the TBs actually decoded
+ * in a simulation.
+ *
+ * For every first transmission reported by the RxPacketTrace sources, the
+ * reported average SINR is looked up in the table and compared with the TBler
+ * computed by the PHY. The report gives, per MCS, the mean and maximum absolute
+ * error and the cost per TB of the lookup versus the error model evaluation.
+ */
+class MmWaveBlerTableValidator : public SimpleRefCount<MmWaveBlerTableValidator>
+{
+  public:
+    MmWaveBlerTableValidator(Ptr<MmWaveBlerTable> table)
+        : m_table(table)
+    {
+    }
+
+    /// Connect to the RxPacketTrace sources of the UE and eNB PHYs
+    void Connect()
+    {
+        Config::ConnectWithoutContextFailSafe(
+            "/NodeList/*/DeviceList/*/ComponentCarrierMapUe/*/MmWaveUePhy/DlSpectrumPhy/"
+            "RxPacketTraceUe",
+            MakeCallback(&MmWaveBlerTableValidator::RxPacketTrace, Ptr<MmWaveBlerTableValidator>(this)));
+        Config::ConnectWithoutContextFailSafe(
+            "/NodeList/*/DeviceList/*/ComponentCarrierMap/*/MmWaveEnbPhy/DlSpectrumPhy/"
+            "RxPacketTraceEnb",
+            MakeCallback(&MmWaveBlerTableValidator::RxPacketTrace, Ptr<MmWaveBlerTableValidator>(this)));
+    }
+
+    /**
+     * Write the per-MCS comparison
+     * \param filename the output file
+     */
+    void Print(std::string filename)
+    {
+        std::ofstream out(filename.c_str(), std::ios_base::out | std::ios_base::trunc);
+        out << "mcs\tnTb\tmeanAbsErr\tmaxAbsErr\tlookupNs\tmodelNs" << std::endl;
+        for (const auto& entry : m_stats)
+        {
+            const Stats& s = entry.second;
+            double lookupNs = 0;
+            double modelNs = 0;
+            MeasureCost(entry.first, s.lastTbSize, lookupNs, modelNs);
+            out << uint32_t(entry.first) << "\t" << s.n << "\t" << s.sumAbsErr / s.n << "\t"
+                << s.maxAbsErr << "\t" << lookupNs << "\t" << modelNs << std::endl;
+        }
+    }
+
+  private:
+    struct Stats
+    {
+        uint64_t n{0};
+        double sumAbsErr{0};
+        double maxAbsErr{0};
+        uint32_t lastTbSize{0};
+    };
+
+    void RxPacketTrace(mmwave::RxPacketTraceParams params)
+    {
+        if (params.m_rv != 0 || params.m_sinr <= 0)
+        {
+            return; // HARQ retransmissions accumulate mutual information: not tabulated
+        }
+        double err = std::abs(
+            m_table->GetBler(params.m_mcs, params.m_tbSize, 10 * std::log10(params.m_sinr)) -
+            params.m_tbler);
+        Stats& s = m_stats[params.m_mcs];
+        ++s.n;
+        s.sumAbsErr += err;
+        s.maxAbsErr = std::max(s.maxAbsErr, err);
+        s.lastTbSize = params.m_tbSize;
+    }
+
+    void MeasureCost(uint8_t mcs, uint32_t tbSize, double& lookupNs, double& modelNs)
+    {
+        const uint32_t nRuns = 10000;
+        Ptr<SpectrumModel> model = Create<SpectrumModel>(std::vector<double>{1.0});
+        SpectrumValue sinr(model);
+        std::vector<int> rbMap{0};
+        volatile double sink = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < nRuns; ++i)
+        {
+            sink = sink + m_table->GetBler(mcs, tbSize, (i % 200) * 0.2 - 10);
+        }
+        auto middle = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < nRuns; ++i)
+        {
+            sinr[0] = std::pow(10, ((i % 200) * 0.2 - 10) / 10);
+            sink = sink + mmwave::MmWaveMiErrorModel::GetTbDecodificationStats(
+                              sinr,
+                              rbMap,
+                              tbSize,
+                              mcs,
+                              mmwave::MmWaveHarqProcessInfoList_t())
+                              .tbler;
+        }
+        auto end = std::chrono::steady_clock::now();
+        lookupNs = std::chrono::duration<double, std::nano>(middle - start).count() / nRuns;
+        modelNs = std::chrono::duration<double, std::nano>(end - middle).count() / nRuns;
+    }
+
+    Ptr<MmWaveBlerTable> m_table;
+    std::map<uint8_t, Stats> m_stats;
+};
+
+} // namespace ns3
+
+#endif /* MMWAVE_BLER_TABLE_H */
@@ -36,6 +36,9 @@
 #include "ns3/mmwave-point-to-point-epc-helper.h"
 #include "ns3/point-to-point-helper.h"
 #include "ns3/global-route-manager.h"
+#include "idle-slot-analyzer.h"
+#include "ladder-queue-scheduler.h"
+#include "steady-state-monitor.h"
 #include "ns3/buildings-module.h"
 
 
@@ -107,6 +110,9 @@ main (int argc, char *argv[])
   double frequency = 100.0e9;
   double simTime = 60;
   std::string condition = "l";
+  bool idleSlots = false;
+  double autoStop = 0; // target relative half width of the confidence intervals, 0 = disabled
+  bool benchmark = false;
 
   CommandLine cmd;
   cmd.AddValue ("blockage", "If enabled blockage = true", blockage);
@@ -115,6 +121,9 @@ main (int argc, char *argv[])
   cmd.AddValue ("simTime", "Simulation time", simTime);
   cmd.AddValue ("useEpc", "If enabled use EPC, else use RLC saturation mode", useEpc);
   cmd.AddValue ("condition", "Channel condition, l = LOS, n = NLOS, otherwise the condition is randomly determined", condition);
+  cmd.AddValue ("idleSlots", "If enabled, write the busy and idle slots of each cell and the events an idle-slot fast-forward would save to IdleSlotStats.txt", idleSlots);
+  cmd.AddValue ("autoStop", "If > 0, stop the simulation once the confidence intervals of the throughput and delay of every flow with traffic have this relative half width", autoStop);
+  cmd.AddValue ("benchmark", "If enabled, print the number of events executed, for the scheduler benchmark", benchmark);
   cmd.Parse (argc, argv);
   Time::SetResolution (Time::NS);
   //BUILDINGS
@@ -186,6 +195,14 @@ main (int argc, char *argv[])
     helper->SetChannelConditionModelType ("ns3::NeverLosChannelConditionModel");
   }
   
+  // stop the simulation once the statistics have converged
+  Ptr<SteadyStateMonitor> steadyState;
+  if (autoStop > 0)
+    {
+      steadyState = CreateObject<SteadyStateMonitor> ();
+      steadyState->SetAttribute ("RelativePrecision", DoubleValue (autoStop));
+    }
+
   // create the EPC
   Ipv4Address remoteHostAddr;
   Ptr<Node> remoteHost;
@@ -368,6 +385,11 @@ std::cout << "UE3 position: " << ueNodes.Get (2)->GetObject<MobilityModel> ()->G
       serverApps.Start (Seconds (0.01));
       clientApps.Start (Seconds (0.01));
 
+      if (steadyState)
+        {
+          steadyState->AddFlows (serverApps);
+          steadyState->Start ();
+        }
     }
     
   else
@@ -382,6 +404,12 @@ std::cout << "UE3 position: " << ueNodes.Get (2)->GetObject<MobilityModel> ()->G
   
   helper->EnableTraces ();
   Traces ("./"); // enable UL MAC traces
+  Ptr<IdleSlotAnalyzer> idleSlotAnalyzer;
+  if (idleSlots)
+    {
+      idleSlotAnalyzer = CreateObject<IdleSlotAnalyzer> ();
+      idleSlotAnalyzer->Connect (phyMacConfig0);
+    }
   
   Ptr<OutputStreamWrapper> stream = ascii.CreateFileStream ("distance-trace.txt");
   *stream->GetStream () << "Time" << "\t" << "UE Id" << "\t" << "DistanceX" << "\t" << "DistanceY" << std::endl;
@@ -393,6 +421,18 @@ std::cout << "UE3 position: " << ueNodes.Get (2)->GetObject<MobilityModel> ()->G
 
   Simulator::Stop (Seconds (simTime));
   Simulator::Run ();
+  if (benchmark)
+    {
+      std::cout << "Events executed: " << Simulator::GetEventCount () << std::endl;
+    }
+  if (steadyState)
+    {
+      steadyState->Print ();
+    }
+  if (idleSlotAnalyzer)
+    {
+      idleSlotAnalyzer->Print ("IdleSlotStats.txt");
+    }
   Simulator::Destroy ();
   
   //flowMonitor->SerializeToXmlFile("flow5g.xml", true, true);     
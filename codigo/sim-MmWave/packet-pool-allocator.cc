@@ -0,0 +1,100 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Program-wide operator new and delete served by PoolAllocator. Compiled only
+ * with NS3_PACKET_POOL defined, see packet-pool-allocator.h.
+ */
+
+#include "packet-pool-allocator.h"
+
+#ifdef NS3_PACKET_POOL
+
+void*
+operator new(std::size_t size)
+{
+    return ns3::PoolAllocator::Allocate(size);
+}
+
+void*
+operator new[](std::size_t size)
+{
+    return ns3::PoolAllocator::Allocate(size);
+}
+
+void*
+operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    try
+    {
+        return ns3::PoolAllocator::Allocate(size);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void*
+operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    try
+    {
+        return ns3::PoolAllocator::Allocate(size);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void
+operator delete(void* p) noexcept
+{
+    ns3::PoolAllocator::Deallocate(p);
+}
+
+void
+operator delete[](void* p) noexcept
+{
+    ns3::PoolAllocator::Deallocate(p);
+}
+
+void
+operator delete(void* p, std::size_t) noexcept
+{
+    ns3::PoolAllocator::Deallocate(p);
+}
+
+void
+operator delete[](void* p, std::size_t) noexcept
+{
+    ns3::PoolAllocator::Deallocate(p);
+}
+
+void
+operator delete(void* p, const std::nothrow_t&) noexcept
+{
+    ns3::PoolAllocator::Deallocate(p);
+}
+
+void
+operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+    ns3::PoolAllocator::Deallocate(p);
+}
+
+#endif /* NS3_PACKET_POOL */
@@ -0,0 +1,239 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PACKET_POOL_ALLOCATOR_H
+#define PACKET_POOL_ALLOCATOR_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <string>
+
+/*
+ * Size-class pool allocator for the small, short-lived objects created along
+ * the packet path: Packet, Buffer data, headers, tags, events and their
+ * callbacks. The program-wide operator new and delete are replaced, so the
+ * allocations made inside the ns-3 libraries are served as well.
+ *
+ * Blocks up to MAX_POOLED_SIZE bytes are carved from 64 kB slabs, per size
+ * class and per thread, and recycled through a thread local free list when
+ * deleted; a block freed by another thread joins the free list of that thread.
+ * Every block carries a 16 byte header with its size class, so that pooling can
+ * be switched on and off at any time with PoolAllocator::Enable () and blocks
+ * allocated while it was off still go back to malloc.
+ *
+ * The replacement operators are defined in packet-pool-allocator.cc, which is
+ * only compiled with NS3_PACKET_POOL defined. To build a scenario with the pool,
+ * put it in a directory of scratch/ with packet-pool-allocator.cc (the .cc files
+ * of scratch/<name>/ are linked into one program) and configure ns-3 with
+ * CXXFLAGS=-DNS3_PACKET_POOL. Any other build keeps the default allocator, and
+ * IsBuiltIn () is false.
+ */
+
+namespace ns3
+{
+
+class PoolAllocator
+{
+  public:
+    static constexpr std::size_t HEADER_SIZE = 16;
+    static constexpr std::size_t MAX_POOLED_SIZE = 4096;
+    static constexpr std::size_t SLAB_SIZE = 64 * 1024;
+    static constexpr uint32_t N_CLASSES = 16;
+    static constexpr uint32_t MALLOC_CLASS = 0xff;
+
+    /// Counters of the calling thread, per size class
+    struct Stats
+    {
+        uint64_t allocations[N_CLASSES]{};
+        uint64_t recycled[N_CLASSES]{}; //!< allocations served from the free list
+        uint64_t slabs[N_CLASSES]{};
+        uint64_t mallocAllocations{0};
+    };
+
+    /**
+     * \return true if the program is built with the replacement operators
+     */
+    static constexpr bool IsBuiltIn()
+    {
+#ifdef NS3_PACKET_POOL
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    static void Enable(bool enable)
+    {
+        g_enabled.store(enable, std::memory_order_relaxed);
+    }
+
+    static bool IsEnabled()
+    {
+        return g_enabled.load(std::memory_order_relaxed);
+    }
+
+    static std::size_t GetClassSize(uint32_t cls)
+    {
+        static const std::size_t sizes[N_CLASSES] =
+            {16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048, 3072, 4096};
+        return sizes[cls];
+    }
+
+    static void* Allocate(std::size_t size)
+    {
+        ThreadState& state = GetState();
+        if (!IsEnabled() || size > MAX_POOLED_SIZE)
+        {
+            ++state.stats.mallocAllocations;
+            return Wrap(std::malloc(size + HEADER_SIZE), MALLOC_CLASS);
+        }
+        uint32_t cls = GetClass(size);
+        ++state.stats.allocations[cls];
+        FreeBlock* block = state.freeList[cls];
+        if (block)
+        {
+            ++state.stats.recycled[cls];
+            state.freeList[cls] = block->next;
+            return Wrap(block, cls);
+        }
+        return Wrap(Refill(state, cls), cls);
+    }
+
+    static void Deallocate(void* p)
+    {
+        if (!p)
+        {
+            return;
+        }
+        Header* header = reinterpret_cast<Header*>(static_cast<char*>(p) - HEADER_SIZE);
+        if (header->cls == MALLOC_CLASS)
+        {
+            std::free(header);
+            return;
+        }
+        uint32_t cls = header->cls; // the link of the free list overwrites the header
+        ThreadState& state = GetState();
+        FreeBlock* block = reinterpret_cast<FreeBlock*>(header);
+        block->next = state.freeList[cls];
+        state.freeList[cls] = block;
+    }
+
+    /**
+     * \return the counters of the calling thread
+     */
+    static const Stats& GetStats()
+    {
+        return GetState().stats;
+    }
+
+    /**
+     * Write the counters of the calling thread, per size class
+     * \param filename the output file
+     */
+    static void PrintStats(std::string filename)
+    {
+        const Stats& stats = GetStats();
+        std::ofstream out(filename.c_str(), std::ios_base::out | std::ios_base::trunc);
+        out << "classSize\tallocations\trecycled\tslabs\tslabBytes" << std::endl;
+        for (uint32_t cls = 0; cls < N_CLASSES; ++cls)
+        {
+            if (stats.allocations[cls] == 0)
+            {
+                continue;
+            }
+            out << GetClassSize(cls) << "\t" << stats.allocations[cls] << "\t"
+                << stats.recycled[cls] << "\t" << stats.slabs[cls] << "\t"
+                << stats.slabs[cls] * SLAB_SIZE << std::endl;
+        }
+        out << "malloc\t" << stats.mallocAllocations << "\t0\t0\t0" << std::endl;
+    }
+
+  private:
+    struct Header
+    {
+        uint32_t cls;
+        uint32_t reserved[3]; //!< keeps the payload 16 byte aligned
+    };
+
+    static_assert(sizeof(Header) == HEADER_SIZE, "unexpected header size");
+
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    struct ThreadState
+    {
+        FreeBlock* freeList[N_CLASSES]{};
+        Stats stats;
+    };
+
+    static ThreadState& GetState()
+    {
+        // trivially destructible, so it is usable during static destruction too
+        static thread_local ThreadState state;
+        return state;
+    }
+
+    static uint32_t GetClass(std::size_t size)
+    {
+        uint32_t cls = 0;
+        while (GetClassSize(cls) < size)
+        {
+            ++cls;
+        }
+        return cls;
+    }
+
+    static void* Wrap(void* block, uint32_t cls)
+    {
+        if (!block)
+        {
+            throw std::bad_alloc();
+        }
+        static_cast<Header*>(block)->cls = cls;
+        return static_cast<char*>(block) + HEADER_SIZE;
+    }
+
+    /// Carve a new slab of the class, return one block and queue the others
+    static void* Refill(ThreadState& state, uint32_t cls)
+    {
+        std::size_t blockSize = GetClassSize(cls) + HEADER_SIZE;
+        char* slab = static_cast<char*>(std::malloc(SLAB_SIZE));
+        if (!slab)
+        {
+            throw std::bad_alloc();
+        }
+        ++state.stats.slabs[cls];
+        std::size_t nBlocks = SLAB_SIZE / blockSize;
+        for (std::size_t i = 1; i < nBlocks; ++i)
+        {
+            FreeBlock* block = reinterpret_cast<FreeBlock*>(slab + i * blockSize);
+            block->next = state.freeList[cls];
+            state.freeList[cls] = block;
+        }
+        return slab;
+    }
+
+    static inline std::atomic<bool> g_enabled{false};
+};
+
+} // namespace ns3
+
+#endif /* PACKET_POOL_ALLOCATOR_H */
@@ -0,0 +1,779 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PARALLEL_THREE_GPP_CHANNEL_MODEL_H
+#define PARALLEL_THREE_GPP_CHANNEL_MODEL_H
+
+#include "parallel-worker-pool.h"
+
+#include "ns3/channel-condition-model.h"
+#include "ns3/core-module.h"
+#include "ns3/matrix-based-channel-model.h"
+#include "ns3/mobility-model.h"
+#include "ns3/node.h"
+#include "ns3/phased-array-model.h"
+#include "ns3/three-gpp-channel-model.h"
+
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * Channel condition of one link, set on the simulator thread from the channel
+ * condition model shared with the pathloss model, so the per-link channel
+ * models read it without touching the shared model from the worker threads.
+ */
+class LinkChannelConditionModel : public ChannelConditionModel
+{
+  public:
+    static TypeId GetTypeId()
+    {
+        static TypeId tid = TypeId("ns3::LinkChannelConditionModel")
+                                .SetParent<ChannelConditionModel>()
+                                .SetGroupName("Propagation")
+                                .AddConstructor<LinkChannelConditionModel>();
+        return tid;
+    }
+
+    /// Set the condition returned until the next call
+    void SetCondition(Ptr<const ChannelCondition> condition)
+    {
+        m_condition = CreateObject<ChannelCondition>(condition->GetLosCondition(),
+                                                     condition->GetO2iCondition(),
+                                                     condition->GetO2iLowHighCondition());
+    }
+
+    Ptr<ChannelCondition> GetChannelCondition(Ptr<const MobilityModel> a,
+                                              Ptr<const MobilityModel> b) const override
+    {
+        return m_condition;
+    }
+
+    int64_t AssignStreams(int64_t stream) override
+    {
+        return 0;
+    }
+
+  private:
+    Ptr<ChannelCondition> m_condition;
+};
+
+NS_OBJECT_ENSURE_REGISTERED(LinkChannelConditionModel);
+
+/**
+ * 3GPP TR 38.901 channel model that regenerates all the links due for an update
+ * in one batch, on a pool of worker threads.
+ *
+ * The stock ThreeGppChannelModel regenerates the channel of a link lazily, on the
+ * simulator thread, the first time the link is used after UpdatePeriod expired,
+ * and draws the random numbers of every link from the same streams. This model
+ * keeps one ThreeGppChannelModel per pair of nodes, each bound to its own RNG
+ * substream (StreamBase + 16 * link index, the link index being the order in
+ * which the pairs are first seen, up to MaxLinks). Every UpdatePeriod a single
+ * event regenerates the channels of all the known pairs and commits them before
+ * any other event scheduled at the same time runs; between two updates the
+ * parameters of a link are fixed, so the channel of an antenna pair first seen
+ * in between is generated from the same parameters as the other pairs of its
+ * link.
+ *
+ * The LOS condition of every link comes from ChannelConditionModel, the model
+ * MmWaveHelper shares with the pathloss model. It is queried on the simulator
+ * thread at every batch, and when a link is created, and handed to the per-link
+ * model, so the pathloss and the fast fading agree on the condition.
+ *
+ * The realizations only depend on the per-link substreams, so they are identical
+ * for any value of NumThreads, including the serial path (NumThreads = 1). They
+ * are not identical to the ones of the stock model, which shares its streams
+ * among all the links.
+ *
+ * The node objects touched while a channel is generated (mobility models,
+ * building info, phased arrays) are not thread safe, so each batch is split in
+ * rounds in which no node appears in more than one pair.
+ *
+ * Install it with
+ * Config::SetDefault ("ns3::ThreeGppSpectrumPropagationLossModel::ChannelModel",
+ *                     StringValue ("ns3::ParallelThreeGppChannelModel"));
+ * The update period is taken from ns3::ThreeGppChannelModel::UpdatePeriod.
+ *
+ * When ns3::ThreeGppChannelModel::Blockage is enabled and LinkBlockage is
+ * true, the blockage of TR 38.901 Sec. 7.6.4.1 (model A) is applied by this
+ * model instead of the per-link models, using the same PortraitMode,
+ * NumNonselfBlocking and BlockerSpeed settings. The cluster angles change at
+ * every update, so the attenuation of every (link, cluster) is computed once
+ * per update, when the link is regenerated, and applied to all the antenna
+ * pairs of the link by scaling the cluster coefficients; the blockers of a
+ * link are redrawn at an update when the link moved, or the blockers may have
+ * moved, by more than the correlation distance. With VectorizeBlockage the
+ * attenuations of all the links of a batch are computed in a single pass over
+ * flat (cluster, blocker) arrays, after the channels have been regenerated.
+ */
+class ParallelThreeGppChannelModel : public MatrixBasedChannelModel
+{
+  public:
+    static TypeId GetTypeId()
+    {
+        static TypeId tid =
+            TypeId("ns3::ParallelThreeGppChannelModel")
+                .SetParent<MatrixBasedChannelModel>()
+                .SetGroupName("Spectrum")
+                .AddConstructor<ParallelThreeGppChannelModel>()
+                .AddAttribute("Frequency",
+                              "The operating Frequency in Hz",
+                              DoubleValue(500.0e6),
+                              MakeDoubleAccessor(&ParallelThreeGppChannelModel::SetFrequency,
+                                                 &ParallelThreeGppChannelModel::GetFrequency),
+                              MakeDoubleChecker<double>())
+                .AddAttribute("Scenario",
+                              "The 3GPP scenario (RMa, UMa, UMi-StreetCanyon, InH-OfficeOpen, "
+                              "InH-OfficeMixed, V2V-Urban, V2V-Highway)",
+                              StringValue("UMa"),
+                              MakeStringAccessor(&ParallelThreeGppChannelModel::SetScenario,
+                                                 &ParallelThreeGppChannelModel::GetScenario),
+                              MakeStringChecker())
+                .AddAttribute("ChannelConditionModel",
+                              "Channel condition model shared with the pathloss model, "
+                              "queried on the simulator thread",
+                              PointerValue(),
+                              MakePointerAccessor(
+                                  &ParallelThreeGppChannelModel::SetChannelConditionModel,
+                                  &ParallelThreeGppChannelModel::GetChannelConditionModel),
+                              MakePointerChecker<ChannelConditionModel>())
+                .AddAttribute("NumThreads",
+                              "Number of threads regenerating the channels of a batch",
+                              UintegerValue(1),
+                              MakeUintegerAccessor(&ParallelThreeGppChannelModel::m_nThreads),
+                              MakeUintegerChecker<uint32_t>(1))
+                .AddAttribute("StreamBase",
+                              "First RNG stream of the per-link substreams",
+                              IntegerValue(1000),
+                              MakeIntegerAccessor(&ParallelThreeGppChannelModel::m_streamBase),
+                              MakeIntegerChecker<int64_t>(0))
+                .AddAttribute("MaxLinks",
+                              "Largest number of node pairs, each using a block of 16 streams "
+                              "from StreamBase",
+                              UintegerValue(4096),
+                              MakeUintegerAccessor(&ParallelThreeGppChannelModel::m_maxLinks),
+                              MakeUintegerChecker<uint32_t>(1))
+                .AddAttribute("LinkBlockage",
+                              "Apply the 3GPP blockage here, computing the attenuation of every "
+                              "(link, cluster) once per update for all the antenna pairs of the "
+                              "link",
+                              BooleanValue(true),
+                              MakeBooleanAccessor(&ParallelThreeGppChannelModel::m_linkBlockage),
+                              MakeBooleanChecker())
+                .AddAttribute("VectorizeBlockage",
+                              "Compute the blockage attenuation of all the links of a batch in "
+                              "one pass over flat arrays",
+                              BooleanValue(false),
+                              MakeBooleanAccessor(&ParallelThreeGppChannelModel::m_vectorizeBlockage),
+                              MakeBooleanChecker());
+        return tid;
+    }
+
+    ParallelThreeGppChannelModel() = default;
+    ~ParallelThreeGppChannelModel() override = default;
+
+    Ptr<const ChannelMatrix> GetChannel(Ptr<const MobilityModel> aMob,
+                                        Ptr<const MobilityModel> bMob,
+                                        Ptr<const PhasedArrayModel> aAntenna,
+                                        Ptr<const PhasedArrayModel> bAntenna) override
+    {
+        uint64_t antennaKey = GetKey(aAntenna->GetId(), bAntenna->GetId());
+        auto it = m_antennaPairs.find(antennaKey);
+        if (it != m_antennaPairs.end())
+        {
+            return it->second.channel;
+        }
+
+        NodePairLink& link = GetOrCreateLink(aMob, bMob);
+        AntennaPair& pair = m_antennaPairs[antennaKey];
+        // keep the antennas oriented as the mobility models of the link
+        bool reverse = aMob->GetObject<Node>()->GetId() != link.aNodeId;
+        pair.aAntenna = reverse ? bAntenna : aAntenna;
+        pair.bAntenna = reverse ? aAntenna : bAntenna;
+        link.antennaKeys.push_back(antennaKey);
+        pair.channel = link.model->GetChannel(link.aMob, link.bMob, pair.aAntenna, pair.bAntenna);
+        if (m_blockage)
+        {
+            // a pair first seen between two updates shares the attenuation of its link
+            if (!link.blockageValid)
+            {
+                UpdateBlockers(link);
+                ComputeBlockage(link);
+            }
+            ApplyBlockage(pair, link);
+        }
+        return pair.channel;
+    }
+
+    Ptr<const ChannelParams> GetParams(Ptr<const MobilityModel> aMob,
+                                       Ptr<const MobilityModel> bMob) const override
+    {
+        uint64_t nodeKey =
+            GetKey(aMob->GetObject<Node>()->GetId(), bMob->GetObject<Node>()->GetId());
+        auto it = m_links.find(nodeKey);
+        NS_ABORT_MSG_IF(it == m_links.end(), "GetParams called before GetChannel for this link");
+        return it->second.model->GetParams(aMob, bMob);
+    }
+
+    /**
+     * Set the first stream of the per-link substreams
+     * \param stream the first stream
+     * \return the number of streams reserved, a block for each of the MaxLinks links
+     */
+    int64_t AssignStreams(int64_t stream)
+    {
+        NS_ABORT_MSG_IF(!m_links.empty(), "Streams must be assigned before the first link is used");
+        m_streamBase = stream;
+        return STREAMS_PER_LINK * m_maxLinks;
+    }
+
+    void SetFrequency(double frequency)
+    {
+        m_frequency = frequency;
+        for (auto& entry : m_links)
+        {
+            entry.second.model->SetAttribute("Frequency", DoubleValue(frequency));
+        }
+    }
+
+    double GetFrequency() const
+    {
+        return m_frequency;
+    }
+
+    void SetScenario(const std::string& scenario)
+    {
+        m_scenario = scenario;
+        for (auto& entry : m_links)
+        {
+            entry.second.model->SetAttribute("Scenario", StringValue(scenario));
+        }
+    }
+
+    std::string GetScenario() const
+    {
+        return m_scenario;
+    }
+
+    void SetChannelConditionModel(Ptr<ChannelConditionModel> model)
+    {
+        NS_ABORT_MSG_IF(!m_links.empty(),
+                        "The channel condition model must be set before the first link is used");
+        m_conditionModel = model;
+    }
+
+    Ptr<ChannelConditionModel> GetChannelConditionModel() const
+    {
+        return m_conditionModel;
+    }
+
+    /**
+     * \return the number of node pairs whose channel is tracked
+     */
+    uint32_t GetNLinks() const
+    {
+        return m_links.size();
+    }
+
+    /**
+     * \return the number of batch updates executed so far
+     */
+    uint64_t GetNBatches() const
+    {
+        return m_nBatches;
+    }
+
+    /**
+     * Visit the cached channel of every pair of antennas
+     * \param f called with the two antennas, ordered as the link nodes, and the channel
+     */
+    void ForEachChannel(const std::function<void(Ptr<const PhasedArrayModel>,
+                                                 Ptr<const PhasedArrayModel>,
+                                                 Ptr<const ChannelMatrix>)>& f) const
+    {
+        for (const auto& entry : m_antennaPairs)
+        {
+            f(entry.second.aAntenna, entry.second.bAntenna, entry.second.channel);
+        }
+    }
+
+    /**
+     * \return the number of times the blockage attenuation of a link was computed
+     */
+    uint64_t GetNBlockageComputed() const
+    {
+        return m_nBlockageComputed;
+    }
+
+  protected:
+    void DoDispose() override
+    {
+        m_updateEvent.Cancel();
+        m_antennaPairs.clear();
+        m_links.clear();
+        m_rounds.clear();
+        m_pool.reset();
+        m_conditionModel = nullptr;
+        MatrixBasedChannelModel::DoDispose();
+    }
+
+  private:
+    /// Number of RNG streams reserved for each link
+    static constexpr int64_t STREAMS_PER_LINK = 16;
+
+    /// Attenuation of the self blocking region, TR 38.901 Sec. 7.6.4.1
+    static constexpr double SELF_BLOCKING_DB = 30.0;
+
+    /// Non-self blocker, angles in degrees
+    struct Blocker
+    {
+        double phi;   //!< azimuth center
+        double x;     //!< azimuth span
+        double theta; //!< zenith center
+        double y;     //!< zenith span
+    };
+
+    /// Channel of a pair of antennas, cached between two batch updates
+    struct AntennaPair
+    {
+        Ptr<const PhasedArrayModel> aAntenna;
+        Ptr<const PhasedArrayModel> bAntenna;
+        Ptr<const ChannelMatrix> channel;
+    };
+
+    /// Channel model state of a pair of nodes
+    struct NodePairLink
+    {
+        uint32_t aNodeId;
+        uint32_t bNodeId;
+        Ptr<const MobilityModel> aMob;
+        Ptr<const MobilityModel> bMob;
+        Ptr<ThreeGppChannelModel> model;
+        Ptr<LinkChannelConditionModel> condition;
+        std::vector<uint64_t> antennaKeys;
+
+        Ptr<UniformRandomVariable> blockerRv;
+        std::vector<Blocker> blockers;
+        Vector blockersDistance; //!< b - a position when the blockers were drawn
+        Time blockersTime;       //!< time when the blockers were drawn
+        DoubleVector aoaDeg;     //!< cluster angles of the current parameters
+        DoubleVector zoaDeg;
+        std::vector<double> scale; //!< amplitude scaling of every cluster
+        bool blockageValid{false}; //!< scale computed for the current parameters
+    };
+
+    NodePairLink& GetOrCreateLink(Ptr<const MobilityModel> aMob, Ptr<const MobilityModel> bMob)
+    {
+        uint32_t aNodeId = aMob->GetObject<Node>()->GetId();
+        uint32_t bNodeId = bMob->GetObject<Node>()->GetId();
+        uint64_t nodeKey = GetKey(aNodeId, bNodeId);
+        auto it = m_links.find(nodeKey);
+        if (it != m_links.end())
+        {
+            return it->second;
+        }
+
+        NS_ABORT_MSG_IF(!m_conditionModel, "The ChannelConditionModel attribute is not set");
+        NS_ABORT_MSG_IF(m_links.size() >= m_maxLinks,
+                        "More node pairs than ns3::ParallelThreeGppChannelModel::MaxLinks");
+        int64_t stream = m_streamBase + STREAMS_PER_LINK * static_cast<int64_t>(m_links.size());
+
+        Ptr<LinkChannelConditionModel> condition = CreateObject<LinkChannelConditionModel>();
+        condition->SetCondition(m_conditionModel->GetChannelCondition(aMob, bMob));
+
+        Ptr<ThreeGppChannelModel> model = CreateObject<ThreeGppChannelModel>();
+        model->SetAttribute("Frequency", DoubleValue(m_frequency));
+        model->SetAttribute("Scenario", StringValue(m_scenario));
+        model->SetChannelConditionModel(condition);
+        model->AssignStreams(stream);
+
+        if (m_links.empty())
+        {
+            BooleanValue blockage;
+            model->GetAttribute("Blockage", blockage);
+            m_blockage = m_linkBlockage && blockage.Get();
+            if (m_blockage)
+            {
+                BooleanValue portraitMode;
+                IntegerValue nBlockers;
+                DoubleValue blockerSpeed;
+                model->GetAttribute("PortraitMode", portraitMode);
+                model->GetAttribute("NumNonselfBlocking", nBlockers);
+                model->GetAttribute("BlockerSpeed", blockerSpeed);
+                m_portraitMode = portraitMode.Get();
+                m_nBlockers = nBlockers.Get();
+                m_blockerSpeed = blockerSpeed.Get();
+            }
+
+            // the cadence of the batches follows the update period configured for the
+            // 3GPP model; the per-link models only regenerate within a batch
+            TimeValue updatePeriod;
+            model->GetAttribute("UpdatePeriod", updatePeriod);
+            m_updatePeriod = updatePeriod.Get();
+            if (m_updatePeriod.IsStrictlyPositive())
+            {
+                int64_t periodNs = m_updatePeriod.GetNanoSeconds();
+                int64_t nowNs = Simulator::Now().GetNanoSeconds();
+                m_updateEvent = Simulator::Schedule(NanoSeconds(periodNs - nowNs % periodNs),
+                                                    &ParallelThreeGppChannelModel::UpdateBatch,
+                                                    this);
+            }
+        }
+        model->SetAttribute("UpdatePeriod", TimeValue(Time(0)));
+
+        NodePairLink& link = m_links[nodeKey];
+        link.aNodeId = aNodeId;
+        link.bNodeId = bNodeId;
+        link.aMob = aMob;
+        link.bMob = bMob;
+        link.model = model;
+        link.condition = condition;
+        if (m_blockage)
+        {
+            model->SetAttribute("Blockage", BooleanValue(false));
+            link.blockerRv = CreateObject<UniformRandomVariable>();
+            link.blockerRv->SetStream(stream + STREAMS_PER_LINK - 1);
+        }
+        m_rounds.clear();
+        return link;
+    }
+
+    /**
+     * Group the links in rounds in which every node appears at most once. The
+     * links are visited in key order, so the grouping is deterministic.
+     */
+    void BuildRounds()
+    {
+        std::vector<std::set<uint32_t>> busyNodes;
+        for (auto& entry : m_links)
+        {
+            NodePairLink* link = &entry.second;
+            std::size_t round = 0;
+            while (round < m_rounds.size() &&
+                   (busyNodes[round].count(link->aNodeId) || busyNodes[round].count(link->bNodeId)))
+            {
+                ++round;
+            }
+            if (round == m_rounds.size())
+            {
+                m_rounds.emplace_back();
+                busyNodes.emplace_back();
+            }
+            m_rounds[round].push_back(link);
+            busyNodes[round].insert(link->aNodeId);
+            busyNodes[round].insert(link->bNodeId);
+        }
+    }
+
+    void UpdateLink(NodePairLink& link)
+    {
+        for (uint64_t antennaKey : link.antennaKeys)
+        {
+            AntennaPair& pair = m_antennaPairs.at(antennaKey);
+            pair.channel = link.model->GetChannel(link.aMob, link.bMob, pair.aAntenna, pair.bAntenna);
+        }
+        if (m_blockage)
+        {
+            UpdateBlockers(link);
+            if (!m_vectorizeBlockage)
+            {
+                ComputeBlockage(link);
+                ApplyBlockage(link);
+            }
+        }
+    }
+
+    /// \return the wrapped difference a - b, in (-180, 180]
+    static double WrapDegrees(double a, double b)
+    {
+        double d = std::fmod(a - b, 360.0);
+        if (d > 180.0)
+        {
+            d -= 360.0;
+        }
+        else if (d <= -180.0)
+        {
+            d += 360.0;
+        }
+        return d;
+    }
+
+    /**
+     * Knife edge diffraction term of TR 38.901 eq. 7.6-23
+     * \param angle angle from the edge (degrees)
+     * \param sign +1 if the cluster is on the shadowed side of the edge, -1 otherwise
+     * \param k pi / lambda * r
+     */
+    static double EdgeTerm(double angle, double sign, double k)
+    {
+        double c = std::cos(angle * M_PI / 180.0);
+        if (c <= 0)
+        {
+            return sign * 0.5;
+        }
+        return std::atan(sign * M_PI / 2 * std::sqrt(k * (1 / c - 1))) / M_PI;
+    }
+
+    /// Non-self blocking attenuation (dB) of one blocker on one cluster
+    static double BlockerAttenuationDb(double aoa, double zoa, const Blocker& b, double k)
+    {
+        double dPhi = WrapDegrees(aoa, b.phi);
+        double dTheta = zoa - b.theta;
+        double fA = EdgeTerm(dPhi - b.x / 2, dPhi <= b.x / 2 ? 1 : -1, k) +
+                    EdgeTerm(dPhi + b.x / 2, dPhi >= -b.x / 2 ? 1 : -1, k);
+        double fZ = EdgeTerm(dTheta - b.y / 2, dTheta <= b.y / 2 ? 1 : -1, k) +
+                    EdgeTerm(dTheta + b.y / 2, dTheta >= -b.y / 2 ? 1 : -1, k);
+        return -20 * std::log10(std::max(1 - fA * fZ, 1e-3));
+    }
+
+    /// Self blocking attenuation (dB) of one cluster
+    double SelfBlockingDb(double aoa, double zoa) const
+    {
+        double phi = m_portraitMode ? 260.0 : 40.0;
+        double x = m_portraitMode ? 120.0 : 160.0;
+        double theta = m_portraitMode ? 100.0 : 110.0;
+        double y = m_portraitMode ? 80.0 : 75.0;
+        bool inside = std::abs(WrapDegrees(aoa, phi)) <= x / 2 && std::abs(zoa - theta) <= y / 2;
+        return inside ? SELF_BLOCKING_DB : 0.0;
+    }
+
+    bool IsIndoor() const
+    {
+        return m_scenario.rfind("InH", 0) == 0;
+    }
+
+    /// \return pi / lambda * r, r being the distance of the blockers
+    double GetBlockerK() const
+    {
+        return M_PI * m_frequency / 299792458.0 * (IsIndoor() ? 2.0 : 10.0);
+    }
+
+    /**
+     * Redraw the blockers if the link moved, or they may have moved, by more
+     * than the correlation distance, and read the cluster angles of the
+     * current parameters of the link, invalidating its attenuation.
+     */
+    void UpdateBlockers(NodePairLink& link)
+    {
+        Vector distance = link.bMob->GetPosition() - link.aMob->GetPosition();
+        double moved = (distance - link.blockersDistance).GetLength() +
+                       m_blockerSpeed * (Simulator::Now() - link.blockersTime).GetSeconds();
+        bool redraw = link.blockers.empty() && m_nBlockers > 0;
+        if (redraw || moved > (IsIndoor() ? 5.0 : 10.0))
+        {
+            link.blockers.resize(m_nBlockers);
+            for (Blocker& b : link.blockers)
+            {
+                b.phi = link.blockerRv->GetValue(0, 360);
+                b.x = IsIndoor() ? link.blockerRv->GetValue(15, 45) : link.blockerRv->GetValue(5, 15);
+                b.theta = 90;
+                b.y = IsIndoor() ? link.blockerRv->GetValue(5, 15) : 5;
+            }
+            link.blockersDistance = distance;
+            link.blockersTime = Simulator::Now();
+        }
+
+        Ptr<const ChannelParams> params = link.model->GetParams(link.aMob, link.bMob);
+        const DoubleVector& aoa = params->m_angle[MatrixBasedChannelModel::AOA_INDEX];
+        const DoubleVector& zoa = params->m_angle[MatrixBasedChannelModel::ZOA_INDEX];
+        link.aoaDeg.resize(aoa.size());
+        link.zoaDeg.resize(zoa.size());
+        for (std::size_t c = 0; c < aoa.size(); ++c)
+        {
+            link.aoaDeg[c] = aoa[c] * 180 / M_PI;
+            link.zoaDeg[c] = zoa[c] * 180 / M_PI;
+        }
+        link.blockageValid = false;
+    }
+
+    /// Compute the attenuation of every cluster of a link
+    void ComputeBlockage(NodePairLink& link)
+    {
+        double k = GetBlockerK();
+        link.scale.resize(link.aoaDeg.size());
+        for (std::size_t c = 0; c < link.aoaDeg.size(); ++c)
+        {
+            double attenuationDb = SelfBlockingDb(link.aoaDeg[c], link.zoaDeg[c]);
+            for (const Blocker& b : link.blockers)
+            {
+                attenuationDb += BlockerAttenuationDb(link.aoaDeg[c], link.zoaDeg[c], b, k);
+            }
+            link.scale[c] = std::pow(10, -attenuationDb / 20);
+        }
+        link.blockageValid = true;
+        ++m_nBlockageComputed;
+    }
+
+    /**
+     * Compute the attenuation of the links of a batch in one pass: every
+     * (link, cluster, blocker) triple is flattened in structure-of-arrays form,
+     * so the kernel is a single loop without branches on the link layout.
+     */
+    void ComputeBlockageBatch(const std::vector<NodePairLink*>& links)
+    {
+        std::vector<double> aoa;
+        std::vector<double> zoa;
+        std::vector<double> phi;
+        std::vector<double> x;
+        std::vector<double> theta;
+        std::vector<double> y;
+        std::vector<std::size_t> cluster; //!< index in the flat cluster list
+        std::size_t nClusters = 0;
+        for (NodePairLink* link : links)
+        {
+            for (std::size_t c = 0; c < link->aoaDeg.size(); ++c, ++nClusters)
+            {
+                for (const Blocker& b : link->blockers)
+                {
+                    aoa.push_back(link->aoaDeg[c]);
+                    zoa.push_back(link->zoaDeg[c]);
+                    phi.push_back(b.phi);
+                    x.push_back(b.x);
+                    theta.push_back(b.theta);
+                    y.push_back(b.y);
+                    cluster.push_back(nClusters);
+                }
+            }
+        }
+
+        double k = GetBlockerK();
+        std::vector<double> attenuationDb(aoa.size());
+        for (std::size_t i = 0; i < aoa.size(); ++i)
+        {
+            attenuationDb[i] = BlockerAttenuationDb(aoa[i], zoa[i], {phi[i], x[i], theta[i], y[i]}, k);
+        }
+
+        std::vector<double> clusterDb(nClusters, 0.0);
+        for (std::size_t i = 0; i < attenuationDb.size(); ++i)
+        {
+            clusterDb[cluster[i]] += attenuationDb[i];
+        }
+        std::size_t offset = 0;
+        for (NodePairLink* link : links)
+        {
+            link->scale.resize(link->aoaDeg.size());
+            for (std::size_t c = 0; c < link->aoaDeg.size(); ++c, ++offset)
+            {
+                double db = clusterDb[offset] + SelfBlockingDb(link->aoaDeg[c], link->zoaDeg[c]);
+                link->scale[c] = std::pow(10, -db / 20);
+            }
+            link->blockageValid = true;
+            ++m_nBlockageComputed;
+        }
+    }
+
+    /// Scale the clusters of the channel of one antenna pair
+    void ApplyBlockage(AntennaPair& pair, const NodePairLink& link)
+    {
+        Ptr<ChannelMatrix> blocked = Create<ChannelMatrix>(*pair.channel);
+        std::size_t pageSize = blocked->m_channel.GetNumRows() * blocked->m_channel.GetNumCols();
+        for (std::size_t c = 0; c < blocked->m_channel.GetNumPages() && c < link.scale.size(); ++c)
+        {
+            std::complex<double>* h = blocked->m_channel.GetPagePtr(c);
+            for (std::size_t i = 0; i < pageSize; ++i)
+            {
+                h[i] *= link.scale[c];
+            }
+        }
+        pair.channel = blocked;
+    }
+
+    void ApplyBlockage(NodePairLink& link)
+    {
+        for (uint64_t antennaKey : link.antennaKeys)
+        {
+            ApplyBlockage(m_antennaPairs.at(antennaKey), link);
+        }
+    }
+
+    void UpdateBatch()
+    {
+        if (!m_pool || m_pool->GetNThreads() != m_nThreads)
+        {
+            m_pool = std::make_unique<WorkerPool>(m_nThreads);
+        }
+        if (m_rounds.empty())
+        {
+            BuildRounds();
+        }
+        // the conditions are read from the shared model here, on the simulator
+        // thread, and the parameters of the links may only expire in this batch
+        for (auto& entry : m_links)
+        {
+            NodePairLink& link = entry.second;
+            link.condition->SetCondition(
+                m_conditionModel->GetChannelCondition(link.aMob, link.bMob));
+            link.model->SetAttribute("UpdatePeriod", TimeValue(NanoSeconds(1)));
+        }
+        for (auto& round : m_rounds)
+        {
+            m_pool->ParallelFor(round.size(), [&round, this](std::size_t i) { UpdateLink(*round[i]); });
+        }
+        for (auto& entry : m_links)
+        {
+            entry.second.model->SetAttribute("UpdatePeriod", TimeValue(Time(0)));
+        }
+        if (m_blockage && m_vectorizeBlockage)
+        {
+            std::vector<NodePairLink*> links;
+            for (auto& entry : m_links)
+            {
+                links.push_back(&entry.second);
+            }
+            ComputeBlockageBatch(links);
+            m_pool->ParallelFor(links.size(),
+                                [&links, this](std::size_t i) { ApplyBlockage(*links[i]); });
+        }
+        ++m_nBatches;
+        m_updateEvent =
+            Simulator::Schedule(m_updatePeriod, &ParallelThreeGppChannelModel::UpdateBatch, this);
+    }
+
+    double m_frequency{500.0e6};
+    std::string m_scenario{"UMa"};
+    Ptr<ChannelConditionModel> m_conditionModel;
+    uint32_t m_nThreads{1};
+    int64_t m_streamBase{1000};
+    uint32_t m_maxLinks{4096};
+    Time m_updatePeriod;
+    EventId m_updateEvent;
+    uint64_t m_nBatches{0};
+    bool m_linkBlockage{true};
+    bool m_vectorizeBlockage{false};
+    bool m_blockage{false}; //!< blockage applied by this model
+    bool m_portraitMode{true};
+    int64_t m_nBlockers{4};
+    double m_blockerSpeed{1.0};
+    std::atomic<uint64_t> m_nBlockageComputed{0};
+    std::map<uint64_t, NodePairLink> m_links;         //!< links indexed by node pair key
+    std::map<uint64_t, AntennaPair> m_antennaPairs;   //!< channels indexed by antenna pair key
+    std::vector<std::vector<NodePairLink*>> m_rounds; //!< conflict-free groups of links
+    std::unique_ptr<WorkerPool> m_pool;
+};
+
+NS_OBJECT_ENSURE_REGISTERED(ParallelThreeGppChannelModel);
+
+} // namespace ns3
+
+#endif /* PARALLEL_THREE_GPP_CHANNEL_MODEL_H */
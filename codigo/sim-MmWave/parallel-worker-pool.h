@@ -0,0 +1,220 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PARALLEL_WORKER_POOL_H
+#define PARALLEL_WORKER_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * Fixed-size pool of worker threads used to run independent jobs of a batch.
+ *
+ * The pool only depends on the standard library, so it can be shared by the
+ * simulation scripts and by the offline trace tools. A batch is submitted with
+ * ParallelFor (), which blocks until every job has been executed; the calling
+ * thread takes part in the batch, so a pool created with zero or one thread runs
+ * the jobs inline, in index order.
+ *
+ * Jobs must not touch state shared with other jobs of the same batch: the pool
+ * gives no ordering guarantee between them.
+ */
+class WorkerPool
+{
+  public:
+    /**
+     * \param nThreads total number of threads running a batch, including the caller
+     */
+    explicit WorkerPool(uint32_t nThreads)
+        : m_nThreads(std::max<uint32_t>(nThreads, 1))
+    {
+        for (uint32_t i = 1; i < m_nThreads; ++i)
+        {
+            m_workers.emplace_back(&WorkerPool::WorkerLoop, this);
+        }
+    }
+
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wakeUp.notify_all();
+        for (auto& worker : m_workers)
+        {
+            worker.join();
+        }
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /**
+     * \return the number of threads running a batch, including the caller
+     */
+    uint32_t GetNThreads() const
+    {
+        return m_nThreads;
+    }
+
+    /**
+     * Run job (i) for every i in [0, n) and wait for all of them to complete.
+     * The first exception thrown by a job is rethrown in the calling thread.
+     *
+     * \param n number of jobs in the batch
+     * \param job the function executed for each index
+     */
+    void ParallelFor(std::size_t n, const std::function<void(std::size_t)>& job)
+    {
+        if (n == 0)
+        {
+            return;
+        }
+        if (m_workers.empty() || n == 1)
+        {
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                job(i);
+            }
+            return;
+        }
+
+        auto batch = std::make_shared<Batch>(job, n);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_batch = batch;
+            ++m_generation;
+        }
+        m_wakeUp.notify_all();
+
+        RunJobs(*batch);
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_batchDone.wait(lock, [&batch]() { return batch->nDone == batch->nJobs; });
+        m_batch.reset();
+        if (batch->error)
+        {
+            std::rethrow_exception(batch->error);
+        }
+    }
+
+  private:
+    /**
+     * State of one submitted batch. Each batch owns its job counter, so a
+     * worker that wakes up late can only find an exhausted counter and never
+     * runs a job of a later batch twice.
+     */
+    struct Batch
+    {
+        Batch(const std::function<void(std::size_t)>& j, std::size_t n)
+            : job(j),
+              nJobs(n)
+        {
+        }
+
+        const std::function<void(std::size_t)>& job;
+        const std::size_t nJobs;
+        std::atomic<std::size_t> nextJob{0};
+        std::size_t nDone{0}; //!< protected by m_mutex
+        std::exception_ptr error; //!< protected by m_mutex
+    };
+
+    void WorkerLoop()
+    {
+        uint64_t seenGeneration = 0;
+        while (true)
+        {
+            std::shared_ptr<Batch> batch;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wakeUp.wait(lock,
+                              [&]() { return m_stop || m_generation != seenGeneration; });
+                if (m_stop)
+                {
+                    return;
+                }
+                seenGeneration = m_generation;
+                batch = m_batch;
+            }
+            if (batch)
+            {
+                RunJobs(*batch);
+            }
+        }
+    }
+
+    void RunJobs(Batch& batch)
+    {
+        std::size_t executed = 0;
+        std::exception_ptr error;
+        while (true)
+        {
+            std::size_t i = batch.nextJob.fetch_add(1);
+            if (i >= batch.nJobs)
+            {
+                break;
+            }
+            try
+            {
+                batch.job(i);
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+            ++executed;
+        }
+        if (executed == 0)
+        {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (error && !batch.error)
+        {
+            batch.error = error;
+        }
+        batch.nDone += executed;
+        if (batch.nDone == batch.nJobs)
+        {
+            m_batchDone.notify_all();
+        }
+    }
+
+    uint32_t m_nThreads;
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_wakeUp;
+    std::condition_variable m_batchDone;
+    std::shared_ptr<Batch> m_batch;
+    uint64_t m_generation{0};
+    bool m_stop{false};
+};
+
+} // namespace ns3
+
+#endif /* PARALLEL_WORKER_POOL_H */
@@ -0,0 +1,62 @@
+#!/bin/bash
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License version 2 as
+# published by the Free Software Foundation;
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#
+#  Compare the wall clock time and the peak memory of saturated runs of
+#  mc-twoenbs.cc (one UDP packet per UE every INTERVAL us) and of Packet5G.cc,
+#  with and without the packet pool allocator.
+#
+#  The pool is a build option: each scenario must be in its own directory of
+#  scratch/ with packet-pool-allocator.cc and the headers, i.e.
+#  scratch/mc-twoenbs/ and scratch/Packet5G/. Run from the root of the ns-3
+#  tree once configured as usual (BUILD=default, packetPool=false only) and
+#  once with CXXFLAGS=-DNS3_PACKET_POOL (BUILD=pool, packetPool=false and
+#  true), appending to the same output:
+#  $ bash pool-allocator-benchmark.sh
+#  $ CXXFLAGS=-DNS3_PACKET_POOL ./ns3 configure ... && BUILD=pool bash pool-allocator-benchmark.sh
+#
+
+RUNS=${RUNS:-3}
+INTERVAL=${INTERVAL:-1}
+SIMTIME=${SIMTIME:-2}
+OUT=${OUT:-pool-allocator-benchmark.txt}
+BUILD=${BUILD:-default}
+SCENARIOS=("mc-twoenbs --print=false --benchmark=true --interPckInterval=$INTERVAL"
+    "Packet5G --simTime=$SIMTIME --benchmark=true")
+POOLS="false"
+if [ "$BUILD" = "pool" ]; then
+    POOLS="false true"
+fi
+
+./ns3 build mc-twoenbs Packet5G || exit 1
+
+if [ ! -f $OUT ]; then
+    echo -e "scenario\tbuild\tpacketPool\trun\tevents\twall(s)\tmaxRss(kB)" | tee $OUT
+fi
+for scenario in "${SCENARIOS[@]}"; do
+    for pool in $POOLS; do
+        for run in $(seq 1 $RUNS); do
+            dir=$(mktemp -d)
+            start=$(date +%s.%N)
+            /usr/bin/time -f "maxRss %M" ./ns3 run --no-build --cwd=$dir \
+                "$scenario --packetPool=$pool" > $dir/log.txt 2>&1
+            wall=$(echo "$(date +%s.%N) - $start" | bc)
+            events=$(grep "Events executed:" $dir/log.txt | awk '{ print $3 }')
+            rss=$(grep "maxRss" $dir/log.txt | awk '{ print $2 }')
+            echo -e "${scenario%% *}\t$BUILD\t$pool\t$run\t$events\t$wall\t$rss" | tee -a $OUT
+            rm -rf $dir
+        done
+    done
+done
@@ -0,0 +1,592 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PROFILING_SIMULATOR_IMPL_H
+#define PROFILING_SIMULATOR_IMPL_H
+
+#include "ns3/core-module.h"
+#include "ns3/scheduler.h"
+#include "ns3/simulator-impl.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <fstream>
+#include <list>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace ns3
+{
+
+/**
+ * Sequential simulator implementation that profiles the executed events.
+ *
+ * The event loop is the one of DefaultSimulatorImpl. In addition, the time
+ * spent in every event is measured with the time stamp counter and charged,
+ * together with a counter, to the event. The dynamic type of an event made by
+ * MakeEvent only names the target class and the signature of the target method,
+ * so two methods of a class with the same signature, and every std::function
+ * event, would share one type. The events are therefore also told apart by
+ * their call site: the function that called Simulator::Schedule* for them, taken
+ * from the stack when the event is scheduled and resolved with dladdr () when
+ * the profile is printed. In ns-3 a method is scheduled from a few fixed places
+ * (e.g. MmWaveEnbPhy::StartSlot schedules EndSlot), so the pair type and call
+ * site separates the events that the type alone lumps together. The functions
+ * of the executable are resolved only when it is linked with -rdynamic;
+ * otherwise they are printed as file+offset, for addr2line.
+ *
+ * At the end of Run () the profile is written to ProfileFile, sorted by
+ * decreasing time. The cost is two TSC reads and one hash lookup per event and,
+ * with CallSites, a short stack walk per scheduled event. The walk runs inside
+ * the scheduling event and its time is deducted from that event.
+ *
+ * Select it with --SimulatorImplementationType=ns3::ProfilingSimulatorImpl
+ */
+class ProfilingSimulatorImpl : public SimulatorImpl
+{
+  public:
+    static TypeId GetTypeId()
+    {
+        static TypeId tid =
+            TypeId("ns3::ProfilingSimulatorImpl")
+                .SetParent<SimulatorImpl>()
+                .SetGroupName("Core")
+                .AddConstructor<ProfilingSimulatorImpl>()
+                .AddAttribute("ProfileFile",
+                              "File the event profile is written to at the end of Run ()",
+                              StringValue("EventProfile.txt"),
+                              MakeStringAccessor(&ProfilingSimulatorImpl::m_profileFile),
+                              MakeStringChecker())
+                .AddAttribute("CallSites",
+                              "Tell apart the events of the same type by the function that "
+                              "scheduled them",
+                              BooleanValue(true),
+                              MakeBooleanAccessor(&ProfilingSimulatorImpl::m_callSites),
+                              MakeBooleanChecker());
+        return tid;
+    }
+
+    ProfilingSimulatorImpl()
+        : m_mainThreadId(std::this_thread::get_id())
+    {
+    }
+
+    ~ProfilingSimulatorImpl() override = default;
+
+    void Destroy() override
+    {
+        while (!m_destroyEvents.empty())
+        {
+            Ptr<EventImpl> ev = m_destroyEvents.front().PeekEventImpl();
+            m_destroyEvents.pop_front();
+            if (!ev->IsCancelled())
+            {
+                ev->Invoke();
+            }
+        }
+    }
+
+    bool IsFinished() const override
+    {
+        return m_events->IsEmpty() || m_stop;
+    }
+
+    void Stop() override
+    {
+        m_stop = true;
+    }
+
+    void Stop(const Time& delay) override
+    {
+        Simulator::Schedule(delay, &Simulator::Stop);
+    }
+
+    EventId Schedule(const Time& delay, EventImpl* event) override
+    {
+        return DoSchedule(delay, event, CallSite());
+    }
+
+    void ScheduleWithContext(uint32_t context, const Time& delay, EventImpl* event) override
+    {
+        if (m_mainThreadId == std::this_thread::get_id())
+        {
+            Time tAbsolute = delay + TimeStep(m_currentTs);
+            Scheduler::Event ev;
+            ev.impl = event;
+            ev.key.m_ts = static_cast<uint64_t>(tAbsolute.GetTimeStep());
+            ev.key.m_context = context;
+            ev.key.m_uid = m_uid++;
+            m_unscheduledEvents++;
+            m_events->Insert(ev);
+            SetCallSite(event, CallSite());
+        }
+        else
+        {
+            // the other threads are not profiled by call site
+            std::lock_guard<std::mutex> lock(m_eventsWithContextMutex);
+            m_eventsWithContext.push_back({context, uint64_t(delay.GetTimeStep()), event});
+            m_eventsWithContextEmpty = false;
+        }
+    }
+
+    EventId ScheduleNow(EventImpl* event) override
+    {
+        return DoSchedule(Time(0), event, CallSite());
+    }
+
+    EventId ScheduleDestroy(EventImpl* event) override
+    {
+        NS_ASSERT_MSG(m_mainThreadId == std::this_thread::get_id(),
+                      "Simulator::ScheduleDestroy Thread-unsafe invocation!");
+        EventId id(Ptr<EventImpl>(event, false), m_currentTs, 0xffffffff, EventId::UID::DESTROY);
+        m_destroyEvents.push_back(id);
+        m_uid++;
+        return id;
+    }
+
+    void Remove(const EventId& id) override
+    {
+        if (id.GetUid() == EventId::UID::DESTROY)
+        {
+            for (auto i = m_destroyEvents.begin(); i != m_destroyEvents.end(); ++i)
+            {
+                if (*i == id)
+                {
+                    m_destroyEvents.erase(i);
+                    break;
+                }
+            }
+            return;
+        }
+        if (IsExpired(id))
+        {
+            return;
+        }
+        Scheduler::Event event;
+        event.impl = id.PeekEventImpl();
+        event.key.m_ts = id.GetTs();
+        event.key.m_context = id.GetContext();
+        event.key.m_uid = id.GetUid();
+        m_events->Remove(event);
+        m_sites.erase(event.impl);
+        event.impl->Cancel();
+        // whenever we remove an event from the event list, we have to unref it
+        event.impl->Unref();
+        m_unscheduledEvents--;
+    }
+
+    void Cancel(const EventId& id) override
+    {
+        if (!IsExpired(id))
+        {
+            id.PeekEventImpl()->Cancel();
+        }
+    }
+
+    bool IsExpired(const EventId& id) const override
+    {
+        if (id.GetUid() == EventId::UID::DESTROY)
+        {
+            if (id.PeekEventImpl() == nullptr || id.PeekEventImpl()->IsCancelled())
+            {
+                return true;
+            }
+            return std::find(m_destroyEvents.begin(), m_destroyEvents.end(), id) ==
+                   m_destroyEvents.end();
+        }
+        return id.PeekEventImpl() == nullptr || id.GetTs() < m_currentTs ||
+               (id.GetTs() == m_currentTs && id.GetUid() <= m_currentUid) ||
+               id.PeekEventImpl()->IsCancelled();
+    }
+
+    void Run() override
+    {
+        m_mainThreadId = std::this_thread::get_id();
+        ProcessEventsWithContext();
+        m_stop = false;
+
+        uint64_t tscStart = ReadTsc();
+        auto wallStart = std::chrono::steady_clock::now();
+        while (!m_events->IsEmpty() && !m_stop)
+        {
+            ProcessOneEvent();
+        }
+        double wall =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+        uint64_t tscTotal = ReadTsc() - tscStart;
+
+        // If the simulator stopped naturally by lack of events, make a
+        // consistency test to check that we didn't lose any events along the way.
+        NS_ASSERT(!m_events->IsEmpty() || m_unscheduledEvents == 0);
+        PrintProfile(tscTotal, wall);
+    }
+
+    Time Now() const override
+    {
+        return TimeStep(m_currentTs);
+    }
+
+    Time GetDelayLeft(const EventId& id) const override
+    {
+        if (IsExpired(id))
+        {
+            return TimeStep(0);
+        }
+        return TimeStep(id.GetTs() - m_currentTs);
+    }
+
+    Time GetMaximumSimulationTime() const override
+    {
+        return TimeStep(0x7fffffffffffffffLL);
+    }
+
+    void SetScheduler(ObjectFactory schedulerFactory) override
+    {
+        Ptr<Scheduler> scheduler = schedulerFactory.Create<Scheduler>();
+        if (m_events)
+        {
+            while (!m_events->IsEmpty())
+            {
+                scheduler->Insert(m_events->RemoveNext());
+            }
+        }
+        m_events = scheduler;
+    }
+
+    uint32_t GetSystemId() const override
+    {
+        return 0;
+    }
+
+    uint32_t GetContext() const override
+    {
+        return m_currentContext;
+    }
+
+    uint64_t GetEventCount() const override
+    {
+        return m_eventCount;
+    }
+
+  protected:
+    void DoDispose() override
+    {
+        ProcessEventsWithContext();
+        while (m_events && !m_events->IsEmpty())
+        {
+            Scheduler::Event next = m_events->RemoveNext();
+            next.impl->Unref();
+        }
+        m_events = nullptr;
+        m_sites.clear();
+        SimulatorImpl::DoDispose();
+    }
+
+  private:
+    /// Time and number of the events of one type and call site
+    struct Entry
+    {
+        uint64_t cycles{0};
+        uint64_t count{0};
+    };
+
+    /// Event type and the code address that scheduled it (nullptr if unknown)
+    struct Key
+    {
+        const std::type_info* type;
+        void* site;
+
+        bool operator==(const Key& other) const
+        {
+            return type == other.type && site == other.site;
+        }
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key& key) const
+        {
+            return std::hash<const void*>()(key.type) * 31 + std::hash<void*>()(key.site);
+        }
+    };
+
+    struct EventWithContext
+    {
+        uint32_t context;
+        uint64_t timestamp; //!< delay, in time steps
+        EventImpl* event;
+    };
+
+    static uint64_t ReadTsc()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+#endif
+    }
+
+    EventId DoSchedule(const Time& delay, EventImpl* event, void* site)
+    {
+        NS_ASSERT_MSG(m_mainThreadId == std::this_thread::get_id(),
+                      "Simulator::Schedule Thread-unsafe invocation!");
+        Time tAbsolute = delay + TimeStep(m_currentTs);
+        NS_ASSERT(tAbsolute.IsPositive());
+        NS_ASSERT(tAbsolute >= TimeStep(m_currentTs));
+        Scheduler::Event ev;
+        ev.impl = event;
+        ev.key.m_ts = static_cast<uint64_t>(tAbsolute.GetTimeStep());
+        ev.key.m_context = GetContext();
+        ev.key.m_uid = m_uid++;
+        m_unscheduledEvents++;
+        m_events->Insert(ev);
+        SetCallSite(event, site);
+        return EventId(event, ev.key.m_ts, ev.key.m_context, ev.key.m_uid);
+    }
+
+    /**
+     * Code address of the function that called Simulator::Schedule*, or nullptr.
+     * Frame 0 is this function and frame 1 the SimulatorImpl method that called
+     * it (both not inlined: the first by attribute, the second because it is
+     * called through the virtual table); the frames of the Simulator wrappers
+     * and of the ns-3 timers are skipped.
+     */
+    __attribute__((noinline)) void* CallSite()
+    {
+        if (!m_callSites)
+        {
+            return nullptr;
+        }
+        uint64_t start = ReadTsc();
+        void* frames[MAX_FRAMES];
+        int n = backtrace(frames, MAX_FRAMES);
+        void* site = nullptr;
+        for (int i = 2; i < n && site == nullptr; ++i)
+        {
+            auto it = m_wrapperFrames.find(frames[i]);
+            if (it == m_wrapperFrames.end())
+            {
+                it = m_wrapperFrames.emplace(frames[i], IsWrapper(frames[i])).first;
+            }
+            if (!it->second)
+            {
+                site = frames[i];
+            }
+        }
+        m_callSiteCycles += ReadTsc() - start;
+        return site;
+    }
+
+    void SetCallSite(EventImpl* event, void* site)
+    {
+        if (site != nullptr)
+        {
+            m_sites[event] = site;
+        }
+    }
+
+    /// Whether the code address belongs to a function that only forwards the event
+    static bool IsWrapper(void* address)
+    {
+        Dl_info info;
+        if (dladdr(address, &info) == 0 || info.dli_sname == nullptr)
+        {
+            return false;
+        }
+        std::string name = Demangle(info.dli_sname);
+        for (const char* prefix : {"ns3::Simulator::",
+                                   "ns3::SimulatorImpl::",
+                                   "ns3::ProfilingSimulatorImpl::",
+                                   "ns3::MakeEvent",
+                                   "ns3::Timer",
+                                   "ns3::Watchdog::"})
+        {
+            if (name.compare(0, std::char_traits<char>::length(prefix), prefix) == 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// Name of the function at the code address, or file+offset without symbols
+    static std::string SiteName(void* address)
+    {
+        if (address == nullptr)
+        {
+            return "-";
+        }
+        Dl_info info;
+        if (dladdr(address, &info) == 0)
+        {
+            return "?";
+        }
+        if (info.dli_sname != nullptr)
+        {
+            return Demangle(info.dli_sname);
+        }
+        std::string file = info.dli_fname != nullptr ? info.dli_fname : "?";
+        file = file.substr(file.find_last_of('/') + 1);
+        char offset[32];
+        std::snprintf(offset,
+                      sizeof(offset),
+                      "+0x%zx",
+                      static_cast<size_t>(static_cast<char*>(address) -
+                                          static_cast<char*>(info.dli_fbase)));
+        return file + offset;
+    }
+
+    void ProcessOneEvent()
+    {
+        Scheduler::Event next = m_events->RemoveNext();
+        NS_ASSERT(next.key.m_ts >= m_currentTs);
+        m_unscheduledEvents--;
+        m_eventCount++;
+        m_currentTs = next.key.m_ts;
+        m_currentContext = next.key.m_context;
+        m_currentUid = next.key.m_uid;
+
+        void* site = nullptr;
+        auto it = m_sites.find(next.impl);
+        if (it != m_sites.end())
+        {
+            site = it->second;
+            m_sites.erase(it);
+        }
+
+        EventImpl& impl = *next.impl;
+        m_callSiteCycles = 0;
+        uint64_t start = ReadTsc();
+        impl.Invoke();
+        uint64_t cycles = ReadTsc() - start;
+        // the stack walks of the events scheduled by this one are not its cost
+        cycles -= std::min(cycles, m_callSiteCycles);
+        Entry& entry = m_profile[Key{&typeid(impl), site}];
+        entry.cycles += cycles;
+        ++entry.count;
+
+        next.impl->Unref();
+        ProcessEventsWithContext();
+    }
+
+    void ProcessEventsWithContext()
+    {
+        if (m_eventsWithContextEmpty)
+        {
+            return;
+        }
+        std::list<EventWithContext> eventsWithContext;
+        {
+            std::lock_guard<std::mutex> lock(m_eventsWithContextMutex);
+            m_eventsWithContext.swap(eventsWithContext);
+            m_eventsWithContextEmpty = true;
+        }
+        for (const EventWithContext& event : eventsWithContext)
+        {
+            Scheduler::Event ev;
+            ev.impl = event.event;
+            ev.key.m_ts = m_currentTs + event.timestamp;
+            ev.key.m_context = event.context;
+            ev.key.m_uid = m_uid++;
+            m_unscheduledEvents++;
+            m_events->Insert(ev);
+        }
+    }
+
+    static std::string Demangle(const char* name)
+    {
+        int status = 0;
+        char* demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+        std::string result = status == 0 ? demangled : name;
+        std::free(demangled);
+        return result;
+    }
+
+    void PrintProfile(uint64_t tscTotal, double wall) const
+    {
+        // the same type may have several type_info objects, one per shared library
+        std::map<std::string, Entry> byName;
+        uint64_t profiled = 0;
+        for (const auto& entry : m_profile)
+        {
+            Entry& e = byName[Demangle(entry.first.type->name()) + "\t" +
+                              SiteName(entry.first.site)];
+            e.cycles += entry.second.cycles;
+            e.count += entry.second.count;
+            profiled += entry.second.cycles;
+        }
+        std::vector<std::pair<std::string, Entry>> sorted(byName.begin(), byName.end());
+        std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+            return a.second.cycles > b.second.cycles;
+        });
+
+        double secondsPerCycle = tscTotal > 0 ? wall / tscTotal : 0;
+        std::ofstream out(m_profileFile.c_str(), std::ios_base::out | std::ios_base::trunc);
+        out << "# " << m_eventCount << " events, " << wall << " s, "
+            << (tscTotal > 0 ? 100.0 * profiled / tscTotal : 0) << " % inside events" << std::endl;
+        out << "share(%)\ttime(s)\tevents\tmean(ns)\tevent\tscheduledBy" << std::endl;
+        for (const auto& entry : sorted)
+        {
+            double seconds = entry.second.cycles * secondsPerCycle;
+            out << 100.0 * entry.second.cycles / std::max<uint64_t>(profiled, 1) << "\t"
+                << seconds << "\t" << entry.second.count << "\t"
+                << 1e9 * seconds / entry.second.count << "\t" << entry.first << std::endl;
+        }
+    }
+
+    static constexpr int MAX_FRAMES = 8; //!< frames walked to find the call site
+
+    std::string m_profileFile{"EventProfile.txt"};
+    bool m_callSites{true};
+    std::list<EventId> m_destroyEvents;
+    bool m_stop{false};
+    Ptr<Scheduler> m_events;
+    // uids are allocated from 4: 0 is invalid events, 1 is 'now' events, 2 is 'destroy' events
+    uint32_t m_uid{EventId::UID::VALID};
+    uint32_t m_currentUid{EventId::UID::INVALID};
+    uint64_t m_currentTs{0};
+    uint32_t m_currentContext{Simulator::NO_CONTEXT};
+    uint64_t m_eventCount{0};
+    int m_unscheduledEvents{0};
+    std::list<EventWithContext> m_eventsWithContext;
+    std::atomic<bool> m_eventsWithContextEmpty{true};
+    std::mutex m_eventsWithContextMutex;
+    std::thread::id m_mainThreadId;
+    std::unordered_map<Key, Entry, KeyHash> m_profile;    //!< per event type and call site
+    std::unordered_map<EventImpl*, void*> m_sites;        //!< call site of the pending events
+    std::unordered_map<void*, bool> m_wrapperFrames;      //!< IsWrapper () cache
+    uint64_t m_callSiteCycles{0};                         //!< CallSite () time in this event
+};
+
+NS_OBJECT_ENSURE_REGISTERED(ProfilingSimulatorImpl);
+
+} // namespace ns3
+
+#endif /* PROFILING_SIMULATOR_IMPL_H */
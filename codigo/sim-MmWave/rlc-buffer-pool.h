@@ -0,0 +1,336 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef RLC_BUFFER_POOL_H
+#define RLC_BUFFER_POOL_H
+
+#include "ns3/core-module.h"
+#include "ns3/lte-pdcp.h"
+#include "ns3/lte-rlc.h"
+#include "ns3/packet.h"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <string>
+
+namespace ns3
+{
+
+/**
+ * A transmit buffer budget shared by the RLC entities of each eNB.
+ *
+ * Every bearer normally gets its own MaxTxBufferSize, so the memory that a
+ * saturated simulation may hold grows with the number of UEs and bearers. The
+ * pool bounds it per eNB instead. The RLC entities of the eNBs are found by
+ * scanning the UE contexts of the RRC every ScanInterval, and the pool sets
+ * their MaxTxBufferSize according to the Policy:
+ *
+ * - Partition: every bearer of an eNB gets an equal share of PoolSize, at most
+ *   BearerQuota. The sum of the limits never exceeds the pool.
+ * - Shared: a bearer may use the part of the pool the others do not, up to
+ *   BearerQuota. Its limit is updated at every PDCP PDU it receives, from the
+ *   occupancy of the pool. The occupancy of a bearer is estimated from its
+ *   traces: the PDCP PDUs passed to the RLC, minus the SDUs the RLC drops and
+ *   the RLC PDUs sent to the MAC (retransmissions included, so the estimate
+ *   errs low with RLC AM). The bearers without a local PDCP (fed over X2 in
+ *   dual connectivity) cannot be observed and get the Partition share, which is
+ *   reserved from the pool.
+ *
+ * When a bearer is over its limit, the RLC drops the new SDUs (the RLC SAP has
+ * no flow control towards the PDCP). The limits are rounded down to
+ * multiples of Granularity, so they are not rewritten at every packet.
+ */
+class RlcBufferPool : public Object
+{
+  public:
+    /// How the pool is divided among the bearers
+    enum Policy
+    {
+        PARTITION,
+        SHARED
+    };
+
+    static TypeId GetTypeId()
+    {
+        static TypeId tid =
+            TypeId("ns3::RlcBufferPool")
+                .SetParent<Object>()
+                .AddConstructor<RlcBufferPool>()
+                .AddAttribute("PoolSize",
+                              "Transmit buffer of all the RLC entities of an eNB (bytes)",
+                              UintegerValue(64 * 1024 * 1024),
+                              MakeUintegerAccessor(&RlcBufferPool::m_poolSize),
+                              MakeUintegerChecker<uint64_t>())
+                .AddAttribute("BearerQuota",
+                              "Largest transmit buffer of a single bearer (bytes)",
+                              UintegerValue(20 * 1024 * 1024),
+                              MakeUintegerAccessor(&RlcBufferPool::m_bearerQuota),
+                              MakeUintegerChecker<uint32_t>())
+                .AddAttribute("Policy",
+                              "How the pool is divided among the bearers",
+                              EnumValue(RlcBufferPool::SHARED),
+                              MakeEnumAccessor<Policy>(&RlcBufferPool::m_policy),
+                              MakeEnumChecker(RlcBufferPool::PARTITION,
+                                              "Partition",
+                                              RlcBufferPool::SHARED,
+                                              "Shared"))
+                .AddAttribute("Granularity",
+                              "The limits are rounded down to multiples of this (bytes)",
+                              UintegerValue(64 * 1024),
+                              MakeUintegerAccessor(&RlcBufferPool::m_granularity),
+                              MakeUintegerChecker<uint32_t>(1))
+                .AddAttribute("ScanInterval",
+                              "Interval between the scans for new and released bearers",
+                              TimeValue(MilliSeconds(100)),
+                              MakeTimeAccessor(&RlcBufferPool::m_scanInterval),
+                              MakeTimeChecker());
+        return tid;
+    }
+
+    RlcBufferPool() = default;
+
+    /// Start the scans of the bearers
+    void Start()
+    {
+        Scan();
+    }
+
+    /**
+     * Write, for every eNB, the bearers, the limits and the peak occupancy
+     * \param filename the output file
+     */
+    void Print(std::string filename) const
+    {
+        std::ofstream out(filename.c_str(), std::ios_base::out | std::ios_base::trunc);
+        out << "# policy " << (m_policy == PARTITION ? "Partition" : "Shared") << ", pool "
+            << m_poolSize << " B, bearer quota " << m_bearerQuota << " B" << std::endl;
+        out << "enb\tbearers\tpeakBearers\tpeakOccupancy(B)\tdrops\tdroppedBytes" << std::endl;
+        for (const auto& e : m_enbs)
+        {
+            const Enb& enb = e.second;
+            out << e.first << "\t" << enb.bearers.size() << "\t" << enb.peakBearers << "\t"
+                << enb.peakOccupancy << "\t" << enb.drops << "\t" << enb.droppedBytes
+                << std::endl;
+        }
+    }
+
+  protected:
+    void DoDispose() override
+    {
+        m_scanEvent.Cancel();
+        m_enbs.clear();
+        Object::DoDispose();
+    }
+
+  private:
+    /// An RLC entity of an eNB
+    struct Bearer
+    {
+        Ptr<LteRlc> rlc;
+        Ptr<Object> pdcp;     //!< null if the PDCP is not local
+        bool observed{false}; //!< the PDCP is local
+        Callback<void, uint16_t, uint8_t, uint32_t> pdcpTxPdu;
+        Callback<void, uint16_t, uint8_t, uint32_t> rlcTxPdu;
+        Callback<void, Ptr<const Packet>> rlcTxDrop;
+        int64_t occupancy{0}; //!< estimate, bytes
+        uint32_t limit{0};
+        bool seen{false}; //!< found by the last scan
+    };
+
+    /// The bearers of an eNB and the occupancy of its pool
+    struct Enb
+    {
+        std::map<std::string, Bearer> bearers; //!< by config path
+        uint32_t unobserved{0};
+        int64_t occupancy{0};
+        uint64_t peakOccupancy{0};
+        uint32_t peakBearers{0};
+        uint64_t drops{0};
+        uint64_t droppedBytes{0};
+    };
+
+    void Scan()
+    {
+        for (auto& e : m_enbs)
+        {
+            for (auto& b : e.second.bearers)
+            {
+                b.second.seen = false;
+            }
+        }
+        // the bearers terminated at the eNB, then the ones of the secondary cell in dual
+        // connectivity, whose PDCP is at the master eNB
+        AddBearers("/NodeList/*/DeviceList/*/LteEnbRrc/UeMap/*/DataRadioBearerMap/*/LteRlc");
+        AddBearers("/NodeList/*/DeviceList/*/LteEnbRrc/UeMap/*/RlcMap/*/LteRlc");
+
+        for (auto& e : m_enbs)
+        {
+            Enb& enb = e.second;
+            for (auto it = enb.bearers.begin(); it != enb.bearers.end();)
+            {
+                if (it->second.seen)
+                {
+                    ++it;
+                    continue;
+                }
+                Bearer& bearer = it->second;
+                // the entity may outlive the UE context, e.g. during a handover
+                if (bearer.pdcp)
+                {
+                    bearer.pdcp->TraceDisconnectWithoutContext("TxPDU", bearer.pdcpTxPdu);
+                    bearer.rlc->TraceDisconnectWithoutContext("TxPDU", bearer.rlcTxPdu);
+                }
+                bearer.rlc->TraceDisconnectWithoutContext("TxDrop", bearer.rlcTxDrop);
+                enb.occupancy -= bearer.occupancy;
+                enb.unobserved -= !bearer.observed;
+                it = enb.bearers.erase(it);
+            }
+            enb.peakBearers = std::max<uint32_t>(enb.peakBearers, enb.bearers.size());
+            for (auto& b : enb.bearers)
+            {
+                UpdateLimit(enb, b.second);
+            }
+        }
+        m_scanEvent = Simulator::Schedule(m_scanInterval, &RlcBufferPool::Scan, this);
+    }
+
+    void AddBearers(std::string rlcPath)
+    {
+        Config::MatchContainer matches = Config::LookupMatches(rlcPath);
+        for (uint32_t i = 0; i < matches.GetN(); ++i)
+        {
+            std::string path = matches.GetMatchedPath(i);
+            std::string enbKey = path.substr(0, path.find("/LteEnbRrc"));
+            Enb& enb = m_enbs[enbKey];
+            auto it = enb.bearers.find(path);
+            if (it != enb.bearers.end())
+            {
+                it->second.seen = true;
+                continue;
+            }
+            Bearer& bearer = enb.bearers[path];
+            bearer.seen = true;
+            bearer.rlc = DynamicCast<LteRlc>(matches.Get(i));
+            if (!bearer.rlc)
+            {
+                enb.bearers.erase(path);
+                continue;
+            }
+            Config::MatchContainer pdcp =
+                Config::LookupMatches(path.substr(0, path.rfind('/')) + "/LtePdcp");
+            if (pdcp.GetN() > 0)
+            {
+                bearer.observed = true;
+                bearer.pdcp = pdcp.Get(0);
+                bearer.pdcpTxPdu =
+                    MakeBoundCallback(&RlcBufferPool::PdcpTxPdu, this, &enb, &bearer);
+                bearer.rlcTxPdu = MakeBoundCallback(&RlcBufferPool::RlcTxPdu, this, &enb, &bearer);
+                bearer.pdcp->TraceConnectWithoutContext("TxPDU", bearer.pdcpTxPdu);
+                bearer.rlc->TraceConnectWithoutContext("TxPDU", bearer.rlcTxPdu);
+            }
+            else
+            {
+                ++enb.unobserved;
+            }
+            bearer.rlcTxDrop = MakeBoundCallback(&RlcBufferPool::RlcTxDrop, this, &enb, &bearer);
+            bearer.rlc->TraceConnectWithoutContext("TxDrop", bearer.rlcTxDrop);
+        }
+    }
+
+    /// The Partition share of a bearer of an eNB
+    uint64_t GetShare(const Enb& enb) const
+    {
+        return std::min<uint64_t>(m_bearerQuota,
+                                  m_poolSize / std::max<std::size_t>(enb.bearers.size(), 1));
+    }
+
+    void UpdateLimit(const Enb& enb, Bearer& bearer)
+    {
+        uint64_t limit = GetShare(enb);
+        if (m_policy == SHARED && bearer.observed)
+        {
+            int64_t free = int64_t(m_poolSize) - int64_t(enb.unobserved * limit) - enb.occupancy;
+            limit = std::min<int64_t>(m_bearerQuota,
+                                      std::max<int64_t>(bearer.occupancy + free, 0));
+        }
+        limit -= limit % m_granularity;
+        if (limit != bearer.limit)
+        {
+            bearer.limit = limit;
+            bearer.rlc->SetAttributeFailSafe("MaxTxBufferSize", UintegerValue(limit));
+        }
+    }
+
+    void Occupy(Enb& enb, Bearer& bearer, int64_t bytes)
+    {
+        bytes = std::max(bytes, -bearer.occupancy);
+        bearer.occupancy += bytes;
+        enb.occupancy += bytes;
+        enb.peakOccupancy =
+            std::max<uint64_t>(enb.peakOccupancy, std::max<int64_t>(enb.occupancy, 0));
+    }
+
+    // the PDCP trace is fired before the PDU is passed to the RLC, so the limit
+    // is updated before the RLC checks it
+    static void PdcpTxPdu(RlcBufferPool* pool,
+                          Enb* enb,
+                          Bearer* bearer,
+                          uint16_t rnti,
+                          uint8_t lcid,
+                          uint32_t size)
+    {
+        if (pool->m_policy == SHARED)
+        {
+            pool->UpdateLimit(*enb, *bearer);
+        }
+        pool->Occupy(*enb, *bearer, size);
+    }
+
+    static void RlcTxPdu(RlcBufferPool* pool,
+                         Enb* enb,
+                         Bearer* bearer,
+                         uint16_t rnti,
+                         uint8_t lcid,
+                         uint32_t size)
+    {
+        pool->Occupy(*enb, *bearer, -int64_t(size));
+    }
+
+    static void RlcTxDrop(RlcBufferPool* pool, Enb* enb, Bearer* bearer, Ptr<const Packet> p)
+    {
+        ++enb->drops;
+        enb->droppedBytes += p->GetSize();
+        if (bearer->observed)
+        {
+            pool->Occupy(*enb, *bearer, -int64_t(p->GetSize()));
+        }
+    }
+
+    uint64_t m_poolSize{64 * 1024 * 1024};
+    uint32_t m_bearerQuota{20 * 1024 * 1024};
+    Policy m_policy{SHARED};
+    uint32_t m_granularity{64 * 1024};
+    Time m_scanInterval{MilliSeconds(100)};
+    std::map<std::string, Enb> m_enbs; //!< by the path of the device
+    EventId m_scanEvent;
+};
+
+NS_OBJECT_ENSURE_REGISTERED(RlcBufferPool);
+
+} // namespace ns3
+
+#endif /* RLC_BUFFER_POOL_H */
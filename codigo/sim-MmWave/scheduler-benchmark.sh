@@ -0,0 +1,50 @@
+#!/bin/bash
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License version 2 as
+# published by the Free Software Foundation;
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#
+#  Run Packet5G.cc, outdoor-mmwave.cc and mc-twoenbs.cc with every event
+#  scheduler and report the executed events, the events per second of wall
+#  clock time and the peak memory (maximum resident set size).
+#
+#  Run from the root of an ns-3 tree with the scenarios in scratch/:
+#  $ bash scheduler-benchmark.sh
+#  SIMTIME sets the simulated time of Packet5G and outdoor-mmwave (default 2 s).
+#
+
+SIMTIME=${SIMTIME:-2}
+OUT=${OUT:-scheduler-benchmark.txt}
+SCHEDULERS="Map Heap List Calendar PriorityQueue LadderQueue"
+SCENARIOS=("Packet5G --simTime=$SIMTIME --benchmark=true"
+    "outdoor-mmwave --simTime=$SIMTIME --benchmark=true"
+    "mc-twoenbs --print=false --benchmark=true")
+
+./ns3 build Packet5G outdoor-mmwave mc-twoenbs || exit 1
+
+echo -e "scenario\tscheduler\tevents\twall(s)\tevents/s\tmaxRss(kB)" | tee $OUT
+for scenario in "${SCENARIOS[@]}"; do
+    for scheduler in $SCHEDULERS; do
+        dir=$(mktemp -d)
+        log=$dir/log.txt
+        start=$(date +%s.%N)
+        /usr/bin/time -f "maxRss %M" ./ns3 run --no-build --cwd=$dir \
+            "$scenario --SchedulerType=ns3::${scheduler}Scheduler" > $log 2>&1
+        wall=$(echo "$(date +%s.%N) - $start" | bc)
+        events=$(grep "Events executed:" $log | awk '{ print $3 }')
+        rss=$(grep "maxRss" $log | awk '{ print $2 }')
+        rate=$(echo "scale=0; ${events:-0} / $wall" | bc)
+        echo -e "${scenario%% *}\t$scheduler\t$events\t$wall\t$rate\t$rss" | tee -a $OUT
+        rm -rf $dir
+    done
+done
@@ -0,0 +1,180 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SIMULATION_PROGRESS_REPORTER_H
+#define SIMULATION_PROGRESS_REPORTER_H
+
+#include "ladder-queue-scheduler.h"
+
+#include "ns3/core-module.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <unistd.h>
+
+namespace ns3
+{
+
+/**
+ * Periodic report of the progress of a simulation.
+ *
+ * A sampling event is scheduled at sim-time intervals adapted so that about
+ * one sample is taken every Interval of wall clock time. The event only reads
+ * the simulator state, so it does not change the relative order of the events
+ * of the models. Every sample prints the executed events per second, the
+ * simulated seconds per wall clock second, the estimated time to the end of the
+ * simulation, the resident set size and, with the LadderQueueScheduler, the
+ * number of pending events; the samples are also written to a file.
+ */
+class SimulationProgressReporter : public Object
+{
+  public:
+    static TypeId GetTypeId()
+    {
+        static TypeId tid =
+            TypeId("ns3::SimulationProgressReporter")
+                .SetParent<Object>()
+                .AddConstructor<SimulationProgressReporter>()
+                .AddAttribute("Interval",
+                              "Wall clock time between two samples (s)",
+                              DoubleValue(5.0),
+                              MakeDoubleAccessor(&SimulationProgressReporter::m_interval),
+                              MakeDoubleChecker<double>(0.01))
+                .AddAttribute("FileName",
+                              "File the samples are written to",
+                              StringValue("ProgressStats.txt"),
+                              MakeStringAccessor(&SimulationProgressReporter::m_fileName),
+                              MakeStringChecker());
+        return tid;
+    }
+
+    SimulationProgressReporter() = default;
+
+    /**
+     * Start sampling
+     * \param stopTime the time at which the simulation stops, for the ETA
+     */
+    void Start(Time stopTime)
+    {
+        m_stopTime = stopTime;
+        m_out.open(m_fileName.c_str(), std::ios_base::out | std::ios_base::trunc);
+        m_out << "wall(s)\tsim(s)\tevents\teventsPerSecond\tsimPerWall\tqueue\trss(kB)"
+              << std::endl;
+        m_wallStart = m_lastWall = std::chrono::steady_clock::now();
+        m_lastSim = Simulator::Now();
+        m_lastEvents = Simulator::GetEventCount();
+        // a first short step, to measure the speed of the simulation
+        m_step = MilliSeconds(1);
+        m_event = Simulator::Schedule(m_step, &SimulationProgressReporter::Sample, this);
+    }
+
+  protected:
+    void DoDispose() override
+    {
+        m_event.Cancel();
+        m_out.close();
+        Object::DoDispose();
+    }
+
+  private:
+    /// \return the resident set size, in kB
+    static uint64_t GetRss()
+    {
+        uint64_t pages = 0;
+        uint64_t resident = 0;
+        FILE* statm = std::fopen("/proc/self/statm", "r");
+        if (statm)
+        {
+            if (std::fscanf(statm, "%lu %lu", &pages, &resident) != 2)
+            {
+                resident = 0;
+            }
+            std::fclose(statm);
+        }
+        return resident * sysconf(_SC_PAGESIZE) / 1024;
+    }
+
+    void Sample()
+    {
+        auto wall = std::chrono::steady_clock::now();
+        double wallElapsed = std::chrono::duration<double>(wall - m_lastWall).count();
+        double simElapsed = (Simulator::Now() - m_lastSim).GetSeconds();
+        uint64_t events = Simulator::GetEventCount();
+
+        if (wallElapsed >= m_interval)
+        {
+            double eventsPerSecond = (events - m_lastEvents) / wallElapsed;
+            double simPerWall = simElapsed / wallElapsed;
+            double eta =
+                simPerWall > 0 ? (m_stopTime - Simulator::Now()).GetSeconds() / simPerWall : 0;
+            LadderQueueScheduler* scheduler = LadderQueueScheduler::GetInstance();
+            int64_t queue = scheduler ? int64_t(scheduler->GetSize()) : -1;
+            uint64_t rss = GetRss();
+            double total = std::chrono::duration<double>(wall - m_wallStart).count();
+
+            m_out << total << "\t" << Simulator::Now().GetSeconds() << "\t" << events << "\t"
+                  << eventsPerSecond << "\t" << simPerWall << "\t" << queue << "\t" << rss
+                  << std::endl;
+            std::cout << std::fixed << std::setprecision(3) << "[progress] sim "
+                      << Simulator::Now().GetSeconds() << "/" << m_stopTime.GetSeconds()
+                      << " s, " << std::setprecision(0) << eventsPerSecond << " events/s, "
+                      << std::setprecision(4) << simPerWall << " sim-s/wall-s, ETA "
+                      << std::setprecision(0) << eta << " s, RSS " << rss / 1024 << " MB";
+            if (queue >= 0)
+            {
+                std::cout << ", queue " << queue;
+            }
+            std::cout << std::defaultfloat << std::endl;
+
+            m_lastWall = wall;
+            m_lastSim = Simulator::Now();
+            m_lastEvents = events;
+            // a few samples per interval, at the pace of the last one
+            m_step = Seconds(std::max(simElapsed / 4, 1e-6));
+        }
+        else if (simElapsed > 0 && wallElapsed > 0)
+        {
+            // the sim time expected to take the remaining part of the interval
+            double remaining = m_interval - wallElapsed;
+            m_step = Seconds(std::max(simElapsed * remaining / wallElapsed, 1e-6));
+        }
+        else
+        {
+            m_step = m_step * 2;
+        }
+        m_event = Simulator::Schedule(m_step, &SimulationProgressReporter::Sample, this);
+    }
+
+    double m_interval{5.0};
+    std::string m_fileName{"ProgressStats.txt"};
+    std::ofstream m_out;
+    Time m_stopTime;
+    Time m_step;
+    EventId m_event;
+    std::chrono::steady_clock::time_point m_wallStart;
+    std::chrono::steady_clock::time_point m_lastWall;
+    Time m_lastSim;
+    uint64_t m_lastEvents{0};
+};
+
+NS_OBJECT_ENSURE_REGISTERED(SimulationProgressReporter);
+
+} // namespace ns3
+
+#endif /* SIMULATION_PROGRESS_REPORTER_H */
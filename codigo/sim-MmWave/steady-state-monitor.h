@@ -0,0 +1,472 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef STEADY_STATE_MONITOR_H
+#define STEADY_STATE_MONITOR_H
+
+#include "ns3/applications-module.h"
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * Online estimator of the steady-state mean of an output sequence.
+ *
+ * The observations are averaged in batches of 5 and the warm-up is truncated
+ * with the MSER-5 rule (K. P. White, "An effective truncation heuristic for bias
+ * reduction in simulation output", Simulation 1997): the truncation point is the
+ * one minimizing the squared standard error of the mean of the remaining batch
+ * means, searched in the first half of the sequence. The remaining sequence is
+ * grouped into a fixed number of batches, whose means give the confidence
+ * interval. When the sequence becomes long, adjacent batches are merged, so the
+ * memory stays bounded.
+ */
+class SteadyStateEstimator
+{
+  public:
+    /// The estimate of the mean
+    struct Estimate
+    {
+        bool valid{false};        //!< false if the warm-up has not ended yet
+        double truncated{0};      //!< observations dropped as warm-up
+        double mean{0};
+        double halfWidth{0};      //!< of the confidence interval
+        uint64_t observations{0}; //!< in total
+    };
+
+    void Add(double x)
+    {
+        ++m_observations;
+        m_sum += x;
+        if (++m_count < m_batchSize)
+        {
+            return;
+        }
+        m_batches.push_back(m_sum / m_count);
+        m_sum = 0;
+        m_count = 0;
+        if (m_batches.size() == MAX_BATCHES)
+        {
+            for (std::size_t i = 0; i < MAX_BATCHES / 2; ++i)
+            {
+                m_batches[i] = (m_batches[2 * i] + m_batches[2 * i + 1]) / 2;
+            }
+            m_batches.resize(MAX_BATCHES / 2);
+            m_batchSize *= 2;
+        }
+    }
+
+    uint64_t GetObservations() const
+    {
+        return m_observations;
+    }
+
+    /**
+     * \param nBatches number of batches of the confidence interval
+     * \param confidence level of the confidence interval
+     * \return the estimate of the steady-state mean
+     */
+    Estimate GetEstimate(uint32_t nBatches, double confidence) const
+    {
+        Estimate estimate;
+        estimate.observations = m_observations;
+        std::size_t n = m_batches.size();
+        if (n < 2 * nBatches)
+        {
+            return estimate;
+        }
+
+        // suffix sums, for the MSER statistic of every truncation point
+        std::vector<double> sum(n + 1, 0);
+        std::vector<double> sumSq(n + 1, 0);
+        for (std::size_t i = n; i-- > 0;)
+        {
+            sum[i] = sum[i + 1] + m_batches[i];
+            sumSq[i] = sumSq[i + 1] + m_batches[i] * m_batches[i];
+        }
+        std::size_t best = 0;
+        double bestMser = std::numeric_limits<double>::max();
+        for (std::size_t d = 0; d <= n / 2; ++d)
+        {
+            double m = n - d;
+            double sse = std::max(sumSq[d] - sum[d] * sum[d] / m, 0.0);
+            if (sse / (m * m) < bestMser)
+            {
+                bestMser = sse / (m * m);
+                best = d;
+            }
+        }
+        // a minimum at the end of the search range means the warm-up is still going on
+        if (best == n / 2 || n - best < nBatches)
+        {
+            return estimate;
+        }
+
+        std::size_t length = (n - best) / nBatches;
+        std::size_t first = n - length * nBatches;
+        double mean = 0;
+        std::vector<double> means(nBatches, 0);
+        for (uint32_t b = 0; b < nBatches; ++b)
+        {
+            for (std::size_t i = 0; i < length; ++i)
+            {
+                means[b] += m_batches[first + b * length + i];
+            }
+            means[b] /= length;
+            mean += means[b];
+        }
+        mean /= nBatches;
+        double var = 0;
+        for (double m : means)
+        {
+            var += (m - mean) * (m - mean);
+        }
+        var /= nBatches - 1;
+
+        estimate.valid = true;
+        estimate.truncated = double(first) * m_batchSize;
+        estimate.mean = mean;
+        estimate.halfWidth =
+            GetStudentQuantile(confidence, nBatches - 1) * std::sqrt(var / nBatches);
+        return estimate;
+    }
+
+    /**
+     * Two-sided quantile of the Student t distribution, from the normal quantile
+     * (Abramowitz and Stegun 26.2.23) and the Cornish-Fisher expansion
+     * \param confidence the confidence level
+     * \param dof the degrees of freedom
+     * \return the quantile
+     */
+    static double GetStudentQuantile(double confidence, uint32_t dof)
+    {
+        double q = (1 - confidence) / 2;
+        double t = std::sqrt(-2 * std::log(q));
+        double z = t - (2.515517 + 0.802853 * t + 0.010328 * t * t) /
+                           (1 + 1.432788 * t + 0.189269 * t * t + 0.001308 * t * t * t);
+        double v = dof;
+        double z3 = z * z * z;
+        double z5 = z3 * z * z;
+        double z7 = z5 * z * z;
+        return z + (z3 + z) / (4 * v) + (5 * z5 + 16 * z3 + 3 * z) / (96 * v * v) +
+               (3 * z7 + 19 * z5 + 17 * z3 - 15 * z) / (384 * v * v * v);
+    }
+
+  private:
+    static constexpr std::size_t MAX_BATCHES = 4096;
+
+    std::vector<double> m_batches; //!< means of m_batchSize observations
+    std::size_t m_batchSize{5};
+    double m_sum{0};
+    std::size_t m_count{0};
+    uint64_t m_observations{0};
+};
+
+/**
+ * Stops the simulation once the per-flow statistics have converged.
+ *
+ * Every flow is a PacketSink receiving the packets of a UdpClient. The received
+ * throughput and the mean delay (from the SeqTsHeader timestamp) of each flow
+ * are sampled every Window and fed to a SteadyStateEstimator. Every
+ * CheckInterval, after MinTime, the confidence intervals are computed, and the
+ * simulation is stopped when the half width of all of them is at most
+ * RelativePrecision times the mean or at most AbsolutePrecision: the absolute
+ * test is the one that applies to a metric whose mean is zero or close to it,
+ * where a relative width is meaningless. Flows that did not receive any packet
+ * yet are skipped, since a sink with no traffic (e.g. a UE without uplink) would
+ * otherwise keep the simulation running until its end. The delay is skipped for
+ * the flows that received no timestamp and for the ones whose steady-state
+ * throughput is zero within AbsolutePrecision, e.g. a sink that only got a few
+ * stray packets during the warm-up, whose delay sequence never converges. The achieved precision is
+ * written to FileName.
+ */
+class SteadyStateMonitor : public Object
+{
+  public:
+    static TypeId GetTypeId()
+    {
+        static TypeId tid =
+            TypeId("ns3::SteadyStateMonitor")
+                .SetParent<Object>()
+                .AddConstructor<SteadyStateMonitor>()
+                .AddAttribute("Window",
+                              "Period of the throughput and delay observations",
+                              TimeValue(MilliSeconds(20)),
+                              MakeTimeAccessor(&SteadyStateMonitor::m_window),
+                              MakeTimeChecker())
+                .AddAttribute("CheckInterval",
+                              "Period of the convergence test",
+                              TimeValue(Seconds(1)),
+                              MakeTimeAccessor(&SteadyStateMonitor::m_checkInterval),
+                              MakeTimeChecker())
+                .AddAttribute("MinTime",
+                              "The simulation is never stopped before this time",
+                              TimeValue(Seconds(2)),
+                              MakeTimeAccessor(&SteadyStateMonitor::m_minTime),
+                              MakeTimeChecker())
+                .AddAttribute("RelativePrecision",
+                              "Target half width of the confidence intervals, relative to "
+                              "the mean",
+                              DoubleValue(0.05),
+                              MakeDoubleAccessor(&SteadyStateMonitor::m_precision),
+                              MakeDoubleChecker<double>(0.0))
+                .AddAttribute("AbsolutePrecision",
+                              "Target half width of the confidence intervals, in the units of "
+                              "the metric (Mb/s or ms), for the metrics with a mean close to zero",
+                              DoubleValue(0.01),
+                              MakeDoubleAccessor(&SteadyStateMonitor::m_absolutePrecision),
+                              MakeDoubleChecker<double>(0.0))
+                .AddAttribute("Confidence",
+                              "Level of the confidence intervals",
+                              DoubleValue(0.95),
+                              MakeDoubleAccessor(&SteadyStateMonitor::m_confidence),
+                              MakeDoubleChecker<double>(0.5, 0.999))
+                .AddAttribute("NumBatches",
+                              "Number of batch means of the confidence intervals",
+                              UintegerValue(10),
+                              MakeUintegerAccessor(&SteadyStateMonitor::m_nBatches),
+                              MakeUintegerChecker<uint32_t>(2))
+                .AddAttribute("FileName",
+                              "File the achieved precision is written to",
+                              StringValue("SteadyStateStats.txt"),
+                              MakeStringAccessor(&SteadyStateMonitor::m_fileName),
+                              MakeStringChecker());
+        return tid;
+    }
+
+    SteadyStateMonitor() = default;
+
+    /**
+     * Monitor the packets received by the PacketSink instances of a container
+     * \param apps the applications, the ones that are not a PacketSink are skipped
+     */
+    void AddFlows(const ApplicationContainer& apps)
+    {
+        for (uint32_t i = 0; i < apps.GetN(); ++i)
+        {
+            Ptr<PacketSink> sink = DynamicCast<PacketSink>(apps.Get(i));
+            if (!sink)
+            {
+                continue;
+            }
+            uint32_t flow = m_flows.size();
+            m_flows.emplace_back();
+            m_flows.back().node = sink->GetNode()->GetId();
+            sink->TraceConnectWithoutContext(
+                "Rx",
+                MakeBoundCallback(&SteadyStateMonitor::RxCallback, this, flow));
+        }
+    }
+
+    /// Start the observations and the convergence tests
+    void Start()
+    {
+        m_sampleEvent = Simulator::Schedule(m_window, &SteadyStateMonitor::Sample, this);
+        m_checkEvent = Simulator::Schedule(std::max(m_minTime, m_checkInterval),
+                                           &SteadyStateMonitor::Check,
+                                           this);
+    }
+
+    /**
+     * \return true if the simulation was stopped because the statistics converged
+     */
+    bool HasConverged() const
+    {
+        return m_converged;
+    }
+
+    /// Write the estimates of every flow
+    void Print() const
+    {
+        std::ofstream out(m_fileName.c_str(), std::ios_base::out | std::ios_base::trunc);
+        out << "# " << (m_converged ? "converged" : "not converged") << " at "
+            << Simulator::Now().GetSeconds() << " s, target relative half width " << m_precision
+            << " or half width " << m_absolutePrecision << ", confidence " << m_confidence
+            << std::endl;
+        out << "flow\tnode\tmetric\tobservations\twarmUp(s)\tmean\thalfWidth\trelative"
+            << std::endl;
+        for (uint32_t f = 0; f < m_flows.size(); ++f)
+        {
+            const char* names[2] = {"throughput(Mb/s)", "delay(ms)"};
+            const SteadyStateEstimator* estimators[2] = {&m_flows[f].throughput,
+                                                         &m_flows[f].delay};
+            for (uint32_t m = 0; m < 2; ++m)
+            {
+                SteadyStateEstimator::Estimate e =
+                    estimators[m]->GetEstimate(m_nBatches, m_confidence);
+                out << f << "\t" << m_flows[f].node << "\t" << names[m] << "\t"
+                    << e.observations << "\t";
+                if (m_flows[f].totalBytes == 0)
+                {
+                    out << "-\t-\t-\tempty" << std::endl;
+                }
+                else if (e.valid)
+                {
+                    out << e.truncated * m_window.GetSeconds() << "\t" << e.mean << "\t"
+                        << e.halfWidth << "\t" << GetRelativeWidth(e) << std::endl;
+                }
+                else
+                {
+                    out << "-\t-\t-\t-" << std::endl;
+                }
+            }
+        }
+    }
+
+  protected:
+    void DoDispose() override
+    {
+        m_sampleEvent.Cancel();
+        m_checkEvent.Cancel();
+        Object::DoDispose();
+    }
+
+  private:
+    struct Flow
+    {
+        uint32_t node{0};
+        uint64_t totalBytes{0};
+        uint64_t bytes{0};   //!< in the current window
+        uint32_t packets{0}; //!< with a timestamp, in the current window
+        double delaySum{0};  //!< in the current window, ms
+        SteadyStateEstimator throughput;
+        SteadyStateEstimator delay;
+    };
+
+    static void RxCallback(SteadyStateMonitor* monitor,
+                           uint32_t flow,
+                           Ptr<const Packet> packet,
+                           const Address& from)
+    {
+        Flow& f = monitor->m_flows[flow];
+        f.bytes += packet->GetSize();
+        f.totalBytes += packet->GetSize();
+        SeqTsHeader seqTs;
+        if (packet->GetSize() >= seqTs.GetSerializedSize() && packet->PeekHeader(seqTs))
+        {
+            ++f.packets;
+            f.delaySum += (Simulator::Now() - seqTs.GetTs()).GetSeconds() * 1e3;
+        }
+    }
+
+    /// Half width relative to the mean, infinite for a zero mean with a nonzero width
+    static double GetRelativeWidth(const SteadyStateEstimator::Estimate& e)
+    {
+        if (e.halfWidth == 0)
+        {
+            return 0;
+        }
+        return e.mean != 0 ? e.halfWidth / std::abs(e.mean) : std::numeric_limits<double>::max();
+    }
+
+    void Sample()
+    {
+        for (Flow& f : m_flows)
+        {
+            f.throughput.Add(f.bytes * 8 / m_window.GetSeconds() / 1e6);
+            if (f.packets > 0)
+            {
+                f.delay.Add(f.delaySum / f.packets);
+            }
+            f.bytes = 0;
+            f.packets = 0;
+            f.delaySum = 0;
+        }
+        m_sampleEvent = Simulator::Schedule(m_window, &SteadyStateMonitor::Sample, this);
+    }
+
+    void Check()
+    {
+        bool converged = true;
+        uint32_t checked = 0;
+        double worst = 0;
+        for (const Flow& f : m_flows)
+        {
+            if (f.totalBytes == 0)
+            {
+                continue;
+            }
+            ++checked;
+            SteadyStateEstimator::Estimate throughput =
+                f.throughput.GetEstimate(m_nBatches, m_confidence);
+            // a flow without steady-state traffic (e.g. a few stray packets during the
+            // warm-up) has no steady-state delay
+            bool idle = throughput.valid &&
+                        std::abs(throughput.mean) + throughput.halfWidth <= m_absolutePrecision;
+            for (const SteadyStateEstimator* estimator : {&f.throughput, &f.delay})
+            {
+                if (estimator == &f.delay && (idle || estimator->GetObservations() == 0))
+                {
+                    continue;
+                }
+                SteadyStateEstimator::Estimate e =
+                    estimator == &f.throughput ? throughput
+                                               : estimator->GetEstimate(m_nBatches, m_confidence);
+                if (!e.valid)
+                {
+                    worst = std::numeric_limits<double>::max();
+                    converged = false;
+                    continue;
+                }
+                if (e.halfWidth <= m_absolutePrecision)
+                {
+                    continue;
+                }
+                double relative = GetRelativeWidth(e);
+                worst = std::max(worst, relative);
+                converged = converged && relative <= m_precision;
+            }
+        }
+        converged = converged && checked > 0;
+        if (converged)
+        {
+            std::cout << "Steady state reached at " << Simulator::Now().GetSeconds()
+                      << " s, worst relative half width " << worst << std::endl;
+            m_converged = true;
+            Simulator::Stop();
+            return;
+        }
+        m_checkEvent = Simulator::Schedule(m_checkInterval, &SteadyStateMonitor::Check, this);
+    }
+
+    Time m_window{MilliSeconds(20)};
+    Time m_checkInterval{Seconds(1)};
+    Time m_minTime{Seconds(2)};
+    double m_precision{0.05};
+    double m_absolutePrecision{0.01};
+    double m_confidence{0.95};
+    uint32_t m_nBatches{10};
+    std::string m_fileName{"SteadyStateStats.txt"};
+    std::vector<Flow> m_flows;
+    EventId m_sampleEvent;
+    EventId m_checkEvent;
+    bool m_converged{false};
+};
+
+NS_OBJECT_ENSURE_REGISTERED(SteadyStateMonitor);
+
+} // namespace ns3
+
+#endif /* STEADY_STATE_MONITOR_H */
@@ -0,0 +1,184 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TABULATED_ANTENNA_MODEL_H
+#define TABULATED_ANTENNA_MODEL_H
+
+#include "ns3/antenna-model.h"
+#include "ns3/core-module.h"
+#include "ns3/three-gpp-antenna-model.h"
+
+#include <cmath>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * Antenna element whose gain is read from a table.
+ *
+ * The gain of the wrapped element (by default a ThreeGppAntennaModel) is
+ * sampled once over a regular azimuth/inclination grid, and queries are
+ * answered by bilinear interpolation of the dB values. The azimuth wraps
+ * around at +/-180 degrees. With the 3GPP pattern a resolution of 1 degree
+ * keeps the error well below 0.1 dB, see GetMaxAbsError ().
+ *
+ * A single instance can be shared by all the arrays, as done by
+ * Config::SetDefault ("ns3::PhasedArrayModel::AntennaElement", ...). The table
+ * is built when the object is constructed and again by each setter, so that
+ * GetGainDb only reads it and may be called from several threads.
+ */
+class TabulatedAntennaModel : public AntennaModel
+{
+  public:
+    static TypeId GetTypeId()
+    {
+        static TypeId tid =
+            TypeId("ns3::TabulatedAntennaModel")
+                .SetParent<AntennaModel>()
+                .AddConstructor<TabulatedAntennaModel>()
+                .AddAttribute("Element",
+                              "The antenna element being tabulated. If not set, a "
+                              "ThreeGppAntennaModel is used",
+                              PointerValue(),
+                              MakePointerAccessor(&TabulatedAntennaModel::SetElement,
+                                                  &TabulatedAntennaModel::GetElement),
+                              MakePointerChecker<AntennaModel>())
+                .AddAttribute("Resolution",
+                              "Step (degrees) of the azimuth and inclination grid",
+                              DoubleValue(1.0),
+                              MakeDoubleAccessor(&TabulatedAntennaModel::SetResolution,
+                                                 &TabulatedAntennaModel::GetResolution),
+                              MakeDoubleChecker<double>(0.1, 90.0));
+        return tid;
+    }
+
+    TabulatedAntennaModel() = default;
+
+    void SetElement(Ptr<AntennaModel> element)
+    {
+        m_element = element;
+        if (m_constructed)
+        {
+            BuildTable();
+        }
+    }
+
+    Ptr<AntennaModel> GetElement() const
+    {
+        return m_element;
+    }
+
+    void SetResolution(double degrees)
+    {
+        m_resolutionDeg = degrees;
+        if (m_constructed)
+        {
+            BuildTable();
+        }
+    }
+
+    double GetResolution() const
+    {
+        return m_resolutionDeg;
+    }
+
+    double GetGainDb(Angles a) override
+    {
+        // azimuth in [-pi, pi), inclination in [0, pi]
+        double x = (a.GetAzimuth() + M_PI) / m_stepAz;
+        double y = std::min(std::max(a.GetInclination() / m_stepInc, 0.0), double(m_nInc - 1));
+        double xFloor = std::floor(x);
+        double yFloor = std::floor(y);
+        double wx = x - xFloor;
+        double wy = y - yFloor;
+        uint32_t i0 = (int64_t(xFloor) % m_nAz + m_nAz) % m_nAz;
+        uint32_t i1 = (i0 + 1) % m_nAz;
+        uint32_t j0 = yFloor;
+        uint32_t j1 = std::min(j0 + 1, m_nInc - 1);
+
+        double g00 = m_gainDb[i0 * m_nInc + j0];
+        double g01 = m_gainDb[i0 * m_nInc + j1];
+        double g10 = m_gainDb[i1 * m_nInc + j0];
+        double g11 = m_gainDb[i1 * m_nInc + j1];
+        return (1 - wx) * ((1 - wy) * g00 + wy * g01) + wx * ((1 - wy) * g10 + wy * g11);
+    }
+
+    /**
+     * Compare the table with the wrapped element on random directions
+     * \param nSamples number of directions
+     * \return the largest absolute difference, in dB
+     */
+    double GetMaxAbsError(uint32_t nSamples)
+    {
+        Ptr<UniformRandomVariable> u = CreateObject<UniformRandomVariable>();
+        double maxErr = 0.0;
+        for (uint32_t k = 0; k < nSamples; ++k)
+        {
+            Angles a(u->GetValue(-M_PI, M_PI), u->GetValue(0, M_PI));
+            maxErr = std::max(maxErr, std::abs(GetGainDb(a) - m_element->GetGainDb(a)));
+        }
+        return maxErr;
+    }
+
+  protected:
+    void NotifyConstructionCompleted() override
+    {
+        AntennaModel::NotifyConstructionCompleted();
+        m_constructed = true;
+        BuildTable();
+    }
+
+  private:
+    void BuildTable()
+    {
+        if (!m_element)
+        {
+            m_element = CreateObject<ThreeGppAntennaModel>();
+        }
+        double step = m_resolutionDeg * M_PI / 180.0;
+        // the grid must cover the sphere exactly, so the steps are rounded to it
+        m_nAz = std::max<uint32_t>(std::lround(2 * M_PI / step), 2);
+        m_stepAz = 2 * M_PI / m_nAz;
+        m_nInc = std::max<uint32_t>(std::lround(M_PI / step), 1) + 1;
+        m_stepInc = M_PI / (m_nInc - 1);
+
+        m_gainDb.assign(m_nAz * m_nInc, 0.0);
+        for (uint32_t i = 0; i < m_nAz; ++i)
+        {
+            for (uint32_t j = 0; j < m_nInc; ++j)
+            {
+                m_gainDb[i * m_nInc + j] =
+                    m_element->GetGainDb(Angles(-M_PI + i * m_stepAz, j * m_stepInc));
+            }
+        }
+    }
+
+    Ptr<AntennaModel> m_element;
+    double m_resolutionDeg{1.0};
+    bool m_constructed{false};    //!< the attributes are set: setters rebuild the table
+    double m_stepAz{0.0};         //!< azimuth step (rad)
+    double m_stepInc{0.0};        //!< inclination step (rad)
+    uint32_t m_nAz{0};            //!< azimuth samples in [-pi, pi)
+    uint32_t m_nInc{0};           //!< inclination samples in [0, pi]
+    std::vector<double> m_gainDb; //!< gain (dB), indexed by azimuth * m_nInc + inclination
+};
+
+NS_OBJECT_ENSURE_REGISTERED(TabulatedAntennaModel);
+
+} // namespace ns3
+
+#endif /* TABULATED_ANTENNA_MODEL_H */
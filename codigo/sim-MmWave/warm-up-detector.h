@@ -0,0 +1,198 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef WARM_UP_DETECTOR_H
+#define WARM_UP_DETECTOR_H
+
+#include "ns3/core-module.h"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <functional>
+#include <map>
+
+namespace ns3
+{
+
+/**
+ * Online detection of the end of the warm-up of the multi-connectivity setup.
+ *
+ * The detector listens to the SINR estimates that the mmWave eNBs report to the
+ * LTE coordinator (LteEnbRrc::NotifyMmWaveSinr), one sequence per UE and mmWave
+ * cell. A sequence is stationary when the mean (in dB) of its last Window
+ * reports and the mean of the Window reports before them differ by at most
+ * Tolerance. The warm-up ends, and the callback is called, as soon as all the
+ * sequences seen so far are stationary, after MinTime; if this does not happen
+ * before MaxTime, the warm-up ends at MaxTime.
+ */
+class WarmUpDetector : public Object
+{
+  public:
+    static TypeId GetTypeId()
+    {
+        static TypeId tid =
+            TypeId("ns3::WarmUpDetector")
+                .SetParent<Object>()
+                .AddConstructor<WarmUpDetector>()
+                .AddAttribute("Window",
+                              "Number of reports of each of the two halves of the window",
+                              UintegerValue(10),
+                              MakeUintegerAccessor(&WarmUpDetector::m_window),
+                              MakeUintegerChecker<uint32_t>(1))
+                .AddAttribute("Tolerance",
+                              "Largest difference of the means of the two halves (dB)",
+                              DoubleValue(0.5),
+                              MakeDoubleAccessor(&WarmUpDetector::m_tolerance),
+                              MakeDoubleChecker<double>(0.0))
+                .AddAttribute("MinTime",
+                              "The warm-up never ends before this time",
+                              TimeValue(MilliSeconds(20)),
+                              MakeTimeAccessor(&WarmUpDetector::m_minTime),
+                              MakeTimeChecker())
+                .AddAttribute("MaxTime",
+                              "The warm-up ends at this time at the latest",
+                              TimeValue(Seconds(1)),
+                              MakeTimeAccessor(&WarmUpDetector::m_maxTime),
+                              MakeTimeChecker());
+        return tid;
+    }
+
+    WarmUpDetector() = default;
+
+    /**
+     * Start listening to the SINR reports
+     * \param onStationary called once, at the end of the warm-up
+     */
+    void Start(std::function<void()> onStationary)
+    {
+        m_onStationary = onStationary;
+        Config::ConnectWithoutContextFailSafe(
+            "/NodeList/*/DeviceList/*/LteEnbRrc/NotifyMmWaveSinr",
+            MakeCallback(&WarmUpDetector::NotifySinr, this));
+        m_maxTimeEvent = Simulator::Schedule(m_maxTime, &WarmUpDetector::End, this);
+    }
+
+    /**
+     * \return true if the warm-up has ended
+     */
+    bool HasEnded() const
+    {
+        return m_ended;
+    }
+
+    /**
+     * \return the time at which the warm-up ended
+     */
+    Time GetWarmUpTime() const
+    {
+        return m_warmUpTime;
+    }
+
+  protected:
+    void DoDispose() override
+    {
+        m_maxTimeEvent.Cancel();
+        m_onStationary = nullptr;
+        Object::DoDispose();
+    }
+
+  private:
+    /// The last reports of one UE and cell
+    struct Sequence
+    {
+        std::deque<double> sinrDb;
+        bool stationary{false};
+    };
+
+    void NotifySinr(uint64_t imsi, uint16_t cellId, long double sinr)
+    {
+        if (m_ended)
+        {
+            return;
+        }
+        Sequence& sequence = m_sequences[(imsi << 16) | cellId];
+        sequence.sinrDb.push_back(10 * std::log10(std::max<double>(sinr, 1e-20)));
+        if (sequence.sinrDb.size() > 2 * m_window)
+        {
+            sequence.sinrDb.pop_front();
+        }
+        sequence.stationary = IsStationary(sequence);
+
+        if (Simulator::Now() < m_minTime)
+        {
+            return;
+        }
+        for (const auto& s : m_sequences)
+        {
+            if (!s.second.stationary)
+            {
+                return;
+            }
+        }
+        // out of the RRC callback, which is not the place to install applications
+        Simulator::ScheduleNow(&WarmUpDetector::End, this);
+        m_ended = true;
+    }
+
+    bool IsStationary(const Sequence& sequence) const
+    {
+        if (sequence.sinrDb.size() < 2 * m_window)
+        {
+            return false;
+        }
+        double older = 0;
+        double newer = 0;
+        for (uint32_t i = 0; i < m_window; ++i)
+        {
+            older += sequence.sinrDb[i];
+            newer += sequence.sinrDb[m_window + i];
+        }
+        return std::abs(newer - older) / m_window <= m_tolerance;
+    }
+
+    void End()
+    {
+        m_maxTimeEvent.Cancel();
+        if (!m_onStationary)
+        {
+            return;
+        }
+        m_ended = true;
+        m_warmUpTime = Simulator::Now();
+        NS_LOG_UNCOND("Warm-up ended at " << m_warmUpTime.GetSeconds() << " s, "
+                                          << m_sequences.size() << " SINR sequences");
+        std::function<void()> onStationary = m_onStationary;
+        m_onStationary = nullptr;
+        onStationary();
+    }
+
+    uint32_t m_window{10};
+    double m_tolerance{0.5};
+    Time m_minTime{MilliSeconds(20)};
+    Time m_maxTime{Seconds(1)};
+    std::function<void()> m_onStationary;
+    std::map<uint64_t, Sequence> m_sequences;
+    bool m_ended{false};
+    Time m_warmUpTime;
+    EventId m_maxTimeEvent;
+};
+
+NS_OBJECT_ENSURE_REGISTERED(WarmUpDetector);
+
+} // namespace ns3
+
+#endif /* WARM_UP_DETECTOR_H */
@@ -0,0 +1,181 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef X2_STATS_COLLECTOR_H
+#define X2_STATS_COLLECTOR_H
+
+#include "ns3/core-module.h"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <tuple>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * Statistics of the X2 messages between the eNBs, aggregated in memory.
+ *
+ * The EPC of the mmWave module logs every X2 PDU received as a text line of
+ * X2Stats.txt (time, source cell, target cell, size, delay and a last column,
+ * 1 for X2-U data and 0 for X2-C control). The collector listens to the same
+ * trace (EpcX2::RxPDU) and, for every Epoch, keeps per source cell, target cell
+ * and message type (data or control) the number of messages, the bytes, the
+ * mean and largest delay and a histogram of the delays, with NumDelayBins bins
+ * of DelayBinWidth (the last one also counts the larger delays). At the end of
+ * every epoch its lines are written and the memory is released.
+ */
+class X2StatsCollector : public Object
+{
+  public:
+    static TypeId GetTypeId()
+    {
+        static TypeId tid =
+            TypeId("ns3::X2StatsCollector")
+                .SetParent<Object>()
+                .AddConstructor<X2StatsCollector>()
+                .AddAttribute("Epoch",
+                              "Aggregation interval",
+                              TimeValue(MilliSeconds(100)),
+                              MakeTimeAccessor(&X2StatsCollector::m_epoch),
+                              MakeTimeChecker(NanoSeconds(1)))
+                .AddAttribute("DelayBinWidth",
+                              "Width of the bins of the delay histogram",
+                              TimeValue(MicroSeconds(100)),
+                              MakeTimeAccessor(&X2StatsCollector::m_binWidth),
+                              MakeTimeChecker(NanoSeconds(1)))
+                .AddAttribute("NumDelayBins",
+                              "Number of bins of the delay histogram",
+                              UintegerValue(50),
+                              MakeUintegerAccessor(&X2StatsCollector::m_nBins),
+                              MakeUintegerChecker<uint32_t>(1))
+                .AddAttribute("FileName",
+                              "File of the aggregated statistics",
+                              StringValue("X2EpochStats.txt"),
+                              MakeStringAccessor(&X2StatsCollector::m_fileName),
+                              MakeStringChecker());
+        return tid;
+    }
+
+    X2StatsCollector() = default;
+
+    /// Open the output and connect to the X2 entities of the eNBs, once they are installed
+    void Start()
+    {
+        m_out.open(m_fileName.c_str(), std::ios_base::out | std::ios_base::trunc);
+        m_out << "# epoch " << m_epoch.GetSeconds() << " s, delay bins of "
+              << m_binWidth.GetMicroSeconds() << " us" << std::endl;
+        m_out << "epochStart(s)\tsourceCellId\ttargetCellId\tisData\tmessages\tbytes"
+                 "\tmeanDelay(us)\tmaxDelay(us)\tdelayHistogram"
+              << std::endl;
+        Config::ConnectWithoutContextFailSafe("/NodeList/*/$ns3::EpcX2/RxPDU",
+                                              MakeCallback(&X2StatsCollector::RxPdu, this));
+        m_epochStart = Simulator::Now();
+        m_epochEvent = Simulator::Schedule(m_epoch, &X2StatsCollector::Flush, this);
+    }
+
+    /// Write the last, partial epoch
+    void Stop()
+    {
+        m_epochEvent.Cancel();
+        Flush();
+        m_epochEvent.Cancel();
+        m_out.close();
+    }
+
+  protected:
+    void DoDispose() override
+    {
+        m_epochEvent.Cancel();
+        Object::DoDispose();
+    }
+
+  private:
+    /// The messages of one link and type in the current epoch
+    struct Aggregate
+    {
+        uint64_t messages{0};
+        uint64_t bytes{0};
+        double delaySumUs{0};
+        uint64_t maxDelayNs{0};
+        std::vector<uint64_t> histogram;
+    };
+
+    /// source cell, target cell, data
+    using Key = std::tuple<uint16_t, uint16_t, bool>;
+
+    void RxPdu(uint16_t sourceCellId,
+               uint16_t targetCellId,
+               uint32_t bytes,
+               uint64_t delayNs,
+               bool isData)
+    {
+        Aggregate& a = m_aggregates[Key(sourceCellId, targetCellId, isData)];
+        if (a.histogram.empty())
+        {
+            a.histogram.resize(m_nBins, 0);
+        }
+        ++a.messages;
+        a.bytes += bytes;
+        a.delaySumUs += delayNs / 1e3;
+        a.maxDelayNs = std::max(a.maxDelayNs, delayNs);
+        uint64_t bin = delayNs / m_binWidth.GetNanoSeconds();
+        ++a.histogram[std::min<uint64_t>(bin, m_nBins - 1)];
+    }
+
+    void Flush()
+    {
+        for (const auto& entry : m_aggregates)
+        {
+            const Aggregate& a = entry.second;
+            m_out << m_epochStart.GetSeconds() << "\t" << std::get<0>(entry.first) << "\t"
+                  << std::get<1>(entry.first) << "\t" << std::get<2>(entry.first) << "\t"
+                  << a.messages << "\t" << a.bytes << "\t" << a.delaySumUs / a.messages << "\t"
+                  << a.maxDelayNs / 1e3 << "\t";
+            // the counts up to the last non-empty bin
+            std::size_t last = a.histogram.size();
+            while (last > 1 && a.histogram[last - 1] == 0)
+            {
+                --last;
+            }
+            for (std::size_t b = 0; b < last; ++b)
+            {
+                m_out << (b > 0 ? "," : "") << a.histogram[b];
+            }
+            m_out << "\n";
+        }
+        m_aggregates.clear();
+        m_epochStart = Simulator::Now();
+        m_epochEvent = Simulator::Schedule(m_epoch, &X2StatsCollector::Flush, this);
+    }
+
+    Time m_epoch{MilliSeconds(100)};
+    Time m_binWidth{MicroSeconds(100)};
+    uint32_t m_nBins{50};
+    std::string m_fileName{"X2EpochStats.txt"};
+    std::ofstream m_out;
+    std::map<Key, Aggregate> m_aggregates;
+    Time m_epochStart;
+    EventId m_epochEvent;
+};
+
+NS_OBJECT_ENSURE_REGISTERED(X2StatsCollector);
+
+} // namespace ns3
+
+#endif /* X2_STATS_COLLECTOR_H */